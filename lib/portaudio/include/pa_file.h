@@ -0,0 +1,125 @@
+#ifndef PA_FILE_H
+#define PA_FILE_H
+
+/*
+ * $Id:
+ * PortAudio Portable Real-Time Audio Library
+ * File host API extensions
+ *
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however, 
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also 
+ * requested that these non-binding requests be included along with the 
+ * license above.
+ */
+
+/** @file
+ *  @ingroup public_header
+ *  @brief File host API extension header file.
+ *
+ * The file host API (paFile) exposes software-only devices that read their capture data from
+ * WAV or raw files and write their playback to files, running on a simulated clock with optional
+ * timing jitter and injected xruns. It is intended for deterministic testing and benchmarking on
+ * machines without audio hardware. Both callback and blocking read/write streams are supported.
+ *
+ * Full duplex streams may combine two file devices, in which case the output device's clock,
+ * jitter and xrun settings apply to the whole stream.
+ *
+ * The host API is only built when PA_USE_FILE is enabled.
+ */
+
+#include "portaudio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Configuration of one file host API device. Initialize with PaFile_InitializeDeviceConfig()
+ before changing fields, so that new fields get sensible defaults.
+*/
+typedef struct PaFileDeviceConfig
+{
+    const char *name;                   /**< device name, default "File Device" */
+    int maxInputChannels;               /**< default 2 */
+    int maxOutputChannels;              /**< default 2 */
+    double defaultSampleRate;           /**< default 44100 */
+
+    /** Frames per host buffer, or 0 (the default) to use the framesPerBuffer passed to
+     Pa_OpenStream(), or failing that the suggested latency. Setting this to a size that differs
+     from the stream's framesPerBuffer exercises PortAudio's buffer adaption. */
+    unsigned long framesPerHostBuffer;
+
+    /** WAV or raw file that capture data is read from, or NULL (the default) for silence. WAV
+     files are recognized by their header, any other file is read as raw interleaved samples in
+     fileSampleFormat with maxInputChannels channels. Channels missing from the file are silent.
+     The file's sample rate is ignored, samples are delivered at the stream's rate. */
+    const char *inputFile;
+    /** File that playback is written to, or NULL (the default) to discard it. Files ending in
+     ".wav" are written as WAV, others as raw interleaved samples. */
+    const char *outputFile;
+    /** Sample format of raw input files and of output files: paFloat32 (the default), paInt32,
+     paInt24 or paInt16. Files are little endian. */
+    PaSampleFormat fileSampleFormat;
+    /** Restarts the input file when it ends if non-zero, otherwise silence follows. Default 0. */
+    int loopInput;
+
+    /** Speed of the simulated clock relative to real time: 1 (the default) paces host buffers in
+     real time, 2 at double speed and 0 runs as fast as possible. Stream time (Pa_GetStreamTime()
+     and PaStreamCallbackTimeInfo) always follows the simulated clock. */
+    double clockRate;
+    /** Delays each host buffer by a random amount of up to this many seconds of real time, without
+     shifting the simulated clock. For blocking streams, a Pa_ReadStream() or Pa_WriteStream()
+     that waits for a host buffer returns up to this much later than the clock allows. Default 0. */
+    double jitterSeconds;
+    /** Probability that each host buffer is dropped, which skips that buffer of capture data,
+     writes a buffer of silence for playback and raises paInputOverflow / paOutputUnderflow
+     (paInputOverflowed / paOutputUnderflowed for blocking streams). The simulated clock keeps
+     running through a dropped buffer, and blocking streams never drop two buffers in a row, since
+     the frames being read or written move to the next one. Default 0. */
+    double xrunProbability;
+    /** Drops every xrunInterval'th host buffer in the same way, or never if 0 (the default). */
+    unsigned long xrunInterval;
+    /** Seed for jitter and xrun injection, so that runs are reproducible. Default 1. */
+    unsigned int randomSeed;
+} PaFileDeviceConfig;
+
+/** Fills config with the defaults described in PaFileDeviceConfig. */
+void PaFile_InitializeDeviceConfig( PaFileDeviceConfig *config );
+
+/** Sets the devices that the file host API exposes, replacing the default of a single full
+ duplex device with the default configuration. The configurations and their strings are copied.
+ Must be called before Pa_Initialize(), returns paInternalError otherwise.
+*/
+PaError PaFile_SetDevices( const PaFileDeviceConfig *configs, int count );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef PA_TRACE_EVENTS_H
+#define PA_TRACE_EVENTS_H
+
+/*
+ * $Id:
+ * PortAudio Portable Real-Time Audio Library
+ * Trace event extensions
+ *
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however, 
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also 
+ * requested that these non-binding requests be included along with the 
+ * license above.
+ */
+
+/** @file
+ *  @ingroup public_header
+ *  @brief Trace event extension header file.
+ *
+ * PortAudio can record binary trace events, for looking at the timing of stream callbacks,
+ * host API waits and xruns alongside events added by the client on a single timeline. Each
+ * thread that adds an event is given its own preallocated ring of fixed size records (a
+ * timestamp, an event id and two integer arguments), so adding an event never locks, allocates
+ * or formats text, and is safe on real-time threads. When a ring is full the oldest events are
+ * overwritten. The events are written out as Chrome trace_event JSON, which can be loaded into
+ * chrome://tracing or Perfetto. Pa_Terminate() writes them to portaudio_trace.json.
+ *
+ * By default up to 16 threads can add events at the same time. A thread's ring is reused by the
+ * next thread after it exits. A thread that finds no free ring on its first event doesn't get
+ * one later, all of its events are dropped, counted in the dump's droppedEvents, and reported
+ * once through PortAudio's debug output.
+ *
+ * The functions are only exported when PortAudio is built with PA_TRACE_EVENTS set to 1 (the
+ * PA_ENABLE_TRACE_EVENTS CMake option, which also defines it for targets linking portaudio),
+ * otherwise they expand to no-ops.
+ */
+
+#include "portaudio.h"
+
+#ifndef PA_TRACE_EVENTS
+#define PA_TRACE_EVENTS (0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Event ids recorded by PortAudio. Clients number their own events from
+ paTraceFirstClientEvent, up to 63.
+*/
+typedef enum PaTraceEventId
+{
+    paTraceCallback = 0,            /**< duration of each stream callback, args: frame count and status flags */
+    paTraceBufferProcessing,        /**< duration of each host buffer's processing, args: host input and output frame count */
+    paTraceHostWait,                /**< time a host API spends waiting for its device, args are host API specific */
+    paTraceXrun,                    /**< instant, args: the stream callback status flags */
+    paTraceFirstClientEvent = 16
+} PaTraceEventId;
+
+#if PA_TRACE_EVENTS
+
+/** Marks the start of a duration event on the calling thread. */
+void PaTrace_BeginEvent( int eventId, long arg0, long arg1 );
+
+/** Marks the end of the duration event most recently begun on the calling thread with the same id. */
+void PaTrace_EndEvent( int eventId, long arg0, long arg1 );
+
+/** Adds an event without a duration, such as an xrun. */
+void PaTrace_AddInstantEvent( int eventId, long arg0, long arg1 );
+
+/** Names an event id in the exported trace. Ids below paTraceFirstClientEvent are named by
+ PortAudio. The string is not copied, so usually only string literals should be passed.
+*/
+void PaTrace_SetEventName( int eventId, const char *name );
+
+/** Names the calling thread in the exported trace. The string is not copied. */
+void PaTrace_SetThreadName( const char *name );
+
+/** Discards the events recorded so far on all threads. */
+void PaTrace_ResetEvents( void );
+
+/** Writes the events recorded since the last reset or dump to fileName as Chrome trace_event
+ JSON, then discards them. Returns paNoError, or paInternalError if the file can't be written.
+ The dump may be taken while other threads are adding events, any records that they overwrite
+ during the dump are left out.
+*/
+PaError PaTrace_DumpEvents( const char *fileName );
+
+#else
+
+#define PaTrace_BeginEvent(eventId,arg0,arg1) /* noop */
+#define PaTrace_EndEvent(eventId,arg0,arg1) /* noop */
+#define PaTrace_AddInstantEvent(eventId,arg0,arg1) /* noop */
+#define PaTrace_SetEventName(eventId,name) /* noop */
+#define PaTrace_SetThreadName(name) /* noop */
+#define PaTrace_ResetEvents() /* noop */
+#define PaTrace_DumpEvents(fileName) (paNoError)
+
+#endif /* PA_TRACE_EVENTS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PA_TRACE_EVENTS_H */
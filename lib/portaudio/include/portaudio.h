@@ -287,7 +287,8 @@ typedef enum PaHostApiTypeId
     paWDMKS=11,
     paJACK=12,
     paWASAPI=13,
-    paAudioScienceHPI=14
+    paAudioScienceHPI=14,
+    paFile=100 /* local addition, see pa_file.h. kept clear of the ids allocated upstream */
 } PaHostApiTypeId;
 
 
@@ -358,6 +359,27 @@ const PaHostApiInfo * Pa_GetHostApiInfo( PaHostApiIndex hostApi );
 PaHostApiIndex Pa_HostApiTypeIdToHostApiIndex( PaHostApiTypeId type );
 
 
+/** Restrict the host APIs that are initialized by Pa_Initialize(). Host APIs
+ that are not listed are skipped entirely, so their devices are never probed.
+ Passing a NULL array or a count of 0 removes the restriction, so that all
+ host APIs compiled into PortAudio are initialized (the default).
+
+ This function must be called while PortAudio is not initialized.
+
+ @param hostApiTypes An array of host API identifiers belonging to the
+ PaHostApiTypeId enumeration.
+
+ @param count The number of elements in hostApiTypes.
+
+ @return paNoError on success, paInternalError if PortAudio is already
+ initialized or paInsufficientMemory if count exceeds the number of filter
+ entries supported.
+
+ @see PaHostApiTypeId
+*/
+PaError Pa_SetHostApiFilter( const PaHostApiTypeId *hostApiTypes, int count );
+
+
 /** Convert a host-API-specific device index to standard PortAudio device index.
  This function may be used in conjunction with the deviceCount field of
  PaHostApiInfo to enumerate all devices for the specified host API.
@@ -648,7 +670,8 @@ typedef void PaStream;
 
  @see Pa_OpenStream, Pa_OpenDefaultStream
  @see paNoFlag, paClipOff, paDitherOff, paNeverDropInput,
-  paPrimeOutputBuffersUsingStreamCallback, paPlatformSpecificFlags
+  paPrimeOutputBuffersUsingStreamCallback, paDitherNoiseShaped,
+  paPlatformSpecificFlags
 */
 typedef unsigned long PaStreamFlags;
 
@@ -684,6 +707,16 @@ typedef unsigned long PaStreamFlags;
 */
 #define   paPrimeOutputBuffersUsingStreamCallback ((PaStreamFlags) 0x00000008)
 
+/** Use noise shaped dither instead of plain triangular dither when converting
+ float output samples to 16 bits. The quantization error of each channel is fed
+ back through a second order filter, which lowers the noise floor at low and mid
+ frequencies at the cost of more noise near the Nyquist frequency. Other output
+ conversions, input, and streams with paDitherOff are unaffected.
+
+ @see PaStreamFlags
+*/
+#define   paDitherNoiseShaped ((PaStreamFlags) 0x00000010)
+
 /** A mask specifying the platform specific bits.
  @see PaStreamFlags
 */
@@ -1122,6 +1155,83 @@ PaTime Pa_GetStreamTime( PaStream *stream );
 double Pa_GetStreamCpuLoad( PaStream* stream );
 
 
+/** The number of buckets in PaStreamCpuLoadStats::histogram.
+*/
+#define paCpuLoadHistogramBucketCount (20)
+
+
+/** CPU load statistics of a callback stream, retrieved with
+ Pa_GetStreamCpuLoadStats(). Loads are measured once per host buffer, and are
+ fractions of the available CPU time as for Pa_GetStreamCpuLoad().
+
+ @see Pa_GetStreamCpuLoadStats, Pa_ResetStreamCpuLoadStats
+*/
+typedef struct PaStreamCpuLoadStats
+{
+    /** The smoothed load, as returned by Pa_GetStreamCpuLoad(). */
+    double averageLoad;
+
+    /** The load of the most recent measurement. */
+    double lastLoad;
+
+    /** The highest load of any measurement since the last reset. Loads above
+     1.0 are likely to have caused a dropout. */
+    double peakLoad;
+
+    /** The number of measurements since the last reset. */
+    unsigned long measurementCount;
+
+    /** The number of measurements with a load above 1.0 since the last reset. */
+    unsigned long overloadCount;
+
+    /** histogram[i] counts the measurements since the last reset with a load of
+     at least i/10 and below (i+1)/10. The last bucket also counts all higher
+     loads. */
+    unsigned long histogram[paCpuLoadHistogramBucketCount];
+} PaStreamCpuLoadStats;
+
+
+/** Retrieve CPU load statistics for the specified stream. This function does not
+ block and may be called from any thread, including the stream callback. The
+ counters are updated by the stream's processing thread, so a snapshot taken while
+ the stream is running may be off by the measurement in progress.
+
+ @param stream A pointer to an open stream previously created with Pa_OpenStream.
+
+ @param stats Receives the statistics. All fields are 0 for a blocking read/write
+ stream.
+
+ @return paNoError on success, paBadBufferPtr if stats is NULL, or an error code
+ if stream is invalid.
+
+ @see Pa_ResetStreamCpuLoadStats, Pa_GetStreamCpuLoad
+*/
+PaError Pa_GetStreamCpuLoadStats( PaStream* stream, PaStreamCpuLoadStats *stats );
+
+
+/** Reset the peak load, the counters and the histogram of the specified stream's
+ CPU load statistics. The smoothed average is not affected. This function does not
+ block and may be called from any thread: the statistics appear reset immediately,
+ the counters are cleared by the stream's processing thread at its next measurement.
+
+ @return paNoError on success, or an error code if stream is invalid.
+
+ @see Pa_GetStreamCpuLoadStats
+*/
+PaError Pa_ResetStreamCpuLoadStats( PaStream* stream );
+
+
+/** Set the time constant, in seconds, of the low pass filter that smooths the value
+ returned by Pa_GetStreamCpuLoad(). The smoothing is independent of the host buffer
+ size. The default is 0.1 seconds. A time constant of 0 (or below) disables
+ smoothing, so that Pa_GetStreamCpuLoad() returns the load of the most recent
+ measurement.
+
+ @return paNoError on success, or an error code if stream is invalid.
+*/
+PaError Pa_SetStreamCpuLoadSmoothing( PaStream* stream, double timeConstant );
+
+
 /** Read samples from an input stream. The function doesn't return until
  the entire buffer has been filled - this may involve waiting for the operating
  system to supply the data.
@@ -44,6 +44,8 @@
 */
 
 
+#include <string.h> /* memset() */
+
 #include "pa_allocation.h"
 #include "pa_util.h"
 
@@ -241,3 +243,63 @@ void PaUtil_FreeAllAllocations( PaUtilAllocationGroup* group )
     }
 }
 
+
+/*
+    The arena is a single block, over-allocated by PA_ALLOCATION_ARENA_ALIGNMENT-1
+    bytes so that its base can be rounded up to the alignment. Reserved sizes are
+    rounded up to the alignment as well, so each block handed out is aligned.
+*/
+
+#define PA_ARENA_ROUND_UP_( x ) \
+    (((x) + (PA_ALLOCATION_ARENA_ALIGNMENT-1)) & ~(size_t)(PA_ALLOCATION_ARENA_ALIGNMENT-1))
+
+
+void PaUtil_InitializeArena( PaUtilAllocationArena* arena )
+{
+    arena->memory = 0;
+    arena->base = 0;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+
+void PaUtil_ReserveArenaMemory( PaUtilAllocationArena* arena, long size )
+{
+    arena->size += (long)PA_ARENA_ROUND_UP_( (size_t)size );
+}
+
+
+int PaUtil_AllocateArena( PaUtilAllocationArena* arena )
+{
+    arena->memory = PaUtil_AllocateMemory( arena->size + (PA_ALLOCATION_ARENA_ALIGNMENT-1) );
+    if( !arena->memory )
+        return 0;
+
+    arena->base = (char*)PA_ARENA_ROUND_UP_( (size_t)arena->memory );
+    arena->used = 0;
+    memset( arena->base, 0, arena->size );
+    return 1;
+}
+
+
+void* PaUtil_ArenaAllocateMemory( PaUtilAllocationArena* arena, long size )
+{
+    long roundedSize = (long)PA_ARENA_ROUND_UP_( (size_t)size );
+    void *result;
+
+    if( !arena->base || arena->used + roundedSize > arena->size )
+        return 0;
+
+    result = arena->base + arena->used;
+    arena->used += roundedSize;
+    return result;
+}
+
+
+void PaUtil_FreeArena( PaUtilAllocationArena* arena )
+{
+    if( arena->memory )
+        PaUtil_FreeMemory( arena->memory );
+
+    PaUtil_InitializeArena( arena );
+}
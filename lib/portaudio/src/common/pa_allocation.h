@@ -53,6 +53,13 @@
 
  The allocation group implementation is built on top of the lower
  level allocation functions defined in pa_util.h
+
+ An allocation arena serves a fixed set of blocks with the same lifetime, such
+ as the buffers of a stream, from a single allocation. The sizes of the blocks
+ are reserved first, then the arena is allocated and the blocks are carved out
+ of it in the order they were reserved. Every block starts on a
+ PA_ALLOCATION_ARENA_ALIGNMENT byte boundary, so that blocks don't share cache
+ lines and SIMD code can use aligned loads and stores on them.
 */
 
 
@@ -98,6 +105,45 @@ void PaUtil_GroupFreeMemory( PaUtilAllocationGroup* group, void *buffer );
 void PaUtil_FreeAllAllocations( PaUtilAllocationGroup* group );
 
 
+/** Alignment of the blocks returned by PaUtil_ArenaAllocateMemory(), in bytes. */
+#define PA_ALLOCATION_ARENA_ALIGNMENT (64)
+
+typedef struct
+{
+    void *memory;   /**< block from PaUtil_AllocateMemory(), NULL until PaUtil_AllocateArena() */
+    char *base;     /**< memory rounded up to PA_ALLOCATION_ARENA_ALIGNMENT */
+    long size;      /**< total of the reserved sizes, each rounded up to the alignment */
+    long used;      /**< bytes handed out by PaUtil_ArenaAllocateMemory() */
+}PaUtilAllocationArena;
+
+
+/** Initialize an empty arena. PaUtil_FreeArena() may be called on it at any
+ time after this.
+*/
+void PaUtil_InitializeArena( PaUtilAllocationArena* arena );
+
+/** Reserve a block of size bytes, to be handed out by PaUtil_ArenaAllocateMemory()
+ once the arena is allocated. Must be called before PaUtil_AllocateArena().
+*/
+void PaUtil_ReserveArenaMemory( PaUtilAllocationArena* arena, long size );
+
+/** Allocate the memory for all reserved blocks, which is zeroed.
+ @return Non-zero on success, 0 if the memory couldn't be allocated.
+*/
+int PaUtil_AllocateArena( PaUtilAllocationArena* arena );
+
+/** Hand out the next block of an allocated arena. Blocks must be requested in
+ the order, and with the sizes, they were reserved in.
+ @return The block, or NULL if it exceeds the reservation.
+*/
+void* PaUtil_ArenaAllocateMemory( PaUtilAllocationArena* arena, long size );
+
+/** Free the arena's memory, invalidating all blocks handed out from it, and
+ return it to the empty state of PaUtil_InitializeArena().
+*/
+void PaUtil_FreeArena( PaUtilAllocationArena* arena );
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -43,6 +43,11 @@
  
  If the C9x function lrintf() is available, define PA_USE_C99_LRINTF to use it
 
+ On x86 and x86-64 targets with SSE2 the most common conversions to and from
+ paFloat32 also have SSE2 and AVX2 versions, which PaUtil_SelectConverter()
+ substitutes for the scalar ones according to the instruction sets the CPU
+ supports at runtime. Define PA_NO_SIMD_CONVERTERS to disable them.
+
  @todo Consider whether functions which dither but don't clip should exist,
  V18 automatically enabled clipping whenever dithering was selected. Perhaps
  we should do the same. 
@@ -66,6 +71,27 @@
 #include "pa_endianness.h"
 #include "pa_types.h"
 
+#if !defined(PA_NO_STANDARD_CONVERTERS) && !defined(PA_NO_SIMD_CONVERTERS) && \
+        ( defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) )
+#define PA_SSE2_CONVERTERS_ 1
+#include <string.h> /* memcpy() */
+#include <emmintrin.h>
+/* AVX2 code is enabled per function, so that the rest of PortAudio does not require AVX2 */
+#if defined(__clang__) || ( defined(__GNUC__) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) ) )
+#define PA_AVX2_CONVERTERS_ 1
+#define PA_AVX2_TARGET_ __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && _MSC_VER >= 1900
+#define PA_AVX2_CONVERTERS_ 1
+#define PA_AVX2_TARGET_
+#endif
+#ifdef PA_AVX2_CONVERTERS_
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h> /* __cpuid(), __cpuidex(), _xgetbv() */
+#endif
+#endif
+#endif
+
 
 PaSampleFormat PaUtil_SelectClosestAvailableFormat(
         PaSampleFormat availableFormats, PaSampleFormat format )
@@ -175,7 +201,7 @@ PaSampleFormat PaUtil_SelectClosestAvailableFormat(
 
 /* -------------------------------------------------------------------------- */
 
-PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
+static PaUtilConverter* SelectTableConverter( PaSampleFormat sourceFormat,
         PaSampleFormat destinationFormat, PaStreamFlags flags )
 {
     PA_SELECT_FORMAT_( sourceFormat,
@@ -329,6 +355,12 @@ static const float const_1_div_32768_ = 1.0f / 32768.f; /* 16 bit multiplier */
 
 static const double const_1_div_2147483648_ = 1.0 / 2147483648.0; /* 32 bit multiplier */
 
+/* The float dither converters fetch their dither for up to PA_DITHER_BLOCK_SIZE_ samples at a
+    time with PaUtil_GenerateFloatTriangularDitherBlock(). */
+#define PA_DITHER_BLOCK_SIZE_ (256)
+#define PA_DITHER_BLOCK_COUNT_( count )\
+    (((count) < PA_DITHER_BLOCK_SIZE_) ? (count) : PA_DITHER_BLOCK_SIZE_)
+
 /* -------------------------------------------------------------------------- */
 
 static void Float32_To_Int32(
@@ -365,23 +397,31 @@ static void Float32_To_Int32_Dither(
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* REVIEW */
+        blockCount = PA_DITHER_BLOCK_COUNT_( count );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i = 0; i < blockCount; ++i )
+        {
+            /* REVIEW */
 #ifdef PA_USE_C99_LRINTF
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = ((float)*src * (2147483646.0f)) + dither;
-        *dest = lrintf(dithered - 0.5f);
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = ((float)*src * (2147483646.0f)) + dither[i];
+            *dest = lrintf(dithered - 0.5f);
 #else
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        *dest = (PaInt32) dithered;
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+            *dest = (PaInt32) dithered;
 #endif
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
     }
 }
 
@@ -423,26 +463,34 @@ static void Float32_To_Int32_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* REVIEW */
+        blockCount = PA_DITHER_BLOCK_COUNT_( count );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i = 0; i < blockCount; ++i )
+        {
+            /* REVIEW */
 #ifdef PA_USE_C99_LRINTF
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = ((float)*src * (2147483646.0f)) + dither;
-        PA_CLIP_( dithered, -2147483648.f, 2147483647.f  );
-        *dest = lrintf(dithered-0.5f);
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = ((float)*src * (2147483646.0f)) + dither[i];
+            PA_CLIP_( dithered, -2147483648.f, 2147483647.f  );
+            *dest = lrintf(dithered-0.5f);
 #else
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
-        *dest = (PaInt32) dithered;
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+            PA_CLIP_( dithered, -2147483648., 2147483647.  );
+            *dest = (PaInt32) dithered;
 #endif
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
     }
 }
 
@@ -490,29 +538,38 @@ static void Float32_To_Int24_Dither(
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert to 32 bit and drop the low 8 bits */
+        blockCount = PA_DITHER_BLOCK_COUNT_( count );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
 
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        
-        temp = (PaInt32) dithered;
+        for( i = 0; i < blockCount; ++i )
+        {
+            /* convert to 32 bit and drop the low 8 bits */
+
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+
+            temp = (PaInt32) dithered;
 
 #if defined(PA_LITTLE_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 8);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 24);
+            dest[0] = (unsigned char)(temp >> 8);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 24);
 #elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 24);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 8);
+            dest[0] = (unsigned char)(temp >> 24);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 8);
 #endif
 
-        src += sourceStride;
-        dest += destinationStride * 3;
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
+
+        count -= blockCount;
     }
 }
 
@@ -561,30 +618,39 @@ static void Float32_To_Int24_DitherClip(
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
-    
-    while( count-- )
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
     {
-        /* convert to 32 bit and drop the low 8 bits */
-        
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
-        
-        temp = (PaInt32) dithered;
+        blockCount = PA_DITHER_BLOCK_COUNT_( count );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i = 0; i < blockCount; ++i )
+        {
+            /* convert to 32 bit and drop the low 8 bits */
+
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+            PA_CLIP_( dithered, -2147483648., 2147483647.  );
+
+            temp = (PaInt32) dithered;
 
 #if defined(PA_LITTLE_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 8);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 24);
+            dest[0] = (unsigned char)(temp >> 8);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 24);
 #elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 24);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 8);
+            dest[0] = (unsigned char)(temp >> 24);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 8);
 #endif
 
-        src += sourceStride;
-        dest += destinationStride * 3;
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
+
+        count -= blockCount;
     }
 }
 
@@ -616,6 +682,61 @@ static void Float32_To_Int16(
 
 /* -------------------------------------------------------------------------- */
 
+/* Noise shaped dither for Float32_To_Int16_Dither and Float32_To_Int16_DitherClip, selected by
+    PaUtil_InitializeNoiseShapedDitherState(). This is the second order error feedback of the
+    musicdsp.org code quoted in pa_dither.c, with the high passed triangular dither above.
+*/
+
+#define PA_NOISE_SHAPING_GAIN_          (0.5f)
+/* the error is normally within +/-3 LSB, anything outside this came from NaN or hugely out of
+    range samples, and is dropped so that it can't poison the feedback of later samples */
+#define PA_NOISE_SHAPING_ERROR_LIMIT_   (8.0f)
+
+static void NoiseShapedFloat32_To_Int16(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator, int clip )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float error1 = ditherGenerator->shapingError1;
+    float error2 = ditherGenerator->shapingError2;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, blockCount;
+
+    while( count > 0 )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i = 0; i < blockCount; ++i )
+        {
+            /* feed back the filtered error of the previous two samples, in units of 1 LSB */
+            float shaped = (*src * (32766.0f)) + PA_NOISE_SHAPING_GAIN_ * (error1 + error1 - error2);
+            PaInt32 samp = (PaInt32) (shaped + dither[i]);
+
+            error2 = error1;
+            error1 = shaped - (float)samp;
+            if( !(error1 > -PA_NOISE_SHAPING_ERROR_LIMIT_ && error1 < PA_NOISE_SHAPING_ERROR_LIMIT_) )
+                error1 = 0.0f;
+
+            if( clip )
+                PA_CLIP_( samp, -0x8000, 0x7FFF );
+            *dest = (PaInt16) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
+    }
+
+    ditherGenerator->shapingError1 = error1;
+    ditherGenerator->shapingError2 = error2;
+}
+
+/* -------------------------------------------------------------------------- */
+
 static void Float32_To_Int16_Dither(
     void *destinationBuffer, signed int destinationStride,
     void *sourceBuffer, signed int sourceStride,
@@ -623,22 +744,37 @@ static void Float32_To_Int16_Dither(
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    if( ditherGenerator->noiseShaping )
     {
+        NoiseShapedFloat32_To_Int16( destinationBuffer, destinationStride,
+                sourceBuffer, sourceStride, count, ditherGenerator, 0 );
+        return;
+    }
 
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (32766.0f)) + dither;
+    while( count > 0 )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i = 0; i < blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (32766.0f)) + dither[i];
 
 #ifdef PA_USE_C99_LRINTF
-        *dest = lrintf(dithered-0.5f);
+            *dest = lrintf(dithered-0.5f);
 #else
-        *dest = (PaInt16) dithered;
+            *dest = (PaInt16) dithered;
 #endif
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
     }
 }
 
@@ -677,24 +813,38 @@ static void Float32_To_Int16_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, blockCount;
 
-    while( count-- )
+    if( ditherGenerator->noiseShaping )
     {
+        NoiseShapedFloat32_To_Int16( destinationBuffer, destinationStride,
+                sourceBuffer, sourceStride, count, ditherGenerator, 1 );
+        return;
+    }
 
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (32766.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        PA_CLIP_( samp, -0x8000, 0x7FFF );
+    while( count > 0 )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( i = 0; i < blockCount; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (32766.0f)) + dither[i];
+            PaInt32 samp = (PaInt32) dithered;
+            PA_CLIP_( samp, -0x8000, 0x7FFF );
 #ifdef PA_USE_C99_LRINTF
-        *dest = lrintf(samp-0.5f);
+            *dest = lrintf(samp-0.5f);
 #else
-        *dest = (PaInt16) samp;
+            *dest = (PaInt16) samp;
 #endif
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= blockCount;
     }
 }
 
@@ -1850,10 +2000,784 @@ PaUtilConverterTable paConverters = {
 
 /* -------------------------------------------------------------------------- */
 
+#ifdef PA_SSE2_CONVERTERS_
+
+/* The SIMD converters below convert between unit stride buffers a vector at a time. Each
+    _Unit function converts count samples, which must be a multiple of the vector width given
+    to PA_SIMD_CONVERTER_. The PaUtilConverter that PA_SIMD_CONVERTER_ wraps around it passes
+    other strides, and the samples left over after the last full vector, on to the scalar
+    converter of the same name. The vector code rounds and clips exactly like the scalar code,
+    so the choice of converter doesn't change the output. The one exception is builds with
+    PA_USE_C99_LRINTF, where samples far enough out of range to overflow lrintf() in the scalar
+    Float32_To_Int32 converters convert to 0x80000000 instead, or clip to full scale.
+*/
+
+#define PA_SIMD_CONVERTER_( name, isa, width, sourceBytes, destinationBytes )\
+    static void name ## _ ## isa(\
+        void *destinationBuffer, signed int destinationStride,\
+        void *sourceBuffer, signed int sourceStride,\
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )\
+    {\
+        if( destinationStride == 1 && sourceStride == 1 )\
+        {\
+            unsigned int vectorCount = count & ~((unsigned int)(width) - 1);\
+            name ## _ ## isa ## _Unit( destinationBuffer, sourceBuffer, vectorCount );\
+            destinationBuffer = (unsigned char*)destinationBuffer + vectorCount * (destinationBytes);\
+            sourceBuffer = (unsigned char*)sourceBuffer + vectorCount * (sourceBytes);\
+            count -= vectorCount;\
+        }\
+        name( destinationBuffer, destinationStride, sourceBuffer, sourceStride, count, ditherGenerator );\
+    }
+
+/* The same for dithering converters, whose _Unit functions take the dither generator. Noise
+    shaped dither is inherently serial and is left to the scalar converter. */
+#define PA_SIMD_DITHER_CONVERTER_( name, isa, width, sourceBytes, destinationBytes )\
+    static void name ## _ ## isa(\
+        void *destinationBuffer, signed int destinationStride,\
+        void *sourceBuffer, signed int sourceStride,\
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )\
+    {\
+        if( destinationStride == 1 && sourceStride == 1 && !ditherGenerator->noiseShaping )\
+        {\
+            unsigned int vectorCount = count & ~((unsigned int)(width) - 1);\
+            name ## _ ## isa ## _Unit( destinationBuffer, sourceBuffer, vectorCount, ditherGenerator );\
+            destinationBuffer = (unsigned char*)destinationBuffer + vectorCount * (destinationBytes);\
+            sourceBuffer = (unsigned char*)sourceBuffer + vectorCount * (sourceBytes);\
+            count -= vectorCount;\
+        }\
+        name( destinationBuffer, destinationStride, sourceBuffer, sourceStride, count, ditherGenerator );\
+    }
+
+/* float to int conversion of the Float32_To_Int32 and Float32_To_Int16 converters */
+#ifdef PA_USE_C99_LRINTF
+#define PA_SSE2_FLOAT_TO_INT_( x )  _mm_cvtps_epi32( _mm_sub_ps( (x), _mm_set1_ps( 0.5f ) ) )
+#define PA_AVX2_FLOAT_TO_INT_( x )  _mm256_cvtps_epi32( _mm256_sub_ps( (x), _mm256_set1_ps( 0.5f ) ) )
+#else
+#define PA_SSE2_FLOAT_TO_INT_( x )  _mm_cvttps_epi32( x )
+#define PA_AVX2_FLOAT_TO_INT_( x )  _mm256_cvttps_epi32( x )
+#endif
+
+/* Clips the conversion of samples scaled by 2^31 to 32 bits. Scaled values below -2^31 already
+    convert to 0x80000000, those at or above 2^31 do too and flipping all bits gives 0x7FFFFFFF. */
+#define PA_SSE2_CLIP_INT32_( converted, scaled )\
+    _mm_xor_si128( (converted), _mm_castps_si128( _mm_cmpge_ps( (scaled), _mm_set1_ps( 2147483648.0f ) ) ) )
+#define PA_AVX2_CLIP_INT32_( converted, scaled )\
+    _mm256_xor_si256( (converted), _mm256_castps_si256( _mm256_cmp_ps( (scaled), _mm256_set1_ps( 2147483648.0f ), _CMP_GE_OQ ) ) )
+
+/* -------------------------------------------------------------------------- */
+
+static void StoreInt24_SSE2( unsigned char *dest, __m128i samples )
+{
+    PaInt32 temp[4];
+    int i;
+
+    _mm_storeu_si128( (__m128i*)temp, samples );
+    for( i = 0; i < 4; ++i )
+    {
+        dest[0] = (unsigned char)(temp[i] >> 8);
+        dest[1] = (unsigned char)(temp[i] >> 16);
+        dest[2] = (unsigned char)(temp[i] >> 24);
+        dest += 3;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static __m128i LoadInt24_SSE2( unsigned char *src )
+{
+    PaInt32 temp[4];
+    int i;
+
+    for( i = 0; i < 4; ++i )
+    {
+        temp[i] = (((PaInt32)src[0]) << 8) | (((PaInt32)src[1]) << 16) | (((PaInt32)src[2]) << 24);
+        src += 3;
+    }
+    return _mm_loadu_si128( (__m128i*)temp );
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int32_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( 2147483648.0f ); /* 0x7FFFFFFF as a float */
+    unsigned int i;
+
+    for( i = 0; i < count; i += 4 )
+    {
+        __m128 scaled = _mm_mul_ps( _mm_loadu_ps( src + i ), scale );
+        _mm_storeu_si128( (__m128i*)(dest + i), PA_SSE2_FLOAT_TO_INT_( scaled ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int32, SSE2, 4, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int32_Clip_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 4 )
+    {
+        __m128 scaled = _mm_mul_ps( _mm_loadu_ps( src + i ), scale );
+        _mm_storeu_si128( (__m128i*)(dest + i), PA_SSE2_CLIP_INT32_( PA_SSE2_FLOAT_TO_INT_( scaled ), scaled ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int32_Clip, SSE2, 4, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int24_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    const __m128d scale = _mm_set1_pd( 2147483647.0 ); /* scaled in double precision, like Float32_To_Int24 */
+    unsigned int i;
+
+    for( i = 0; i < count; i += 4 )
+    {
+        __m128 samples = _mm_loadu_ps( src + i );
+        __m128i low = _mm_cvttpd_epi32( _mm_mul_pd( _mm_cvtps_pd( samples ), scale ) );
+        __m128i high = _mm_cvttpd_epi32( _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( samples, samples ) ), scale ) );
+        StoreInt24_SSE2( dest + i * 3, _mm_unpacklo_epi64( low, high ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int24, SSE2, 4, 4, 3 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int24_Clip_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 4 )
+    {
+        __m128 scaled = _mm_mul_ps( _mm_loadu_ps( src + i ), scale );
+        StoreInt24_SSE2( dest + i * 3, PA_SSE2_CLIP_INT32_( _mm_cvttps_epi32( scaled ), scaled ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int24_Clip, SSE2, 4, 4, 3 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int16_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( 32767.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m128i low = PA_SSE2_FLOAT_TO_INT_( _mm_mul_ps( _mm_loadu_ps( src + i ), scale ) );
+        __m128i high = PA_SSE2_FLOAT_TO_INT_( _mm_mul_ps( _mm_loadu_ps( src + i + 4 ), scale ) );
+        /* keep the low 16 bits like the cast in Float32_To_Int16, so that packing can't saturate */
+        low = _mm_srai_epi32( _mm_slli_epi32( low, 16 ), 16 );
+        high = _mm_srai_epi32( _mm_slli_epi32( high, 16 ), 16 );
+        _mm_storeu_si128( (__m128i*)(dest + i), _mm_packs_epi32( low, high ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int16, SSE2, 8, 4, 2 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int16_Clip_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( 32767.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m128i low = PA_SSE2_FLOAT_TO_INT_( _mm_mul_ps( _mm_loadu_ps( src + i ), scale ) );
+        __m128i high = PA_SSE2_FLOAT_TO_INT_( _mm_mul_ps( _mm_loadu_ps( src + i + 4 ), scale ) );
+        /* packing saturates to -0x8000..0x7FFF */
+        _mm_storeu_si128( (__m128i*)(dest + i), _mm_packs_epi32( low, high ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int16_Clip, SSE2, 8, 4, 2 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Int32_To_Float32_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    /* rounding to float before scaling by a power of two gives the same result as
+        Int32_To_Float32 scaling in double precision before rounding */
+    const __m128 scale = _mm_set1_ps( 1.0f / 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 4 )
+    {
+        __m128i samples = _mm_loadu_si128( (__m128i*)(src + i) );
+        _mm_storeu_ps( dest + i, _mm_mul_ps( _mm_cvtepi32_ps( samples ), scale ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Int32_To_Float32, SSE2, 4, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Int24_To_Float32_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( 1.0f / 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 4 )
+        _mm_storeu_ps( dest + i, _mm_mul_ps( _mm_cvtepi32_ps( LoadInt24_SSE2( src + i * 3 ) ), scale ) );
+}
+
+PA_SIMD_CONVERTER_( Int24_To_Float32, SSE2, 4, 3, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Float32_SSE2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( const_1_div_32768_ );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m128i samples = _mm_loadu_si128( (__m128i*)(src + i) );
+        /* sign extend by unpacking into the high half of each 32 bit lane */
+        __m128i low = _mm_srai_epi32( _mm_unpacklo_epi16( samples, samples ), 16 );
+        __m128i high = _mm_srai_epi32( _mm_unpackhi_epi16( samples, samples ), 16 );
+        _mm_storeu_ps( dest + i, _mm_mul_ps( _mm_cvtepi32_ps( low ), scale ) );
+        _mm_storeu_ps( dest + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( high ), scale ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Int16_To_Float32, SSE2, 8, 2, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef PA_USE_C99_LRINTF
+
+/* The dithering converters fetch a block of dither at a time, PA_DITHER_BLOCK_SIZE_ is a
+    multiple of all vector widths. */
+
+static __m128i DitherClipFloat32_To_Int32_SSE2( __m128 samples, __m128 dither )
+{
+    /* in double precision, like Float32_To_Int32_DitherClip. max and min return the limit for
+        NaN, which converts to 0x80000000 just like NaN itself */
+    const __m128d scale = _mm_set1_pd( 2147483646.0 );
+    const __m128d minimum = _mm_set1_pd( -2147483648.0 );
+    const __m128d maximum = _mm_set1_pd( 2147483647.0 );
+    __m128d low = _mm_add_pd( _mm_mul_pd( _mm_cvtps_pd( samples ), scale ), _mm_cvtps_pd( dither ) );
+    __m128d high = _mm_add_pd( _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( samples, samples ) ), scale ),
+            _mm_cvtps_pd( _mm_movehl_ps( dither, dither ) ) );
+
+    low = _mm_min_pd( _mm_max_pd( low, minimum ), maximum );
+    high = _mm_min_pd( _mm_max_pd( high, minimum ), maximum );
+    return _mm_unpacklo_epi64( _mm_cvttpd_epi32( low ), _mm_cvttpd_epi32( high ) );
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int32_DitherClip_SSE2_Unit( void *destinationBuffer, void *sourceBuffer,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, j, blockCount;
+
+    for( i = 0; i < count; i += blockCount )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count - i );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( j = 0; j < blockCount; j += 4 )
+        {
+            __m128i samples = DitherClipFloat32_To_Int32_SSE2( _mm_loadu_ps( src + i + j ), _mm_loadu_ps( dither + j ) );
+            _mm_storeu_si128( (__m128i*)(dest + i + j), samples );
+        }
+    }
+}
+
+PA_SIMD_DITHER_CONVERTER_( Float32_To_Int32_DitherClip, SSE2, 4, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int24_DitherClip_SSE2_Unit( void *destinationBuffer, void *sourceBuffer,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, j, blockCount;
+
+    for( i = 0; i < count; i += blockCount )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count - i );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( j = 0; j < blockCount; j += 4 )
+        {
+            __m128i samples = DitherClipFloat32_To_Int32_SSE2( _mm_loadu_ps( src + i + j ), _mm_loadu_ps( dither + j ) );
+            StoreInt24_SSE2( dest + (i + j) * 3, samples );
+        }
+    }
+}
+
+PA_SIMD_DITHER_CONVERTER_( Float32_To_Int24_DitherClip, SSE2, 4, 4, 3 )
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int16_DitherClip_SSE2_Unit( void *destinationBuffer, void *sourceBuffer,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m128 scale = _mm_set1_ps( 32766.0f );
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, j, blockCount;
+
+    for( i = 0; i < count; i += blockCount )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count - i );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( j = 0; j < blockCount; j += 8 )
+        {
+            __m128 low = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( src + i + j ), scale ), _mm_loadu_ps( dither + j ) );
+            __m128 high = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( src + i + j + 4 ), scale ), _mm_loadu_ps( dither + j + 4 ) );
+            _mm_storeu_si128( (__m128i*)(dest + i + j), _mm_packs_epi32( _mm_cvttps_epi32( low ), _mm_cvttps_epi32( high ) ) );
+        }
+    }
+}
+
+PA_SIMD_DITHER_CONVERTER_( Float32_To_Int16_DitherClip, SSE2, 8, 4, 2 )
+
+#endif /* PA_USE_C99_LRINTF */
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef PA_AVX2_CONVERTERS_
+
+static PA_AVX2_TARGET_ void StoreInt24_AVX2( unsigned char *dest, __m128i samples )
+{
+    /* the top three bytes of each sample, packed into the low twelve bytes */
+    const __m128i shuffle = _mm_setr_epi8( 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1 );
+    int tail;
+
+    samples = _mm_shuffle_epi8( samples, shuffle );
+    _mm_storel_epi64( (__m128i*)dest, samples );
+    tail = _mm_cvtsi128_si32( _mm_srli_si128( samples, 8 ) );
+    memcpy( dest + 8, &tail, 4 );
+}
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ __m128i LoadInt24_AVX2( unsigned char *src )
+{
+    /* each sample into the top three bytes of a 32 bit lane, reading no further than src[11] */
+    const __m128i shuffle = _mm_setr_epi8( -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+    int tail;
+
+    memcpy( &tail, src + 8, 4 );
+    return _mm_shuffle_epi8(
+            _mm_unpacklo_epi64( _mm_loadl_epi64( (__m128i*)src ), _mm_cvtsi32_si128( tail ) ), shuffle );
+}
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int32_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m256 scaled = _mm256_mul_ps( _mm256_loadu_ps( src + i ), scale );
+        _mm256_storeu_si256( (__m256i*)(dest + i), PA_AVX2_FLOAT_TO_INT_( scaled ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int32, AVX2, 8, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int32_Clip_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m256 scaled = _mm256_mul_ps( _mm256_loadu_ps( src + i ), scale );
+        _mm256_storeu_si256( (__m256i*)(dest + i), PA_AVX2_CLIP_INT32_( PA_AVX2_FLOAT_TO_INT_( scaled ), scaled ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int32_Clip, AVX2, 8, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int24_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    const __m256d scale = _mm256_set1_pd( 2147483647.0 );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 4 )
+    {
+        __m256d scaled = _mm256_mul_pd( _mm256_cvtps_pd( _mm_loadu_ps( src + i ) ), scale );
+        StoreInt24_AVX2( dest + i * 3, _mm256_cvttpd_epi32( scaled ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int24, AVX2, 4, 4, 3 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int24_Clip_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m256 scaled = _mm256_mul_ps( _mm256_loadu_ps( src + i ), scale );
+        __m256i samples = PA_AVX2_CLIP_INT32_( _mm256_cvttps_epi32( scaled ), scaled );
+        StoreInt24_AVX2( dest + i * 3, _mm256_castsi256_si128( samples ) );
+        StoreInt24_AVX2( dest + i * 3 + 12, _mm256_extracti128_si256( samples, 1 ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int24_Clip, AVX2, 8, 4, 3 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int16_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 32767.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 16 )
+    {
+        __m256i low = PA_AVX2_FLOAT_TO_INT_( _mm256_mul_ps( _mm256_loadu_ps( src + i ), scale ) );
+        __m256i high = PA_AVX2_FLOAT_TO_INT_( _mm256_mul_ps( _mm256_loadu_ps( src + i + 8 ), scale ) );
+        low = _mm256_srai_epi32( _mm256_slli_epi32( low, 16 ), 16 );
+        high = _mm256_srai_epi32( _mm256_slli_epi32( high, 16 ), 16 );
+        /* packing interleaves the 128 bit lanes of low and high, the permute restores the order */
+        _mm256_storeu_si256( (__m256i*)(dest + i),
+                _mm256_permute4x64_epi64( _mm256_packs_epi32( low, high ), 0xD8 ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int16, AVX2, 16, 4, 2 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int16_Clip_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 32767.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 16 )
+    {
+        __m256i low = PA_AVX2_FLOAT_TO_INT_( _mm256_mul_ps( _mm256_loadu_ps( src + i ), scale ) );
+        __m256i high = PA_AVX2_FLOAT_TO_INT_( _mm256_mul_ps( _mm256_loadu_ps( src + i + 8 ), scale ) );
+        _mm256_storeu_si256( (__m256i*)(dest + i),
+                _mm256_permute4x64_epi64( _mm256_packs_epi32( low, high ), 0xD8 ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Float32_To_Int16_Clip, AVX2, 16, 4, 2 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Int32_To_Float32_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 1.0f / 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m256i samples = _mm256_loadu_si256( (__m256i*)(src + i) );
+        _mm256_storeu_ps( dest + i, _mm256_mul_ps( _mm256_cvtepi32_ps( samples ), scale ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Int32_To_Float32, AVX2, 8, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Int24_To_Float32_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 1.0f / 2147483648.0f );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m256i samples = _mm256_inserti128_si256(
+                _mm256_castsi128_si256( LoadInt24_AVX2( src + i * 3 ) ), LoadInt24_AVX2( src + i * 3 + 12 ), 1 );
+        _mm256_storeu_ps( dest + i, _mm256_mul_ps( _mm256_cvtepi32_ps( samples ), scale ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Int24_To_Float32, AVX2, 8, 3, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Int16_To_Float32_AVX2_Unit( void *destinationBuffer, void *sourceBuffer, unsigned int count )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( const_1_div_32768_ );
+    unsigned int i;
+
+    for( i = 0; i < count; i += 8 )
+    {
+        __m256i samples = _mm256_cvtepi16_epi32( _mm_loadu_si128( (__m128i*)(src + i) ) );
+        _mm256_storeu_ps( dest + i, _mm256_mul_ps( _mm256_cvtepi32_ps( samples ), scale ) );
+    }
+}
+
+PA_SIMD_CONVERTER_( Int16_To_Float32, AVX2, 8, 2, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef PA_USE_C99_LRINTF
+
+static PA_AVX2_TARGET_ __m128i DitherClipFloat32_To_Int32_AVX2( __m128 samples, __m128 dither )
+{
+    const __m256d scale = _mm256_set1_pd( 2147483646.0 );
+    const __m256d minimum = _mm256_set1_pd( -2147483648.0 );
+    const __m256d maximum = _mm256_set1_pd( 2147483647.0 );
+    __m256d dithered = _mm256_add_pd( _mm256_mul_pd( _mm256_cvtps_pd( samples ), scale ), _mm256_cvtps_pd( dither ) );
+
+    return _mm256_cvttpd_epi32( _mm256_min_pd( _mm256_max_pd( dithered, minimum ), maximum ) );
+}
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int32_DitherClip_AVX2_Unit( void *destinationBuffer, void *sourceBuffer,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, j, blockCount;
+
+    for( i = 0; i < count; i += blockCount )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count - i );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( j = 0; j < blockCount; j += 4 )
+        {
+            __m128i samples = DitherClipFloat32_To_Int32_AVX2( _mm_loadu_ps( src + i + j ), _mm_loadu_ps( dither + j ) );
+            _mm_storeu_si128( (__m128i*)(dest + i + j), samples );
+        }
+    }
+}
+
+PA_SIMD_DITHER_CONVERTER_( Float32_To_Int32_DitherClip, AVX2, 4, 4, 4 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int24_DitherClip_AVX2_Unit( void *destinationBuffer, void *sourceBuffer,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest = (unsigned char*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, j, blockCount;
+
+    for( i = 0; i < count; i += blockCount )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count - i );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( j = 0; j < blockCount; j += 4 )
+        {
+            __m128i samples = DitherClipFloat32_To_Int32_AVX2( _mm_loadu_ps( src + i + j ), _mm_loadu_ps( dither + j ) );
+            StoreInt24_AVX2( dest + (i + j) * 3, samples );
+        }
+    }
+}
+
+PA_SIMD_DITHER_CONVERTER_( Float32_To_Int24_DitherClip, AVX2, 4, 4, 3 )
+
+/* -------------------------------------------------------------------------- */
+
+static PA_AVX2_TARGET_ void Float32_To_Int16_DitherClip_AVX2_Unit( void *destinationBuffer, void *sourceBuffer,
+        unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    const __m256 scale = _mm256_set1_ps( 32766.0f );
+    float dither[PA_DITHER_BLOCK_SIZE_];
+    unsigned int i, j, blockCount;
+
+    for( i = 0; i < count; i += blockCount )
+    {
+        blockCount = PA_DITHER_BLOCK_COUNT_( count - i );
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, blockCount );
+
+        for( j = 0; j < blockCount; j += 16 )
+        {
+            __m256 low = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( src + i + j ), scale ), _mm256_loadu_ps( dither + j ) );
+            __m256 high = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( src + i + j + 8 ), scale ), _mm256_loadu_ps( dither + j + 8 ) );
+            __m256i packed = _mm256_packs_epi32( _mm256_cvttps_epi32( low ), _mm256_cvttps_epi32( high ) );
+            _mm256_storeu_si256( (__m256i*)(dest + i + j), _mm256_permute4x64_epi64( packed, 0xD8 ) );
+        }
+    }
+}
+
+PA_SIMD_DITHER_CONVERTER_( Float32_To_Int16_DitherClip, AVX2, 16, 4, 2 )
+
+#endif /* PA_USE_C99_LRINTF */
+
+#endif /* PA_AVX2_CONVERTERS_ */
+
+/* -------------------------------------------------------------------------- */
+
+typedef struct SimdConverters
+{
+    PaUtilConverter *scalar;
+    PaUtilConverter *sse2;
+    PaUtilConverter *avx2;
+} SimdConverters;
+
+#ifdef PA_AVX2_CONVERTERS_
+#define PA_SIMD_CONVERTERS_( name )     { name, name ## _SSE2, name ## _AVX2 }
+#else
+#define PA_SIMD_CONVERTERS_( name )     { name, name ## _SSE2, 0 }
+#endif
+
+static const SimdConverters simdConverters_[] = {
+#ifndef PA_USE_C99_LRINTF
+    PA_SIMD_CONVERTERS_( Float32_To_Int32_DitherClip ),
+    PA_SIMD_CONVERTERS_( Float32_To_Int24_DitherClip ),
+    PA_SIMD_CONVERTERS_( Float32_To_Int16_DitherClip ),
+#endif
+    PA_SIMD_CONVERTERS_( Float32_To_Int32 ),
+    PA_SIMD_CONVERTERS_( Float32_To_Int32_Clip ),
+    PA_SIMD_CONVERTERS_( Float32_To_Int24 ),
+    PA_SIMD_CONVERTERS_( Float32_To_Int24_Clip ),
+    PA_SIMD_CONVERTERS_( Float32_To_Int16 ),
+    PA_SIMD_CONVERTERS_( Float32_To_Int16_Clip ),
+    PA_SIMD_CONVERTERS_( Int32_To_Float32 ),
+    PA_SIMD_CONVERTERS_( Int24_To_Float32 ),
+    PA_SIMD_CONVERTERS_( Int16_To_Float32 )
+};
+
+/* -------------------------------------------------------------------------- */
+
+static int IsAvx2Supported( void )
+{
+#if !defined(PA_AVX2_CONVERTERS_)
+    return 0;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+
+    __cpuid( info, 0 );
+    if( info[0] < 7 )
+        return 0;
+
+    /* AVX2 needs the OS to save the YMM registers, which OSXSAVE and XCR0 tell */
+    __cpuid( info, 1 );
+    if( (info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 )
+        return 0;
+    if( (_xgetbv( 0 ) & 6) != 6 )
+        return 0;
+
+    __cpuidex( info, 7, 0 );
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Returns the fastest SIMD version of converter that the CPU supports, or converter itself if it
+    has none. Converters that were substituted in paConverters have none, so they stay in use.
+*/
+static PaUtilConverter* SelectSimdConverter( PaUtilConverter *converter )
+{
+    /* -1 until the CPU has been checked, checking it from several threads at once is harmless */
+    static int avx2Supported = -1;
+    size_t i;
+
+    if( avx2Supported == -1 )
+        avx2Supported = IsAvx2Supported();
+
+    for( i = 0; i < sizeof(simdConverters_) / sizeof(simdConverters_[0]); ++i )
+    {
+        if( simdConverters_[i].scalar == converter )
+        {
+            if( avx2Supported && simdConverters_[i].avx2 )
+                return simdConverters_[i].avx2;
+            return simdConverters_[i].sse2;
+        }
+    }
+
+    return converter;
+}
+
+#endif /* PA_SSE2_CONVERTERS_ */
+
+/* -------------------------------------------------------------------------- */
+
 #endif /* PA_NO_STANDARD_CONVERTERS */
 
 /* -------------------------------------------------------------------------- */
 
+PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat, PaStreamFlags flags )
+{
+    PaUtilConverter *converter = SelectTableConverter( sourceFormat, destinationFormat, flags );
+
+#ifdef PA_SSE2_CONVERTERS_
+    if( converter )
+        converter = SelectSimdConverter( converter );
+#endif
+
+    return converter;
+}
+
+/* -------------------------------------------------------------------------- */
+
 PaUtilZeroer* PaUtil_SelectZeroer( PaSampleFormat destinationFormat )
 {
     switch( destinationFormat & ~paNonInterleaved ){
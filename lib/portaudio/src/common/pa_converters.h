@@ -103,6 +103,9 @@ typedef void PaUtilConverter(
     version is returned.
     If the source and destination formats are the same, a function which
     copies data of the appropriate size will be returned.
+    Where the selected converter is one of PortAudio's standard converters
+    and the CPU supports SSE2 or AVX2, a vectorized version producing the same
+    output may be returned instead.
 */
 PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
         PaSampleFormat destinationFormat, PaStreamFlags flags );
@@ -41,20 +41,41 @@
  @ingroup common_src
 
  @brief Functions to assist in measuring the CPU utilization of a callback
- stream. Used to implement the Pa_GetStreamCpuLoad() function.
-
- @todo Dynamically calculate the coefficients used to smooth the CPU Load
- Measurements over time to provide a uniform characterisation of CPU Load
- independent of rate at which PaUtil_BeginCpuLoadMeasurement /
- PaUtil_EndCpuLoadMeasurement are called. see http://www.portaudio.com/trac/ticket/113
+ stream. Used to implement the Pa_GetStreamCpuLoad() and
+ Pa_GetStreamCpuLoadStats() functions.
+
+ The measured load is smoothed with a one pole low pass filter whose
+ coefficient is calculated from the duration of each measurement, so that
+ the smoothing has the same time constant whatever rate
+ PaUtil_BeginCpuLoadMeasurement / PaUtil_EndCpuLoadMeasurement are called at
+ (see http://www.portaudio.com/trac/ticket/113).
 */
 
 
 #include "pa_cpuload.h"
 
 #include <assert.h>
+#include <math.h>
+
+#include "pa_util.h"   /* for PaUtil_GetNanoseconds() */
+#include "pa_memorybarrier.h"
+
 
-#include "pa_util.h"   /* for PaUtil_GetTime() */
+/* matches the former fixed coefficient of 0.9 for host buffers of about 10 ms */
+#define PA_CPU_LOAD_DEFAULT_SMOOTHING_TIME_CONSTANT_   (0.1)
+
+
+static void ClearCpuLoadStats( PaUtilCpuLoadMeasurer* measurer )
+{
+    int i;
+
+    measurer->lastLoad = 0.;
+    measurer->peakLoad = 0.;
+    measurer->measurementCount = 0;
+    measurer->overloadCount = 0;
+    for( i=0; i < paCpuLoadHistogramBucketCount; ++i )
+        measurer->histogram[i] = 0;
+}
 
 
 void PaUtil_InitializeCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer, double sampleRate )
@@ -63,38 +84,81 @@ void PaUtil_InitializeCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer, double s
 
     measurer->samplingPeriod = 1. / sampleRate;
     measurer->averageLoad = 0.;
+    measurer->smoothingTimeConstant = PA_CPU_LOAD_DEFAULT_SMOOTHING_TIME_CONSTANT_;
+    measurer->smoothingCoefficient = 0.;
+    measurer->smoothingCoefficientTimeConstant = 0.;
+    measurer->smoothingCoefficientFrameCount = 0;
+    measurer->statsResetRequestCount = 0;
+    measurer->statsResetCount = 0;
+    ClearCpuLoadStats( measurer );
 }
 
 void PaUtil_ResetCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer )
 {
     measurer->averageLoad = 0.;
+    ClearCpuLoadStats( measurer );
+    measurer->statsResetCount = measurer->statsResetRequestCount;
 }
 
 void PaUtil_BeginCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer )
 {
-    measurer->measurementStartTime = PaUtil_GetTime();
+    measurer->measurementStartTime = PaUtil_GetNanoseconds();
 }
 
 
 void PaUtil_EndCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer, unsigned long framesProcessed )
 {
-    double measurementEndTime, secondsFor100Percent, measuredLoad;
+    PaUtilNanoseconds measurementEndTime;
+    double secondsFor100Percent, measuredLoad, coefficient, timeConstant;
+    unsigned long resetRequestCount;
+    int bucket;
 
     if( framesProcessed > 0 ){
-        measurementEndTime = PaUtil_GetTime();
+        measurementEndTime = PaUtil_GetNanoseconds();
 
         assert( framesProcessed > 0 );
         secondsFor100Percent = framesProcessed * measurer->samplingPeriod;
 
-        measuredLoad = (measurementEndTime - measurer->measurementStartTime) / secondsFor100Percent;
-
-        /* Low pass filter the calculated CPU load to reduce jitter using a simple IIR low pass filter. */
-        /** FIXME @todo these coefficients shouldn't be hardwired see: http://www.portaudio.com/trac/ticket/113 */
-#define LOWPASS_COEFFICIENT_0   (0.9)
-#define LOWPASS_COEFFICIENT_1   (0.99999 - LOWPASS_COEFFICIENT_0)
-
-        measurer->averageLoad = (LOWPASS_COEFFICIENT_0 * measurer->averageLoad) +
-                               (LOWPASS_COEFFICIENT_1 * measuredLoad);
+        measuredLoad = PaUtil_NanosecondsToTime( measurementEndTime - measurer->measurementStartTime ) / secondsFor100Percent;
+
+        /* Low pass filter the calculated CPU load to reduce jitter using a simple IIR low pass
+            filter, with a coefficient that depends on the duration of the measurement. The
+            coefficient is only recalculated when the buffer size or time constant changes. */
+        timeConstant = measurer->smoothingTimeConstant;
+        if( framesProcessed != measurer->smoothingCoefficientFrameCount
+                || timeConstant != measurer->smoothingCoefficientTimeConstant )
+        {
+            measurer->smoothingCoefficient = ( timeConstant > 0. ) ? exp( -secondsFor100Percent / timeConstant ) : 0.;
+            measurer->smoothingCoefficientTimeConstant = timeConstant;
+            measurer->smoothingCoefficientFrameCount = framesProcessed;
+        }
+        coefficient = measurer->smoothingCoefficient;
+
+        measurer->averageLoad = (coefficient * measurer->averageLoad) +
+                               ((1. - coefficient) * measuredLoad);
+
+        /* carry out a reset requested by another thread */
+        resetRequestCount = measurer->statsResetRequestCount;
+        if( resetRequestCount != measurer->statsResetCount )
+        {
+            ClearCpuLoadStats( measurer );
+            PaUtil_WriteMemoryBarrier(); /* the cleared stats must be visible before the reset */
+            measurer->statsResetCount = resetRequestCount;
+        }
+
+        measurer->lastLoad = measuredLoad;
+        if( measuredLoad > measurer->peakLoad )
+            measurer->peakLoad = measuredLoad;
+        measurer->measurementCount++;
+        if( measuredLoad > 1. )
+            measurer->overloadCount++;
+
+        bucket = (int)(measuredLoad * 10.);
+        if( bucket < 0 )
+            bucket = 0;
+        else if( bucket >= paCpuLoadHistogramBucketCount )
+            bucket = paCpuLoadHistogramBucketCount - 1;
+        measurer->histogram[bucket]++;
     }
 }
 
@@ -103,3 +167,46 @@ double PaUtil_GetCpuLoad( PaUtilCpuLoadMeasurer* measurer )
 {
     return measurer->averageLoad;
 }
+
+
+void PaUtil_GetCpuLoadStats( PaUtilCpuLoadMeasurer* measurer, PaStreamCpuLoadStats *stats )
+{
+    int i;
+
+    stats->averageLoad = measurer->averageLoad;
+
+    if( measurer->statsResetRequestCount != measurer->statsResetCount )
+    {
+        /* a reset is pending */
+        stats->lastLoad = 0.;
+        stats->peakLoad = 0.;
+        stats->measurementCount = 0;
+        stats->overloadCount = 0;
+        for( i=0; i < paCpuLoadHistogramBucketCount; ++i )
+            stats->histogram[i] = 0;
+        return;
+    }
+
+    PaUtil_ReadMemoryBarrier(); /* don't read the stats before the reset count */
+
+    stats->lastLoad = measurer->lastLoad;
+    stats->peakLoad = measurer->peakLoad;
+    stats->measurementCount = measurer->measurementCount;
+    stats->overloadCount = measurer->overloadCount;
+    for( i=0; i < paCpuLoadHistogramBucketCount; ++i )
+        stats->histogram[i] = measurer->histogram[i];
+}
+
+
+void PaUtil_RequestCpuLoadStatsReset( PaUtilCpuLoadMeasurer* measurer )
+{
+    /* only this function writes statsResetRequestCount. Concurrent requests may
+        merge into one, which is harmless. */
+    measurer->statsResetRequestCount = measurer->statsResetRequestCount + 1;
+}
+
+
+void PaUtil_SetCpuLoadSmoothing( PaUtilCpuLoadMeasurer* measurer, double timeConstant )
+{
+    measurer->smoothingTimeConstant = ( timeConstant > 0. ) ? timeConstant : 0.;
+}
@@ -43,28 +43,70 @@
  @ingroup common_src
 
  @brief Functions to assist in measuring the CPU utilization of a callback
- stream. Used to implement the Pa_GetStreamCpuLoad() function.
+ stream. Used to implement the Pa_GetStreamCpuLoad() and
+ Pa_GetStreamCpuLoadStats() functions.
+
+ The measurement functions are called by the stream's processing thread only.
+ The statistics are plain counters with that thread as their single writer, so
+ other threads may read them without locking. Other threads don't write them
+ either, resets are requested with PaUtil_RequestCpuLoadStatsReset() and
+ carried out by the processing thread.
 */
 
 
+#include "portaudio.h"
+#include "pa_util.h"
+
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif /* __cplusplus */
 
 
-typedef struct {
+typedef struct PaUtilCpuLoadMeasurer {
     double samplingPeriod;
-    double measurementStartTime;
+    PaUtilNanoseconds measurementStartTime;
     double averageLoad;
+    double smoothingTimeConstant; /**< in seconds, 0 for no smoothing */
+    double smoothingCoefficient; /**< for smoothingCoefficientFrameCount frames and smoothingCoefficientTimeConstant */
+    double smoothingCoefficientTimeConstant;
+    unsigned long smoothingCoefficientFrameCount; /**< 0 if smoothingCoefficient hasn't been calculated */
+
+    double lastLoad;
+    double peakLoad;
+    unsigned long measurementCount;
+    unsigned long overloadCount;
+    unsigned long histogram[paCpuLoadHistogramBucketCount];
+
+    volatile unsigned long statsResetRequestCount; /**< incremented by PaUtil_RequestCpuLoadStatsReset() */
+    volatile unsigned long statsResetCount; /**< statsResetRequestCount as of the last reset */
 } PaUtilCpuLoadMeasurer; /**< @todo need better name than measurer */
 
 void PaUtil_InitializeCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer, double sampleRate );
 void PaUtil_BeginCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer );
 void PaUtil_EndCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer, unsigned long framesProcessed );
+
+/** Reset the average load and the statistics. Must not be called while
+ measurements are being made, ie. only while the stream is stopped.
+*/
 void PaUtil_ResetCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer );
 double PaUtil_GetCpuLoad( PaUtilCpuLoadMeasurer* measurer );
 
+/** Copy the statistics into stats. May be called from any thread. */
+void PaUtil_GetCpuLoadStats( PaUtilCpuLoadMeasurer* measurer, PaStreamCpuLoadStats *stats );
+
+/** Request a reset of the statistics, except the average load, from any
+ thread. The reset is carried out at the next measurement, until then
+ PaUtil_GetCpuLoadStats() returns reset statistics.
+*/
+void PaUtil_RequestCpuLoadStatsReset( PaUtilCpuLoadMeasurer* measurer );
+
+/** Set the time constant of the average load's low pass filter, in seconds.
+ Values of 0 or below disable smoothing. May be called from any thread.
+*/
+void PaUtil_SetCpuLoadSmoothing( PaUtilCpuLoadMeasurer* measurer, double timeConstant );
+
 
 #ifdef __cplusplus
 }
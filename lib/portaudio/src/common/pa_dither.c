@@ -45,6 +45,12 @@
 #include "pa_types.h"
 #include "pa_dither.h"
 
+#if !defined(PA_NO_SIMD_CONVERTERS) && \
+        ( defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) )
+#define PA_SSE2_DITHER_ 1
+#include <emmintrin.h>
+#endif
+
 
 /* Note that the linear congruential algorithm requires 32 bit integers
  * because it uses arithmetic overflow. So use PaUint32 instead of
@@ -59,6 +65,22 @@ void PaUtil_InitializeTriangularDitherState( PaUtilTriangularDitherGenerator *st
     state->previous = 0;
     state->randSeed1 = 22222;
     state->randSeed2 = 5555555;
+
+    state->noiseShaping = 0;
+    state->shapingError1 = 0.0f;
+    state->shapingError2 = 0.0f;
+}
+
+
+void PaUtil_InitializeNoiseShapedDitherState( PaUtilTriangularDitherGenerator *state, int channel )
+{
+    PaUtil_InitializeTriangularDitherState( state );
+
+    /* start each channel at a different point of the generators' cycles */
+    state->randSeed1 += (PaUint32)channel * 0x9E3779B9;
+    state->randSeed2 += (PaUint32)channel * 0x7F4A7C15;
+
+    state->noiseShaping = 1;
 }
 
 
@@ -112,6 +134,187 @@ float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *sta
 }
 
 
+/* The block generator steps PA_DITHER_LANES_ copies of each random number
+ * generator, lane j producing every PA_DITHER_LANES_'th value of the serial
+ * sequence starting with the j'th. ditherJumps_[n] holds the multiplier and
+ * increment that make n + 1 steps of the serial generator in one, which set up
+ * the lanes independently of each other. The last entry steps a lane.
+ */
+#define PA_DITHER_LANES_            (8)
+
+static const PaUint32 ditherJumps_[PA_DITHER_LANES_][2] = {
+    { 0x0BB38435, 0x3619636B }, /* 196314165, 907633515 */
+    { 0xB464B2F9, 0x9D6F2492 },
+    { 0x1C3C718D, 0xF50D3DA5 },
+    { 0x77A73631, 0xF6FF3A94 },
+    { 0xFCD27C25, 0x44A0D40F },
+    { 0x4475C7A9, 0x443A0686 },
+    { 0xC58079FD, 0x932BD529 },
+    { 0x4D66B561, 0x16C0A8E8 }
+};
+
+#define PA_DITHER_LANE_MULTIPLIER_  (ditherJumps_[PA_DITHER_LANES_ - 1][0])
+#define PA_DITHER_LANE_INCREMENT_   (ditherJumps_[PA_DITHER_LANES_ - 1][1])
+
+/* Generates PA_DITHER_LANES_ values at a time, as many as fit in count. The
+ * lanes of seed1 and seed2 hold the seeds of the next values and are advanced,
+ * state is left as after the last value generated. Returns the number of values.
+ */
+#ifdef PA_SSE2_DITHER_
+
+/* the low 32 bits of the lane products, SSE2 only multiplies the even lanes */
+static __m128i MultiplyLanes( __m128i a, __m128i b )
+{
+    __m128i even = _mm_mul_epu32( a, b );
+    __m128i odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+    return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+            _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+/* The lanes are split into a low and a high vector of four, each step of the
+ * generators is a long multiply so the four independent chains keep the
+ * multiplier busy.
+ */
+static unsigned int GenerateDitherLanes( PaUtilTriangularDitherGenerator *state,
+        PaUint32 *seed1, PaUint32 *seed2, float *dither, unsigned int count )
+{
+    const __m128i multiplier = _mm_set1_epi32( (int)PA_DITHER_LANE_MULTIPLIER_ );
+    const __m128i increment = _mm_set1_epi32( (int)PA_DITHER_LANE_INCREMENT_ );
+    const __m128 scale = _mm_set1_ps( const_float_dither_scale_ );
+    __m128i low1 = _mm_loadu_si128( (__m128i*)seed1 ), high1 = _mm_loadu_si128( (__m128i*)(seed1 + 4) );
+    __m128i low2 = _mm_loadu_si128( (__m128i*)seed2 ), high2 = _mm_loadu_si128( (__m128i*)(seed2 + 4) );
+    __m128i last1 = high1, last2 = high2;
+    /* only the top lane is used, as the previous value of the first lane */
+    __m128i previous = _mm_slli_si128( _mm_cvtsi32_si128( (int)state->previous ), 12 );
+    PaUint32 lanes[4];
+    unsigned int i;
+
+    for( i = 0; i + PA_DITHER_LANES_ <= count; i += PA_DITHER_LANES_ )
+    {
+        __m128i low = _mm_add_epi32( _mm_srai_epi32( low1, DITHER_SHIFT_ ), _mm_srai_epi32( low2, DITHER_SHIFT_ ) );
+        __m128i high = _mm_add_epi32( _mm_srai_epi32( high1, DITHER_SHIFT_ ), _mm_srai_epi32( high2, DITHER_SHIFT_ ) );
+
+        /* high pass filter, each lane's previous value is the lane before it */
+        __m128i lowBefore = _mm_or_si128( _mm_slli_si128( low, 4 ), _mm_srli_si128( previous, 12 ) );
+        __m128i highBefore = _mm_or_si128( _mm_slli_si128( high, 4 ), _mm_srli_si128( low, 12 ) );
+        _mm_storeu_ps( dither + i, _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( low, lowBefore ) ), scale ) );
+        _mm_storeu_ps( dither + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( high, highBefore ) ), scale ) );
+        previous = high;
+
+        last1 = high1;
+        last2 = high2;
+        low1 = _mm_add_epi32( MultiplyLanes( low1, multiplier ), increment );
+        high1 = _mm_add_epi32( MultiplyLanes( high1, multiplier ), increment );
+        low2 = _mm_add_epi32( MultiplyLanes( low2, multiplier ), increment );
+        high2 = _mm_add_epi32( MultiplyLanes( high2, multiplier ), increment );
+    }
+
+    _mm_storeu_si128( (__m128i*)seed1, low1 );
+    _mm_storeu_si128( (__m128i*)(seed1 + 4), high1 );
+    _mm_storeu_si128( (__m128i*)seed2, low2 );
+    _mm_storeu_si128( (__m128i*)(seed2 + 4), high2 );
+
+    _mm_storeu_si128( (__m128i*)lanes, previous );
+    state->previous = lanes[3];
+    _mm_storeu_si128( (__m128i*)lanes, last1 );
+    state->randSeed1 = lanes[3];
+    _mm_storeu_si128( (__m128i*)lanes, last2 );
+    state->randSeed2 = lanes[3];
+
+    return i;
+}
+
+#else /* PA_SSE2_DITHER_ */
+
+static unsigned int GenerateDitherLanes( PaUtilTriangularDitherGenerator *state,
+        PaUint32 *seed1, PaUint32 *seed2, float *dither, unsigned int count )
+{
+    PaUint32 lanes1[PA_DITHER_LANES_], lanes2[PA_DITHER_LANES_];
+    PaUint32 last1 = seed1[PA_DITHER_LANES_ - 1], last2 = seed2[PA_DITHER_LANES_ - 1];
+    PaInt32 current[PA_DITHER_LANES_];
+    PaInt32 previous = (PaInt32)state->previous;
+    unsigned int i, j;
+
+    /* work on local copies, which the compiler knows aren't aliased by state or dither */
+    for( j = 0; j < PA_DITHER_LANES_; ++j )
+    {
+        lanes1[j] = seed1[j];
+        lanes2[j] = seed2[j];
+    }
+
+    for( i = 0; i + PA_DITHER_LANES_ <= count; i += PA_DITHER_LANES_ )
+    {
+        for( j = 0; j < PA_DITHER_LANES_; ++j )
+        {
+            current[j] = (((PaInt32)lanes1[j])>>DITHER_SHIFT_) +
+                         (((PaInt32)lanes2[j])>>DITHER_SHIFT_);
+        }
+
+        /* high pass filter, each lane's previous value is the one before it */
+        dither[i] = ((float)(current[0] - previous)) * const_float_dither_scale_;
+        for( j = 1; j < PA_DITHER_LANES_; ++j )
+            dither[i + j] = ((float)(current[j] - current[j - 1])) * const_float_dither_scale_;
+        previous = current[PA_DITHER_LANES_ - 1];
+
+        last1 = lanes1[PA_DITHER_LANES_ - 1];
+        last2 = lanes2[PA_DITHER_LANES_ - 1];
+        for( j = 0; j < PA_DITHER_LANES_; ++j )
+        {
+            lanes1[j] = (lanes1[j] * PA_DITHER_LANE_MULTIPLIER_) + PA_DITHER_LANE_INCREMENT_;
+            lanes2[j] = (lanes2[j] * PA_DITHER_LANE_MULTIPLIER_) + PA_DITHER_LANE_INCREMENT_;
+        }
+    }
+
+    for( j = 0; j < PA_DITHER_LANES_; ++j )
+    {
+        seed1[j] = lanes1[j];
+        seed2[j] = lanes2[j];
+    }
+    state->previous = (PaUint32)previous;
+    state->randSeed1 = last1;
+    state->randSeed2 = last2;
+
+    return i;
+}
+
+#endif /* PA_SSE2_DITHER_ */
+
+
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *state,
+        float *dither, unsigned int count )
+{
+    PaUint32 seed1[PA_DITHER_LANES_], seed2[PA_DITHER_LANES_];
+    PaInt32 current;
+    unsigned int i, j;
+
+    if( count < PA_DITHER_LANES_ )
+    {
+        while( count-- )
+            *dither++ = PaUtil_GenerateFloatTriangularDither( state );
+        return;
+    }
+
+    for( j = 0; j < PA_DITHER_LANES_; ++j )
+    {
+        seed1[j] = (state->randSeed1 * ditherJumps_[j][0]) + ditherJumps_[j][1];
+        seed2[j] = (state->randSeed2 * ditherJumps_[j][0]) + ditherJumps_[j][1];
+    }
+
+    i = GenerateDitherLanes( state, seed1, seed2, dither, count );
+
+    /* the lanes already hold the seeds of the remaining values */
+    for( j = 0; i < count; ++i, ++j )
+    {
+        current = (((PaInt32)seed1[j])>>DITHER_SHIFT_) +
+                  (((PaInt32)seed2[j])>>DITHER_SHIFT_);
+        dither[i] = ((float)(current - (PaInt32)state->previous)) * const_float_dither_scale_;
+        state->previous = (PaUint32)current;
+        state->randSeed1 = seed1[j];
+        state->randSeed2 = seed2[j];
+    }
+}
+
+
 /*
 The following alternate dither algorithms (from musicdsp.org) could be
 considered
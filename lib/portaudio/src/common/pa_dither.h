@@ -62,6 +62,14 @@ typedef struct PaUtilTriangularDitherGenerator{
     PaUint32 previous;
     PaUint32 randSeed1;
     PaUint32 randSeed2;
+
+    /* Non-zero if converters that support it should use noise shaped dither,
+     * in which case the state belongs to a single channel and also carries
+     * the last two quantization errors of that channel.
+     */
+    int noiseShaping;
+    float shapingError1;
+    float shapingError2;
 } PaUtilTriangularDitherGenerator;
 
 
@@ -69,6 +77,19 @@ typedef struct PaUtilTriangularDitherGenerator{
 void PaUtil_InitializeTriangularDitherState( PaUtilTriangularDitherGenerator *ditherState );
 
 
+/**
+ @brief Initialize dither state for noise shaped dither of one channel.
+
+ Converters that support noise shaping (float to 16 bit) feed back the
+ quantization error of the previous samples through a second order filter,
+ which moves the dither noise towards high frequencies where it is less
+ audible. Each channel needs its own state, channel selects a different random
+ sequence for each so that the dither noise of different channels is
+ uncorrelated. Other converters treat the state as plain triangular dither.
+*/
+void PaUtil_InitializeNoiseShapedDitherState( PaUtilTriangularDitherGenerator *ditherState, int channel );
+
+
 /**
  @brief Calculate 2 LSB dither signal with a triangular distribution.
  Ranged for adding to a 1 bit right-shifted 32 bit integer
@@ -99,6 +120,19 @@ PaInt32 PaUtil_Generate16BitTriangularDither( PaUtilTriangularDitherGenerator *d
 float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *ditherState );
 
 
+/**
+ @brief Fill dither with the next count values of
+ PaUtil_GenerateFloatTriangularDither(), generated several at a time.
+
+ The values and the resulting state are identical to calling
+ PaUtil_GenerateFloatTriangularDither() count times, but the random number
+ generators are stepped in independent lanes instead of one long dependency
+ chain, so converters can fetch the dither for a block of samples at once.
+*/
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *ditherState,
+        float *dither, unsigned int count );
+
+
 
 #ifdef __cplusplus
 }
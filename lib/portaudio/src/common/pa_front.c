@@ -74,6 +74,7 @@
 #include "pa_types.h"
 #include "pa_hostapi.h"
 #include "pa_stream.h"
+#include "pa_cpuload.h"
 #include "pa_trace.h" /* still usefull?*/
 #include "pa_debugprint.h"
 
@@ -159,6 +160,10 @@ static int defaultHostApiIndex_ = 0;
 static int initializationCount_ = 0;
 static int deviceCount_ = 0;
 
+#define PA_MAX_HOST_API_FILTER_COUNT_ 16
+static PaHostApiTypeId hostApiFilter_[ PA_MAX_HOST_API_FILTER_COUNT_ ];
+static int hostApiFilterCount_ = 0; /* 0 means all host APIs are initialized */
+
 PaUtilStreamRepresentation *firstOpenStream_ = NULL;
 
 
@@ -175,6 +180,22 @@ static int CountHostApiInitializers( void )
 }
 
 
+static int HostApiIsInFilter( PaHostApiTypeId type )
+{
+    int i;
+
+    if( hostApiFilterCount_ == 0 )
+        return 1;
+
+    for( i=0; i < hostApiFilterCount_; ++i )
+    {
+        if( hostApiFilter_[i] == type )
+            return 1;
+    }
+    return 0;
+}
+
+
 static void TerminateHostApis( void )
 {
     /* terminate in reverse order from initialization */
@@ -221,6 +242,12 @@ static PaError InitializeHostApis( void )
     {
         hostApis_[hostApisCount_] = NULL;
 
+        if( !HostApiIsInFilter( paHostApiInitializerTypeIds[i] ) )
+        {
+            PA_DEBUG(( "skipping paHostApiInitializers[%d], not in host API filter.\n",i));
+            continue;
+        }
+
         PA_DEBUG(( "before paHostApiInitializers[%d].\n",i));
 
         result = paHostApiInitializers[i]( &hostApis_[hostApisCount_], hostApisCount_ );
@@ -382,6 +409,35 @@ PaError Pa_Initialize( void )
 }
 
 
+PaError Pa_SetHostApiFilter( const PaHostApiTypeId *hostApiTypes, int count )
+{
+    PaError result = paNoError;
+    int i;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetHostApiFilter" );
+    PA_LOGAPI(("\tint count: %d\n", count ));
+
+    if( PA_IS_INITIALISED_ )
+    {
+        result = paInternalError;
+    }
+    else if( count > PA_MAX_HOST_API_FILTER_COUNT_ )
+    {
+        result = paInsufficientMemory;
+    }
+    else
+    {
+        hostApiFilterCount_ = ( hostApiTypes != NULL && count > 0 ) ? count : 0;
+        for( i=0; i < hostApiFilterCount_; ++i )
+            hostApiFilter_[i] = hostApiTypes[i];
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetHostApiFilter", result );
+
+    return result;
+}
+
+
 PaError Pa_Terminate( void )
 {
     PaError result;
@@ -398,6 +454,9 @@ PaError Pa_Terminate( void )
             TerminateHostApis();
 
             PaUtil_DumpTraceMessages();
+#if PA_TRACE_EVENTS
+            PaTrace_DumpEvents( PA_TRACE_EVENTS_FILE );
+#endif
         }
         --initializationCount_;
         result = paNoError;
@@ -1009,7 +1068,7 @@ static PaError ValidateOpenStreamParameters(
     if( (sampleRate < 1000.0) || (sampleRate > 384000.0) )
         return paInvalidSampleRate;
 
-    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback ) ) != 0 )
+    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback | paDitherNoiseShaped ) ) != 0 )
         return paInvalidFlag;
 
     if( streamFlags & paNeverDropInput )
@@ -1634,6 +1693,69 @@ double Pa_GetStreamCpuLoad( PaStream* stream )
 }
 
 
+PaError Pa_GetStreamCpuLoadStats( PaStream* stream, PaStreamCpuLoadStats *stats )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamCpuLoadStats" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamCpuLoadStats *stats: 0x%p\n", stats ));
+
+    if( result == paNoError )
+    {
+        if( stats == NULL )
+        {
+            result = paBadBufferPtr;
+        }
+        else if( PA_STREAM_REP(stream)->cpuLoadMeasurer )
+        {
+            PaUtil_GetCpuLoadStats( PA_STREAM_REP(stream)->cpuLoadMeasurer, stats );
+        }
+        else
+        {
+            memset( stats, 0, sizeof(PaStreamCpuLoadStats) );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_GetStreamCpuLoadStats", result );
+
+    return result;
+}
+
+
+PaError Pa_ResetStreamCpuLoadStats( PaStream* stream )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_ResetStreamCpuLoadStats" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+
+    if( result == paNoError && PA_STREAM_REP(stream)->cpuLoadMeasurer )
+        PaUtil_RequestCpuLoadStatsReset( PA_STREAM_REP(stream)->cpuLoadMeasurer );
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_ResetStreamCpuLoadStats", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamCpuLoadSmoothing( PaStream* stream, double timeConstant )
+{
+    PaError result = PaUtil_ValidateStreamPointer( stream );
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamCpuLoadSmoothing" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tdouble timeConstant: %g\n", timeConstant ));
+
+    if( result == paNoError && PA_STREAM_REP(stream)->cpuLoadMeasurer )
+        PaUtil_SetCpuLoadSmoothing( PA_STREAM_REP(stream)->cpuLoadMeasurer, timeConstant );
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamCpuLoadSmoothing", result );
+
+    return result;
+}
+
+
 PaError Pa_ReadStream( PaStream* stream,
                        void *buffer,
                        unsigned long frames )
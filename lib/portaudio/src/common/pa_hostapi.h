@@ -356,6 +356,13 @@ typedef PaError PaUtilHostApiInitializer( PaUtilHostApiRepresentation**, PaHostA
 extern PaUtilHostApiInitializer *paHostApiInitializers[];
 
 
+/** paHostApiInitializerTypeIds contains the PaHostApiTypeId of each entry in
+ paHostApiInitializers, in the same order. It is used by Pa_SetHostApiFilter()
+ to skip host APIs without calling their initializers.
+*/
+extern PaHostApiTypeId paHostApiInitializerTypeIds[];
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
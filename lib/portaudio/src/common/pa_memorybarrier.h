@@ -126,3 +126,46 @@
 #      error Memory barriers are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
 #   endif
 #endif
+
+/****************
+ * Atomic 64 bit loads and stores with acquire and release ordering, used for
+ * indices that are written by one thread and read by another:
+ *
+ * PaUtil_LoadAcquire64( ptr )          ptr points to a 64 bit unsigned integer
+ * PaUtil_StoreRelease64( ptr, value )
+ *
+ * An acquire load guarantees that memory accesses following it are not performed
+ * before it, a release store that memory accesses preceding it are visible before
+ * it is. Unlike a plain volatile access the 64 bit value is not torn on 32 bit
+ * targets, except with GCC older than 4.7.
+ ****************/
+
+#if defined(__ATOMIC_ACQUIRE)
+    /* GCC >= 4.7 and clang */
+#   define PaUtil_LoadAcquire64( ptr )          __atomic_load_n( (ptr), __ATOMIC_ACQUIRE )
+#   define PaUtil_StoreRelease64( ptr, value )  __atomic_store_n( (ptr), (value), __ATOMIC_RELEASE )
+#elif defined(__GNUC__)
+    /* older GCC: full barriers around volatile accesses, which are only atomic on 64 bit targets */
+#   define PaUtil_LoadAcquire64( ptr ) \
+        ({ __typeof__(*(ptr)) paValue_ = *(volatile __typeof__(*(ptr)) *)(ptr); PaUtil_FullMemoryBarrier(); paValue_; })
+#   define PaUtil_StoreRelease64( ptr, value ) \
+        do{ PaUtil_FullMemoryBarrier(); *(volatile __typeof__(*(ptr)) *)(ptr) = (value); }while(0)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+    /* aligned 64 bit accesses are atomic on x64, and MSVC gives volatile accesses acquire and
+       release semantics there (/volatile:ms, the default) */
+#   define PaUtil_LoadAcquire64( ptr )          (*(volatile unsigned __int64 *)(ptr))
+#   define PaUtil_StoreRelease64( ptr, value )  (*(volatile unsigned __int64 *)(ptr) = (value))
+#elif defined(_MSC_VER) && (_MSC_VER >= 1400) && !defined(_WIN32_WCE)
+    /* interlocked operations are full barriers, which is stronger than required */
+#   include <intrin.h>
+#   define PaUtil_LoadAcquire64( ptr )          ((unsigned __int64)_InterlockedCompareExchange64( (volatile __int64 *)(ptr), 0, 0 ))
+#   define PaUtil_StoreRelease64( ptr, value )  ((void)_InterlockedExchange64( (volatile __int64 *)(ptr), (__int64)(value) ))
+#else
+#   ifdef ALLOW_SMP_DANGERS
+#      warning Atomic 64 bit loads and stores not defined on this system or system unknown
+#      define PaUtil_LoadAcquire64( ptr )          (*(ptr))
+#      define PaUtil_StoreRelease64( ptr, value )  (*(ptr) = (value))
+#   else
+#      error Atomic 64 bit loads and stores are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
+#   endif
+#endif
@@ -49,6 +49,7 @@
 
 #include "pa_process.h"
 #include "pa_util.h"
+#include "pa_trace.h"
 
 
 #define PA_FRAMES_PER_TEMP_BUFFER_WHEN_HOST_BUFFER_SIZE_IS_UNKNOWN_    1024
@@ -70,6 +71,11 @@ static unsigned long LCM( unsigned long a, unsigned long b )
 
 #define PA_MAX_( a, b ) (((a) > (b)) ? (a) : (b))
 
+/* The dither state for output channel i. Noise shaped dither feeds back each channel's
+    quantization error, so it has a state per channel, plain dither shares one. */
+#define PA_OUTPUT_DITHER_GENERATOR_( bp, i )\
+    ((bp)->outputDitherGenerators ? &(bp)->outputDitherGenerators[i] : &(bp)->ditherGenerator)
+
 static unsigned long CalculateFrameShift( unsigned long M, unsigned long N )
 {
     unsigned long result = 0;
@@ -101,7 +107,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
 {
     PaError result = paNoError;
     PaError bytesPerSample;
-    unsigned long tempInputBufferSize, tempOutputBufferSize;
+    unsigned long tempInputBufferSize = 0, tempOutputBufferSize = 0;
     PaStreamFlags tempInputStreamFlags;
 
     if( streamFlags & paNeverDropInput )
@@ -112,11 +118,13 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
             return paInvalidFlag;
     }
 
-    /* initialize buffer ptrs to zero so they can be freed if necessary in error */
+    /* initialize buffer ptrs to zero, they are all allocated from the arena at the end */
     bp->tempInputBuffer = 0;
     bp->tempInputBufferPtrs = 0;
     bp->tempOutputBuffer = 0;
     bp->tempOutputBufferPtrs = 0;
+    bp->outputDitherGenerators = 0;
+    PaUtil_InitializeArena( &bp->arena );
 
     bp->framesPerUserBuffer = framesPerUserBuffer;
     bp->framesPerHostBuffer = framesPerHostBuffer;
@@ -248,37 +256,11 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
 
         tempInputBufferSize =
             bp->framesPerTempBuffer * bp->bytesPerUserInputSample * inputChannelCount;
-         
-        bp->tempInputBuffer = PaUtil_AllocateMemory( tempInputBufferSize );
-        if( bp->tempInputBuffer == 0 )
-        {
-            result = paInsufficientMemory;
-            goto error;
-        }
-        
-        if( bp->framesInTempInputBuffer > 0 )
-            memset( bp->tempInputBuffer, 0, tempInputBufferSize );
 
+        PaUtil_ReserveArenaMemory( &bp->arena, tempInputBufferSize );
         if( userInputSampleFormat & paNonInterleaved )
-        {
-            bp->tempInputBufferPtrs =
-                (void **)PaUtil_AllocateMemory( sizeof(void*)*inputChannelCount );
-            if( bp->tempInputBufferPtrs == 0 )
-            {
-                result = paInsufficientMemory;
-                goto error;
-            }
-        }
-
-        bp->hostInputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateMemory( sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2);
-        if( bp->hostInputChannels[0] == 0 )
-        {
-            result = paInsufficientMemory;
-            goto error;
-        }
-
-        bp->hostInputChannels[1] = &bp->hostInputChannels[0][inputChannelCount];
+            PaUtil_ReserveArenaMemory( &bp->arena, sizeof(void*)*inputChannelCount );
+        PaUtil_ReserveArenaMemory( &bp->arena, sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2 );
     }
 
     if( outputChannelCount > 0 )
@@ -319,36 +301,63 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         tempOutputBufferSize =
                 bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * outputChannelCount;
 
-        bp->tempOutputBuffer = PaUtil_AllocateMemory( tempOutputBufferSize );
-        if( bp->tempOutputBuffer == 0 )
+        PaUtil_ReserveArenaMemory( &bp->arena, tempOutputBufferSize );
+        if( userOutputSampleFormat & paNonInterleaved )
+            PaUtil_ReserveArenaMemory( &bp->arena, sizeof(void*)*outputChannelCount );
+        PaUtil_ReserveArenaMemory( &bp->arena, sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
+        if( (streamFlags & paDitherNoiseShaped) && !(streamFlags & paDitherOff) )
+            PaUtil_ReserveArenaMemory( &bp->arena, sizeof(PaUtilTriangularDitherGenerator) * outputChannelCount );
+    }
+
+    /* Allocate all of the above at once. The arena's memory is zeroed, which also clears
+        the temp buffers when they start out with framesInTempInputBuffer /
+        framesInTempOutputBuffer frames of silence. The blocks are requested in the order
+        they were reserved in, so PaUtil_ArenaAllocateMemory() can't fail. */
+    if( !PaUtil_AllocateArena( &bp->arena ) )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    if( inputChannelCount > 0 )
+    {
+        bp->tempInputBuffer = PaUtil_ArenaAllocateMemory( &bp->arena, tempInputBufferSize );
+
+        if( userInputSampleFormat & paNonInterleaved )
         {
-            result = paInsufficientMemory;
-            goto error;
+            bp->tempInputBufferPtrs =
+                (void **)PaUtil_ArenaAllocateMemory( &bp->arena, sizeof(void*)*inputChannelCount );
         }
 
-        if( bp->framesInTempOutputBuffer > 0 )
-            memset( bp->tempOutputBuffer, 0, tempOutputBufferSize );
-        
+        bp->hostInputChannels[0] = (PaUtilChannelDescriptor*)
+                PaUtil_ArenaAllocateMemory( &bp->arena, sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2 );
+        bp->hostInputChannels[1] = &bp->hostInputChannels[0][inputChannelCount];
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        bp->tempOutputBuffer = PaUtil_ArenaAllocateMemory( &bp->arena, tempOutputBufferSize );
+
         if( userOutputSampleFormat & paNonInterleaved )
         {
             bp->tempOutputBufferPtrs =
-                (void **)PaUtil_AllocateMemory( sizeof(void*)*outputChannelCount );
-            if( bp->tempOutputBufferPtrs == 0 )
-            {
-                result = paInsufficientMemory;
-                goto error;
-            }
+                (void **)PaUtil_ArenaAllocateMemory( &bp->arena, sizeof(void*)*outputChannelCount );
         }
 
         bp->hostOutputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateMemory( sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
-        if( bp->hostOutputChannels[0] == 0 )
-        {                                                                     
-            result = paInsufficientMemory;
-            goto error;
-        }
-
+                PaUtil_ArenaAllocateMemory( &bp->arena, sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
         bp->hostOutputChannels[1] = &bp->hostOutputChannels[0][outputChannelCount];
+
+        if( (streamFlags & paDitherNoiseShaped) && !(streamFlags & paDitherOff) )
+        {
+            int i;
+
+            bp->outputDitherGenerators = (PaUtilTriangularDitherGenerator*)
+                    PaUtil_ArenaAllocateMemory( &bp->arena, sizeof(PaUtilTriangularDitherGenerator) * outputChannelCount );
+
+            for( i = 0; i < outputChannelCount; ++i )
+                PaUtil_InitializeNoiseShapedDitherState( &bp->outputDitherGenerators[i], i );
+        }
     }
 
     PaUtil_InitializeTriangularDitherState( &bp->ditherGenerator );
@@ -361,23 +370,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
     return result;
 
 error:
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
-
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
-
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
-
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
-
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
-
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+    PaUtil_FreeArena( &bp->arena );
 
     return result;
 }
@@ -385,23 +378,7 @@ error:
 
 void PaUtil_TerminateBufferProcessor( PaUtilBufferProcessor* bp )
 {
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
-
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
-
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
-        
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
-
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
-
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+    PaUtil_FreeArena( &bp->arena );
 }
 
 
@@ -425,6 +402,16 @@ void PaUtil_ResetBufferProcessor( PaUtilBufferProcessor* bp )
             bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * bp->outputChannelCount;
         memset( bp->tempOutputBuffer, 0, tempOutputBufferSize );
     }
+
+    if( bp->outputDitherGenerators )
+    {
+        unsigned int i;
+
+        /* the noise shaping filters hold the quantization error of the last
+            samples before the reset, which doesn't belong to the new ones */
+        for( i = 0; i < bp->outputChannelCount; ++i )
+            PaUtil_InitializeNoiseShapedDitherState( &bp->outputDitherGenerators[i], (int)i );
+    }
 }
 
 
@@ -687,11 +674,34 @@ void PaUtil_BeginBufferProcessing( PaUtilBufferProcessor* bp,
 
     bp->callbackStatusFlags = callbackStatusFlags;
 
+    if( callbackStatusFlags & (paInputUnderflow | paInputOverflow | paOutputUnderflow | paOutputOverflow) )
+    {
+        PaTrace_AddInstantEvent( paTraceXrun, (long)callbackStatusFlags, 0 );
+    }
+
     bp->hostInputFrameCount[1] = 0;
     bp->hostOutputFrameCount[1] = 0;
 }
 
 
+/*
+    CallStreamCallback() calls the stream callback, recording its duration as
+    a trace event when PA_TRACE_EVENTS is enabled.
+*/
+static int CallStreamCallback( PaUtilBufferProcessor *bp,
+        const void *userInput, void *userOutput, unsigned long frameCount )
+{
+    int result;
+
+    PaTrace_BeginEvent( paTraceCallback, (long)frameCount, (long)bp->callbackStatusFlags );
+    result = bp->streamCallback( userInput, userOutput,
+            frameCount, bp->timeInfo, bp->callbackStatusFlags, bp->userData );
+    PaTrace_EndEvent( paTraceCallback, (long)frameCount, (long)result );
+
+    return result;
+}
+
+
 /*
     NonAdaptingProcess() is a simple buffer copying adaptor that can handle
     both full and half duplex copies. It processes framesToProcess frames,
@@ -870,8 +880,7 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 }
             }
         
-            *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                    frameCount, bp->timeInfo, bp->callbackStatusFlags, bp->userData );
+            *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, frameCount );
 
             if( *streamCallbackResult == paAbort )
             {
@@ -917,7 +926,7 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                         	bp->outputConverter(    hostOutputChannels[i].data,
                                                 	hostOutputChannels[i].stride,
                                                 	srcBytePtr, srcSampleStrideSamples,
-                                                	frameCount, &bp->ditherGenerator );
+                                                	frameCount, PA_OUTPUT_DITHER_GENERATOR_( bp, i ) );
 
                         	srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
@@ -964,6 +973,61 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
 }
 
 
+/*
+    ZeroCopyUserBuffer() returns the buffer to pass to the streamCallback so
+    that it runs directly on the host buffers described by hostChannels, or 0
+    if the host buffers can't be passed to the callback because the sample
+    format or the buffer layout differ. The conditions are the same as for
+    skipping conversion in NonAdaptingProcess(). For non-interleaved user
+    buffers the host pointers are stored in userBufferPtrs.
+
+    The adapting processors use this to skip the temporary buffers whenever
+    they are empty and a whole user buffer is available in the host buffer,
+    which is always the case when the host buffer size is a multiple of the
+    user buffer size.
+*/
+static void *ZeroCopyUserBuffer( PaUtilChannelDescriptor *hostChannels, unsigned int channelCount,
+        int formatIsEqualToHost, int userIsInterleaved, int hostIsInterleaved, void **userBufferPtrs )
+{
+    unsigned int i;
+
+    if( !formatIsEqualToHost || !hostChannels[0].data )
+        return 0;
+
+    if( userIsInterleaved )
+    {
+        if( hostIsInterleaved && hostChannels[0].stride == channelCount )
+            return hostChannels[0].data;
+    }
+    else if( !hostIsInterleaved )
+    {
+        for( i=0; i<channelCount; ++i )
+        {
+            if( hostChannels[i].stride != 1 )
+                return 0;
+
+            userBufferPtrs[i] = hostChannels[i].data;
+        }
+        return userBufferPtrs;
+    }
+
+    return 0;
+}
+
+
+static void AdvanceHostChannels( PaUtilChannelDescriptor *hostChannels, unsigned int channelCount,
+        unsigned int bytesPerHostSample, unsigned long frameCount )
+{
+    unsigned int i;
+
+    for( i=0; i<channelCount; ++i )
+    {
+        hostChannels[i].data = ((unsigned char*)hostChannels[i].data) +
+                frameCount * hostChannels[i].stride * bytesPerHostSample;
+    }
+}
+
+
 /*
     AdaptingInputOnlyProcess() is a half duplex input buffer processor. It
     converts data from the input buffers into the temporary input buffer,
@@ -987,6 +1051,33 @@ static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
 
     do
     {
+        if( bp->framesInTempInputBuffer == 0 && framesToGo >= bp->framesPerUserBuffer
+                && *streamCallbackResult == paContinue )
+        {
+            userInput = ZeroCopyUserBuffer( hostInputChannels, bp->inputChannelCount,
+                    bp->userInputSampleFormatIsEqualToHost, bp->userInputIsInterleaved,
+                    bp->hostInputIsInterleaved, bp->tempInputBufferPtrs );
+
+            if( userInput )
+            {
+                /* a whole user buffer is available, pass it to the callback in place */
+                frameCount = bp->framesPerUserBuffer;
+
+                bp->timeInfo->outputBufferDacTime = 0;
+
+                *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, frameCount );
+
+                bp->timeInfo->inputBufferAdcTime += frameCount * bp->samplePeriod;
+
+                AdvanceHostChannels( hostInputChannels, bp->inputChannelCount,
+                        bp->bytesPerHostInputSample, frameCount );
+
+                framesProcessed += frameCount;
+                framesToGo -= frameCount;
+                continue;
+            }
+        }
+
         frameCount = ( bp->framesInTempInputBuffer + framesToGo > bp->framesPerUserBuffer )
                 ? ( bp->framesPerUserBuffer - bp->framesInTempInputBuffer )
                 : framesToGo;
@@ -1052,9 +1143,7 @@ static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
             {
                 bp->timeInfo->outputBufferDacTime = 0;
 
-                *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                        bp->framesPerUserBuffer, bp->timeInfo,
-                        bp->callbackStatusFlags, bp->userData );
+                *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, bp->framesPerUserBuffer );
 
                 bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
             }
@@ -1092,6 +1181,40 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
 
     do
     {
+        if( bp->framesInTempOutputBuffer == 0 && framesToGo >= bp->framesPerUserBuffer
+                && *streamCallbackResult == paContinue )
+        {
+            userInput = 0;
+            userOutput = ZeroCopyUserBuffer( hostOutputChannels, bp->outputChannelCount,
+                    bp->userOutputSampleFormatIsEqualToHost, bp->userOutputIsInterleaved,
+                    bp->hostOutputIsInterleaved, bp->tempOutputBufferPtrs );
+
+            if( userOutput )
+            {
+                /* let the callback render a whole user buffer in place */
+                frameCount = bp->framesPerUserBuffer;
+
+                bp->timeInfo->inputBufferAdcTime = 0;
+
+                *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, frameCount );
+
+                if( *streamCallbackResult == paAbort )
+                {
+                    /* disregard the callback's output, the host buffer is zeroed below */
+                    continue;
+                }
+
+                bp->timeInfo->outputBufferDacTime += frameCount * bp->samplePeriod;
+
+                AdvanceHostChannels( hostOutputChannels, bp->outputChannelCount,
+                        bp->bytesPerHostOutputSample, frameCount );
+
+                framesProcessed += frameCount;
+                framesToGo -= frameCount;
+                continue;
+            }
+        }
+
         if( bp->framesInTempOutputBuffer == 0 && *streamCallbackResult == paContinue )
         {
             userInput = 0;
@@ -1114,9 +1237,7 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
 
             bp->timeInfo->inputBufferAdcTime = 0;
             
-            *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                    bp->framesPerUserBuffer, bp->timeInfo,
-                    bp->callbackStatusFlags, bp->userData );
+            *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, bp->framesPerUserBuffer );
 
             if( *streamCallbackResult == paAbort )
             {
@@ -1160,7 +1281,7 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
                 bp->outputConverter(    hostOutputChannels[i].data,
                                         hostOutputChannels[i].stride,
                                         srcBytePtr, srcSampleStrideSamples,
-                                        frameCount, &bp->ditherGenerator );
+                                        frameCount, PA_OUTPUT_DITHER_GENERATOR_( bp, i ) );
 
                 srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
@@ -1258,7 +1379,7 @@ static void CopyTempOutputBuffersToHostOutputBuffers( PaUtilBufferProcessor *bp)
              bp->outputConverter(    hostOutputChannels[i].data,
                                      hostOutputChannels[i].stride,
                                      srcBytePtr, srcSampleStrideSamples,
-                                     frameCount, &bp->ditherGenerator );
+                                     frameCount, PA_OUTPUT_DITHER_GENERATOR_( bp, i ) );
 
              srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
@@ -1343,6 +1464,62 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
         }          
 
 
+        /* run the callback in place when both temp buffers are empty and a whole user
+            buffer is available in the current input and output host buffers */
+        if( bp->framesInTempInputBuffer == 0 && bp->framesInTempOutputBuffer == 0
+                && *streamCallbackResult == paContinue )
+        {
+            int inputIndex = ( bp->hostInputFrameCount[0] > 0 ) ? 0 : 1;
+            int outputIndex = ( bp->hostOutputFrameCount[0] > 0 ) ? 0 : 1;
+
+            if( bp->hostInputFrameCount[inputIndex] >= bp->framesPerUserBuffer
+                    && bp->hostOutputFrameCount[outputIndex] >= bp->framesPerUserBuffer )
+            {
+                hostInputChannels = bp->hostInputChannels[inputIndex];
+                hostOutputChannels = bp->hostOutputChannels[outputIndex];
+
+                userInput = ZeroCopyUserBuffer( hostInputChannels, bp->inputChannelCount,
+                        bp->userInputSampleFormatIsEqualToHost, bp->userInputIsInterleaved,
+                        bp->hostInputIsInterleaved, bp->tempInputBufferPtrs );
+                userOutput = ZeroCopyUserBuffer( hostOutputChannels, bp->outputChannelCount,
+                        bp->userOutputSampleFormatIsEqualToHost, bp->userOutputIsInterleaved,
+                        bp->hostOutputIsInterleaved, bp->tempOutputBufferPtrs );
+
+                if( userInput && userOutput )
+                {
+                    frameCount = bp->framesPerUserBuffer;
+
+                    *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, frameCount );
+
+                    bp->timeInfo->inputBufferAdcTime += frameCount * bp->samplePeriod;
+                    bp->timeInfo->outputBufferDacTime += frameCount * bp->samplePeriod;
+
+                    if( *streamCallbackResult == paAbort )
+                    {
+                        /* disregard the callback's output */
+                        for( i=0; i<bp->outputChannelCount; ++i )
+                        {
+                            bp->outputZeroer(   hostOutputChannels[i].data,
+                                                hostOutputChannels[i].stride,
+                                                frameCount );
+                        }
+                    }
+
+                    AdvanceHostChannels( hostInputChannels, bp->inputChannelCount,
+                            bp->bytesPerHostInputSample, frameCount );
+                    AdvanceHostChannels( hostOutputChannels, bp->outputChannelCount,
+                            bp->bytesPerHostOutputSample, frameCount );
+
+                    bp->hostInputFrameCount[inputIndex] -= frameCount;
+                    bp->hostOutputFrameCount[outputIndex] -= frameCount;
+
+                    framesAvailable -= frameCount;
+                    framesProcessed += frameCount;
+                    continue;
+                }
+            }
+        }
+
         /* copy frames from host to user input buffers */
         while( bp->framesInTempInputBuffer < bp->framesPerUserBuffer &&
                 ((bp->hostInputFrameCount[0] + bp->hostInputFrameCount[1]) > 0) )
@@ -1448,9 +1625,7 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
 
                 /* call streamCallback */
 
-                *streamCallbackResult = bp->streamCallback( userInput, userOutput,
-                        bp->framesPerUserBuffer, bp->timeInfo,
-                        bp->callbackStatusFlags, bp->userData );
+                *streamCallbackResult = CallStreamCallback( bp, userInput, userOutput, bp->framesPerUserBuffer );
 
                 bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
                 bp->timeInfo->outputBufferDacTime += bp->framesPerUserBuffer * bp->samplePeriod;
@@ -1498,6 +1673,10 @@ unsigned long PaUtil_EndBufferProcessing( PaUtilBufferProcessor* bp, int *stream
             || *streamCallbackResult == paComplete
             || *streamCallbackResult == paAbort ); /* don't forget to pass in a valid callback result value */
 
+    PaTrace_BeginEvent( paTraceBufferProcessing,
+            (long)(bp->hostInputFrameCount[0] + bp->hostInputFrameCount[1]),
+            (long)(bp->hostOutputFrameCount[0] + bp->hostOutputFrameCount[1]) );
+
     if( bp->useNonAdaptingProcess )
     {
         if( bp->inputChannelCount != 0 && bp->outputChannelCount != 0 )
@@ -1649,6 +1828,8 @@ unsigned long PaUtil_EndBufferProcessing( PaUtilBufferProcessor* bp, int *stream
         }
     }
 
+    PaTrace_EndEvent( paTraceBufferProcessing, (long)framesProcessed, (long)*streamCallbackResult );
+
     return framesProcessed;
 }
 
@@ -1756,7 +1937,7 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
             bp->outputConverter(    hostOutputChannels[i].data,
                                     hostOutputChannels[i].stride,
                                     srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
+                                    framesToCopy, PA_OUTPUT_DITHER_GENERATOR_( bp, i ) );
 
             srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
@@ -1785,7 +1966,7 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
             bp->outputConverter(    hostOutputChannels[i].data,
                                     hostOutputChannels[i].stride,
                                     srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
+                                    framesToCopy, PA_OUTPUT_DITHER_GENERATOR_( bp, i ) );
 
 
             /* advance callers source pointer (nonInterleavedSrcPtrs[i]) */
@@ -203,6 +203,7 @@
 #include "portaudio.h"
 #include "pa_converters.h"
 #include "pa_dither.h"
+#include "pa_allocation.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -305,6 +306,11 @@ typedef struct {
                                                          */
 
     PaUtilTriangularDitherGenerator ditherGenerator;
+    PaUtilTriangularDitherGenerator *outputDitherGenerators; /**< one per output channel when
+                                                                  paDitherNoiseShaped is set, otherwise NULL */
+
+    PaUtilAllocationArena arena; /**< single aligned allocation holding the temp buffers, buffer pointer
+                                      arrays, channel descriptors and dither generators above */
 
     double samplePeriod;
 
@@ -235,3 +235,172 @@ ring_buffer_size_t PaUtil_ReadRingBuffer( PaUtilRingBuffer *rbuf, void *data, ri
     PaUtil_AdvanceRingBufferReadIndex( rbuf, numRead );
     return numRead;
 }
+
+/***************************************************************************
+ * Padded ring buffer.
+ * The indices count elements since the last flush and are only reduced
+ * modulo the buffer size when addressing it, so that writeIndex - readIndex
+ * is the number of elements in the buffer without a wrap bit. Each index is
+ * written by one side with a release store and loaded by the other with an
+ * acquire load, which orders the copies into and out of the buffer.
+ */
+ring_buffer_size_t PaUtil_InitializePaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount, void *dataPtr )
+{
+    if( ((elementCount-1) & elementCount) != 0) return -1; /* Not Power of two. */
+    rbuf->bufferSize = elementCount;
+    rbuf->buffer = (char *)dataPtr;
+    PaUtil_FlushPaddedRingBuffer( rbuf );
+    rbuf->smallMask = (elementCount)-1;
+    rbuf->elementSizeBytes = elementSizeBytes;
+    return 0;
+}
+
+/***************************************************************************
+** Clear buffer. Should only be called when buffer is NOT being read or written. */
+void PaUtil_FlushPaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf )
+{
+    rbuf->writerReadIndex = rbuf->readerWriteIndex = 0;
+    PaUtil_StoreRelease64( &rbuf->readIndex, 0 );
+    PaUtil_StoreRelease64( &rbuf->writeIndex, 0 );
+}
+
+/***************************************************************************
+** Return number of elements available for reading. */
+ring_buffer_size_t PaUtil_GetPaddedRingBufferReadAvailable( const PaUtilPaddedRingBuffer *rbuf )
+{
+    /* The read index is loaded first, so the difference can't be negative. It can exceed the
+       buffer size if the caller is neither the reader nor the writer and both advanced in
+       between, so it is clamped. */
+    ring_buffer_index_t readIndex = PaUtil_LoadAcquire64( &rbuf->readIndex );
+    ring_buffer_index_t available = PaUtil_LoadAcquire64( &rbuf->writeIndex ) - readIndex;
+    return available > (ring_buffer_index_t)rbuf->bufferSize ? rbuf->bufferSize : (ring_buffer_size_t)available;
+}
+
+/***************************************************************************
+** Return number of elements available for writing. */
+ring_buffer_size_t PaUtil_GetPaddedRingBufferWriteAvailable( const PaUtilPaddedRingBuffer *rbuf )
+{
+    return rbuf->bufferSize - PaUtil_GetPaddedRingBufferReadAvailable( rbuf );
+}
+
+/***************************************************************************
+** Split elementCount elements from index into one or two contiguous regions. */
+static void GetPaddedRingBufferRegions( PaUtilPaddedRingBuffer *rbuf, ring_buffer_index_t index, ring_buffer_size_t elementCount,
+                                        void **dataPtr1, ring_buffer_size_t *sizePtr1,
+                                        void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    ring_buffer_size_t offset = (ring_buffer_size_t)( index & (ring_buffer_index_t)rbuf->smallMask );
+    *dataPtr1 = &rbuf->buffer[offset*rbuf->elementSizeBytes];
+    if( (offset + elementCount) > rbuf->bufferSize )
+    {
+        /* Data in two blocks that wrap the buffer. */
+        ring_buffer_size_t firstHalf = rbuf->bufferSize - offset;
+        *sizePtr1 = firstHalf;
+        *dataPtr2 = &rbuf->buffer[0];
+        *sizePtr2 = elementCount - firstHalf;
+    }
+    else
+    {
+        *sizePtr1 = elementCount;
+        *dataPtr2 = NULL;
+        *sizePtr2 = 0;
+    }
+}
+
+/***************************************************************************
+** Get address of region(s) to which we can write data.
+** Returns room available to be written or elementCount, whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_GetPaddedRingBufferWriteRegions( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount,
+                                       void **dataPtr1, ring_buffer_size_t *sizePtr1,
+                                       void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    /* only the writer stores writeIndex, so it can be read without ordering */
+    ring_buffer_index_t writeIndex = rbuf->writeIndex;
+    ring_buffer_size_t available = rbuf->bufferSize - (ring_buffer_size_t)( writeIndex - rbuf->writerReadIndex );
+    if( elementCount > available )
+    {
+        /* the acquire load orders the reader's copies out of the buffer before our writes into it */
+        rbuf->writerReadIndex = PaUtil_LoadAcquire64( &rbuf->readIndex );
+        available = rbuf->bufferSize - (ring_buffer_size_t)( writeIndex - rbuf->writerReadIndex );
+        if( elementCount > available ) elementCount = available;
+    }
+    GetPaddedRingBufferRegions( rbuf, writeIndex, elementCount, dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+    return elementCount;
+}
+
+/***************************************************************************
+*/
+ring_buffer_size_t PaUtil_AdvancePaddedRingBufferWriteIndex( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount )
+{
+    ring_buffer_index_t writeIndex = rbuf->writeIndex + elementCount;
+    /* the release store makes the written data visible before the new index */
+    PaUtil_StoreRelease64( &rbuf->writeIndex, writeIndex );
+    return (ring_buffer_size_t)( writeIndex & (ring_buffer_index_t)rbuf->smallMask );
+}
+
+/***************************************************************************
+** Get address of region(s) from which we can read data.
+** Returns room available to be read or elementCount, whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_GetPaddedRingBufferReadRegions( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount,
+                                void **dataPtr1, ring_buffer_size_t *sizePtr1,
+                                void **dataPtr2, ring_buffer_size_t *sizePtr2 )
+{
+    /* only the reader stores readIndex, so it can be read without ordering */
+    ring_buffer_index_t readIndex = rbuf->readIndex;
+    ring_buffer_size_t available = (ring_buffer_size_t)( rbuf->readerWriteIndex - readIndex );
+    if( elementCount > available )
+    {
+        /* the acquire load orders the writer's copies into the buffer before our reads from it */
+        rbuf->readerWriteIndex = PaUtil_LoadAcquire64( &rbuf->writeIndex );
+        available = (ring_buffer_size_t)( rbuf->readerWriteIndex - readIndex );
+        if( elementCount > available ) elementCount = available;
+    }
+    GetPaddedRingBufferRegions( rbuf, readIndex, elementCount, dataPtr1, sizePtr1, dataPtr2, sizePtr2 );
+    return elementCount;
+}
+
+/***************************************************************************
+*/
+ring_buffer_size_t PaUtil_AdvancePaddedRingBufferReadIndex( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount )
+{
+    ring_buffer_index_t readIndex = rbuf->readIndex + elementCount;
+    /* the release store completes our reads from the buffer before the writer may reuse it */
+    PaUtil_StoreRelease64( &rbuf->readIndex, readIndex );
+    return (ring_buffer_size_t)( readIndex & (ring_buffer_index_t)rbuf->smallMask );
+}
+
+/***************************************************************************
+** Return elements written. */
+ring_buffer_size_t PaUtil_WritePaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf, const void *data, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t size1, size2, numWritten;
+    void *data1, *data2;
+    numWritten = PaUtil_GetPaddedRingBufferWriteRegions( rbuf, elementCount, &data1, &size1, &data2, &size2 );
+    memcpy( data1, data, size1*rbuf->elementSizeBytes );
+    if( size2 > 0 )
+    {
+        data = ((char *)data) + size1*rbuf->elementSizeBytes;
+        memcpy( data2, data, size2*rbuf->elementSizeBytes );
+    }
+    PaUtil_AdvancePaddedRingBufferWriteIndex( rbuf, numWritten );
+    return numWritten;
+}
+
+/***************************************************************************
+** Return elements read. */
+ring_buffer_size_t PaUtil_ReadPaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf, void *data, ring_buffer_size_t elementCount )
+{
+    ring_buffer_size_t size1, size2, numRead;
+    void *data1, *data2;
+    numRead = PaUtil_GetPaddedRingBufferReadRegions( rbuf, elementCount, &data1, &size1, &data2, &size2 );
+    memcpy( data, data1, size1*rbuf->elementSizeBytes );
+    if( size2 > 0 )
+    {
+        data = ((char *)data) + size1*rbuf->elementSizeBytes;
+        memcpy( data, data2, size2*rbuf->elementSizeBytes );
+    }
+    PaUtil_AdvancePaddedRingBufferReadIndex( rbuf, numRead );
+    return numRead;
+}
@@ -65,6 +65,15 @@
  The memory area used to store the buffer elements must be allocated by 
  the client prior to calling PaUtil_InitializeRingBuffer() and must outlive
  the use of the ring buffer.
+
+ PaUtilPaddedRingBuffer is a variant with the same interface whose read and
+ write indices are free running 64 bit counters, accessed with acquire and
+ release ordering instead of full memory barriers. The indices written by the
+ reader and by the writer are kept in separate cache lines, and each side keeps
+ a cached copy of the other side's index, which it only reloads when the cached
+ value doesn't allow the requested transfer. This avoids cache line traffic
+ between the two threads on every call. Prefer it where both sides transfer
+ data frequently.
  
  @note The ring buffer functions are not normally exposed in the PortAudio libraries. 
  If you want to call them then you will need to add pa_ringbuffer.c to your application source code.
@@ -83,6 +92,16 @@ typedef long ring_buffer_size_t;
 typedef long ring_buffer_size_t;
 #endif
 
+#if defined(_MSC_VER) && (_MSC_VER < 1600)
+typedef unsigned __int64 ring_buffer_index_t;
+#else
+#include <stdint.h>
+typedef uint64_t ring_buffer_index_t;
+#endif
+
+/** Separation of the reader's and the writer's fields in PaUtilPaddedRingBuffer, in bytes. */
+#define PA_RING_BUFFER_CACHE_LINE_SIZE (64)
+
 
 
 #ifdef __cplusplus
@@ -230,6 +249,85 @@ ring_buffer_size_t PaUtil_GetRingBufferReadRegions( PaUtilRingBuffer *rbuf, ring
 */
 ring_buffer_size_t PaUtil_AdvanceRingBufferReadIndex( PaUtilRingBuffer *rbuf, ring_buffer_size_t elementCount );
 
+
+typedef struct PaUtilPaddedRingBuffer
+{
+    ring_buffer_size_t  bufferSize; /**< Number of elements in FIFO. Power of 2. Set by PaUtil_InitializePaddedRingBuffer. */
+    ring_buffer_size_t  smallMask;  /**< Used for fitting indices to buffer. */
+    ring_buffer_size_t  elementSizeBytes; /**< Number of bytes per element. */
+    char  *buffer;    /**< Pointer to the buffer containing the actual data. */
+
+    char  writerPad[PA_RING_BUFFER_CACHE_LINE_SIZE];
+    ring_buffer_index_t  writeIndex;      /**< Count of elements written. Set by the writer only. */
+    ring_buffer_index_t  writerReadIndex; /**< The writer's copy of readIndex, reloaded when the buffer looks full. */
+
+    char  readerPad[PA_RING_BUFFER_CACHE_LINE_SIZE];
+    ring_buffer_index_t  readIndex;       /**< Count of elements read. Set by the reader only. */
+    ring_buffer_index_t  readerWriteIndex; /**< The reader's copy of writeIndex, reloaded when the buffer looks empty. */
+
+    char  endPad[PA_RING_BUFFER_CACHE_LINE_SIZE];
+}PaUtilPaddedRingBuffer;
+
+/** Initialize a padded ring buffer to empty state. Parameters and result are as for
+ PaUtil_InitializeRingBuffer().
+*/
+ring_buffer_size_t PaUtil_InitializePaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementSizeBytes, ring_buffer_size_t elementCount, void *dataPtr );
+
+/** Reset a padded ring buffer to empty. Should only be called when buffer is NOT being read or written. */
+void PaUtil_FlushPaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf );
+
+/** Retrieve the number of elements available in a padded ring buffer for writing.
+ May be called by the reader, the writer or a third thread, and doesn't update the cached indices.
+*/
+ring_buffer_size_t PaUtil_GetPaddedRingBufferWriteAvailable( const PaUtilPaddedRingBuffer *rbuf );
+
+/** Retrieve the number of elements available in a padded ring buffer for reading.
+ May be called by the reader, the writer or a third thread, and doesn't update the cached indices.
+*/
+ring_buffer_size_t PaUtil_GetPaddedRingBufferReadAvailable( const PaUtilPaddedRingBuffer *rbuf );
+
+/** Write data to a padded ring buffer, see PaUtil_WriteRingBuffer(). Writer only. */
+ring_buffer_size_t PaUtil_WritePaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf, const void *data, ring_buffer_size_t elementCount );
+
+/** Read data from a padded ring buffer, see PaUtil_ReadRingBuffer(). Reader only. */
+ring_buffer_size_t PaUtil_ReadPaddedRingBuffer( PaUtilPaddedRingBuffer *rbuf, void *data, ring_buffer_size_t elementCount );
+
+/** Get the region(s) of a padded ring buffer to which up to elementCount elements can be
+ written, see PaUtil_GetRingBufferWriteRegions(). Writer only.
+
+ Data may be written to the regions in place, and is published to the reader with
+ PaUtil_AdvancePaddedRingBufferWriteIndex(), so that a batch of writes costs a single
+ release store.
+
+ @return The room available to be written or elementCount, whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_GetPaddedRingBufferWriteRegions( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount,
+                                       void **dataPtr1, ring_buffer_size_t *sizePtr1,
+                                       void **dataPtr2, ring_buffer_size_t *sizePtr2 );
+
+/** Publish elementCount elements written to the regions returned by
+ PaUtil_GetPaddedRingBufferWriteRegions(). Writer only.
+
+ @return The new write index, modulo the buffer size.
+*/
+ring_buffer_size_t PaUtil_AdvancePaddedRingBufferWriteIndex( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount );
+
+/** Get the region(s) of a padded ring buffer from which up to elementCount elements can be
+ read, see PaUtil_GetRingBufferReadRegions(). Reader only.
+
+ @return The number of elements available for reading or elementCount, whichever is smaller.
+*/
+ring_buffer_size_t PaUtil_GetPaddedRingBufferReadRegions( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount,
+                                      void **dataPtr1, ring_buffer_size_t *sizePtr1,
+                                      void **dataPtr2, ring_buffer_size_t *sizePtr2 );
+
+/** Release elementCount elements read from the regions returned by
+ PaUtil_GetPaddedRingBufferReadRegions() back to the writer. Reader only.
+
+ @return The new read index, modulo the buffer size.
+*/
+ring_buffer_size_t PaUtil_AdvancePaddedRingBufferReadIndex( PaUtilPaddedRingBuffer *rbuf, ring_buffer_size_t elementCount );
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -89,6 +89,7 @@ void PaUtil_InitializeStreamRepresentation( PaUtilStreamRepresentation *streamRe
     streamRepresentation->streamFinishedCallback = 0;
 
     streamRepresentation->userData = userData;
+    streamRepresentation->cpuLoadMeasurer = 0;
 
     streamRepresentation->streamInfo.inputLatency = 0.;
     streamRepresentation->streamInfo.outputLatency = 0.;
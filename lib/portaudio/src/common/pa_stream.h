@@ -152,6 +152,8 @@ typedef struct PaUtilStreamRepresentation {
     PaStreamFinishedCallback *streamFinishedCallback;
     void *userData;
     PaStreamInfo streamInfo;
+    struct PaUtilCpuLoadMeasurer *cpuLoadMeasurer; /**< set by host APIs to the stream's measurer, used by
+                                                        Pa_GetStreamCpuLoadStats() et al. NULL if there is none */
 } PaUtilStreamRepresentation;
 
 
@@ -53,6 +53,16 @@
 #include "pa_util.h"
 #include "pa_debugprint.h"
 
+#if PA_TRACE_EVENTS
+#include "pa_ringbuffer.h"
+#include "pa_memorybarrier.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
+
 #if PA_TRACE_REALTIME_EVENTS
 
 static char const *traceTextArray[PA_MAX_TRACE_RECORDS];
@@ -227,7 +237,372 @@ void PaUtil_DiscardHighSpeedLog( LogHandle hLog )
     PaUtil_FreeMemory(pLog);
 }
 
+#endif /* TRACE_REALTIME_EVENTS */
+
+#if PA_TRACE_EVENTS
+
+/************************************************************************/
+/* Per-thread binary trace events                                       */
+/************************************************************************/
+
+#if (PA_MAX_TRACE_EVENTS_PER_THREAD & (PA_MAX_TRACE_EVENTS_PER_THREAD - 1)) != 0
+#error "PA_MAX_TRACE_EVENTS_PER_THREAD must be a power of 2"
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PA_TRACE_THREAD_LOCAL_              __declspec(thread)
+#define PA_TRACE_ATOMIC_INCREMENT_( ptr )   _InterlockedIncrement( (ptr) )
+#define PA_TRACE_COMPARE_AND_SWAP_( ptr, oldValue, newValue ) \
+    ( _InterlockedCompareExchange( (ptr), (newValue), (oldValue) ) == (oldValue) )
 #else
+#define PA_TRACE_THREAD_LOCAL_              __thread
+#define PA_TRACE_ATOMIC_INCREMENT_( ptr )   __sync_add_and_fetch( (ptr), 1 )
+#define PA_TRACE_COMPARE_AND_SWAP_( ptr, oldValue, newValue ) \
+    __sync_bool_compare_and_swap( (ptr), (oldValue), (newValue) )
+#endif
+
+typedef enum PaUtilTracePhase
+{
+    paUtilTracePhaseBegin = 0,
+    paUtilTracePhaseEnd,
+    paUtilTracePhaseInstant
+} PaUtilTracePhase;
+
+static const char traceEventPhaseChars_[] = { 'B', 'E', 'i' };
+
+typedef struct PaUtilTraceRecord
+{
+    PaUtilNanoseconds timeStamp;        /* PaUtil_GetNanoseconds() */
+    int eventId;
+    int phase;                          /* PaUtilTracePhase */
+    long arg0;
+    long arg1;
+} PaUtilTraceRecord;
+
+/* The ring of one thread. writeIndex counts the records added and is only
+    written by the owning thread, readIndex is the first record that hasn't
+    been dumped or reset and is only touched by the dumping thread. The indices
+    are kept away from the neighbouring ring's records so that its writer
+    doesn't share their cache line. A ring is owned by one thread at a time and
+    is released when that thread exits, the next thread to claim it continues
+    after the records that haven't been dumped yet. */
+typedef struct PaUtilTraceThread
+{
+    char pad[PA_RING_BUFFER_CACHE_LINE_SIZE];
+    ring_buffer_index_t writeIndex;
+    ring_buffer_index_t readIndex;
+    const char * volatile name;
+    volatile long owned;                /* 0 while free, 1 while owned, 2 while being released */
+#if defined(_WIN32)
+    HANDLE volatile owner;              /* the owning thread, to find rings of threads that have exited */
+#endif
+    PaUtilTraceRecord records[PA_MAX_TRACE_EVENTS_PER_THREAD];
+} PaUtilTraceThread;
+
+static PaUtilTraceThread traceThreads_[PA_MAX_TRACE_THREADS];
+static volatile long traceDroppedEventCount_ = 0;
+static const char *traceEventNames_[PA_MAX_TRACE_EVENT_IDS];
+
+/* the calling thread's ring, NULL before the thread's first event and if no
+    ring was free for it */
+static PA_TRACE_THREAD_LOCAL_ PaUtilTraceThread *traceThread_ = NULL;
+/* set when the calling thread found no free ring. The claim isn't retried, so
+    that the thread's later events are dropped without scanning the rings, or
+    on Windows waiting on the handles of their owners, on every event */
+static PA_TRACE_THREAD_LOCAL_ int traceThreadClaimFailed_ = 0;
+
+
+static PaUtilTraceThread *ClaimFreeTraceThread( void )
+{
+    int i;
+
+    for( i=0; i < PA_MAX_TRACE_THREADS; ++i )
+    {
+        PaUtilTraceThread *thread = &traceThreads_[i];
+        if( PA_TRACE_COMPARE_AND_SWAP_( &thread->owned, 0, 1 ) )
+        {
+            /* the previous owner's name doesn't apply to the next events */
+            thread->name = NULL;
+            return thread;
+        }
+    }
+
+    return NULL;
+}
+
+
+#if defined(_WIN32)
+
+/* Windows XP has no thread exit callback for a static library, so the rings
+    of threads that have exited are released when a thread finds none free. */
+static void ReleaseExitedTraceThreads( void )
+{
+    int i;
+
+    for( i=0; i < PA_MAX_TRACE_THREADS; ++i )
+    {
+        PaUtilTraceThread *thread = &traceThreads_[i];
+        HANDLE owner;
+
+        if( thread->owned != 1 )
+            continue;
+        PaUtil_ReadMemoryBarrier();
+        owner = thread->owner;
+
+        if( owner && WaitForSingleObject( owner, 0 ) == WAIT_OBJECT_0
+                && PA_TRACE_COMPARE_AND_SWAP_( &thread->owned, 1, 2 ) )
+        {
+            thread->owner = NULL;
+            CloseHandle( owner );
+            PaUtil_WriteMemoryBarrier();
+            thread->owned = 0;
+        }
+    }
+}
+
+
+static PaUtilTraceThread *ClaimTraceThread( void )
+{
+    PaUtilTraceThread *thread = ClaimFreeTraceThread();
+
+    if( !thread )
+    {
+        ReleaseExitedTraceThreads();
+        thread = ClaimFreeTraceThread();
+    }
+
+    if( thread )
+        thread->owner = OpenThread( SYNCHRONIZE, FALSE, GetCurrentThreadId() );
+
+    return thread;
+}
+
+#else /* !_WIN32 */
+
+static pthread_key_t traceThreadKey_;
+static pthread_once_t traceThreadKeyOnce_ = PTHREAD_ONCE_INIT;
+
+
+/* called when a thread that owns a ring exits */
+static void ReleaseTraceThread( void *thread )
+{
+    /* the ring's records stay until they are dumped */
+    PaUtil_WriteMemoryBarrier();
+    ((PaUtilTraceThread*)thread)->owned = 0;
+    traceThread_ = NULL;
+}
+
+
+static void CreateTraceThreadKey( void )
+{
+    pthread_key_create( &traceThreadKey_, ReleaseTraceThread );
+}
+
+
+static PaUtilTraceThread *ClaimTraceThread( void )
+{
+    PaUtilTraceThread *thread = ClaimFreeTraceThread();
+
+    if( thread )
+    {
+        pthread_once( &traceThreadKeyOnce_, CreateTraceThreadKey );
+        pthread_setspecific( traceThreadKey_, thread );
+    }
+
+    return thread;
+}
+
+#endif /* _WIN32 */
+
+
+static PaUtilTraceThread *GetTraceThread( void )
+{
+    if( !traceThread_ && !traceThreadClaimFailed_ )
+    {
+        traceThread_ = ClaimTraceThread();
+        traceThreadClaimFailed_ = ( traceThread_ == NULL );
+    }
+
+    return traceThread_;
+}
+
+
+static void AddTraceEvent( int phase, int eventId, long arg0, long arg1 )
+{
+    PaUtilTraceThread *thread = GetTraceThread();
+    ring_buffer_index_t writeIndex;
+    PaUtilTraceRecord *record;
+
+    if( !thread )
+    {
+        /* printed once, rather than on every dropped event of a real-time thread */
+        if( PA_TRACE_ATOMIC_INCREMENT_( &traceDroppedEventCount_ ) == 1 )
+            PaUtil_DebugPrint( "PortAudio trace: more than %d threads are adding trace events, "
+                    "events are dropped. Increase PA_MAX_TRACE_THREADS\n", PA_MAX_TRACE_THREADS );
+        return;
+    }
+
+    writeIndex = thread->writeIndex;
+    record = &thread->records[ writeIndex & (PA_MAX_TRACE_EVENTS_PER_THREAD - 1) ];
+    record->timeStamp = PaUtil_GetNanoseconds();
+    record->eventId = eventId;
+    record->phase = phase;
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+
+    /* publish the record to PaTrace_DumpEvents() */
+    PaUtil_StoreRelease64( &thread->writeIndex, writeIndex + 1 );
+}
+
+
+void PaTrace_BeginEvent( int eventId, long arg0, long arg1 )
+{
+    AddTraceEvent( paUtilTracePhaseBegin, eventId, arg0, arg1 );
+}
+
+
+void PaTrace_EndEvent( int eventId, long arg0, long arg1 )
+{
+    AddTraceEvent( paUtilTracePhaseEnd, eventId, arg0, arg1 );
+}
+
+
+void PaTrace_AddInstantEvent( int eventId, long arg0, long arg1 )
+{
+    AddTraceEvent( paUtilTracePhaseInstant, eventId, arg0, arg1 );
+}
+
+
+void PaTrace_SetEventName( int eventId, const char *name )
+{
+    if( eventId >= 0 && eventId < PA_MAX_TRACE_EVENT_IDS )
+        traceEventNames_[eventId] = name;
+}
+
+
+void PaTrace_SetThreadName( const char *name )
+{
+    PaUtilTraceThread *thread = GetTraceThread();
+    if( thread )
+        thread->name = name;
+}
+
+
+void PaTrace_ResetEvents( void )
+{
+    int i;
+
+    for( i=0; i < PA_MAX_TRACE_THREADS; ++i )
+        traceThreads_[i].readIndex = PaUtil_LoadAcquire64( &traceThreads_[i].writeIndex );
+}
+
+
+static const char *GetTraceEventName( int eventId )
+{
+    const char *name = ( eventId >= 0 && eventId < PA_MAX_TRACE_EVENT_IDS ) ? traceEventNames_[eventId] : NULL;
+    if( name )
+        return name;
+
+    switch( eventId )
+    {
+        case paTraceCallback:           return "stream callback";
+        case paTraceBufferProcessing:   return "buffer processing";
+        case paTraceHostWait:           return "host wait";
+        case paTraceXrun:               return "xrun";
+        default:                            return NULL;
+    }
+}
+
+
+/* writes s as a JSON string, names are expected to be literals so only
+    quotes, backslashes and control characters are escaped */
+static void WriteJsonString( FILE *f, const char *s )
+{
+    fputc( '"', f );
+    for( ; *s; ++s )
+    {
+        if( *s == '"' || *s == '\\' )
+            fprintf( f, "\\%c", *s );
+        else if( (unsigned char)*s < 0x20 )
+            fprintf( f, "\\u%04x", (unsigned int)(unsigned char)*s );
+        else
+            fputc( *s, f );
+    }
+    fputc( '"', f );
+}
+
+
+PaError PaTrace_DumpEvents( const char *fileName )
+{
+    int i;
+    const char *separator = "\n";
+    FILE *f;
+
+    f = fopen( fileName, "w" );
+    if( !f )
+        return paInternalError;
+
+    fprintf( f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+
+    for( i=0; i < PA_MAX_TRACE_THREADS; ++i )
+    {
+        PaUtilTraceThread *thread = &traceThreads_[i];
+        ring_buffer_index_t writeIndex = PaUtil_LoadAcquire64( &thread->writeIndex );
+        ring_buffer_index_t index = thread->readIndex;
+
+        /* the oldest slot is the next one to be written, so it is never dumped */
+        if( writeIndex - index >= PA_MAX_TRACE_EVENTS_PER_THREAD )
+            index = writeIndex - (PA_MAX_TRACE_EVENTS_PER_THREAD - 1);
+
+        if( thread->name )
+        {
+            fprintf( f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", separator, i + 1 );
+            WriteJsonString( f, thread->name );
+            fprintf( f, "}}" );
+            separator = ",\n";
+        }
+
+        for( ; index != writeIndex; ++index )
+        {
+            PaUtilTraceRecord record = thread->records[ index & (PA_MAX_TRACE_EVENTS_PER_THREAD - 1) ];
+            const char *name;
+
+            /* skip the record if the writer may have reused its slot while it was copied */
+            PaUtil_ReadMemoryBarrier();
+            if( PaUtil_LoadAcquire64( &thread->writeIndex ) - index >= PA_MAX_TRACE_EVENTS_PER_THREAD )
+                continue;
+
+            fprintf( f, "%s{\"name\":", separator );
+            name = GetTraceEventName( record.eventId );
+            if( name )
+                WriteJsonString( f, name );
+            else
+                fprintf( f, "\"event %d\"", record.eventId );
+            fprintf( f, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%d",
+                    ( record.eventId < paTraceFirstClientEvent ) ? "portaudio" : "client",
+                    traceEventPhaseChars_[record.phase],
+                    (unsigned long long)(record.timeStamp / 1000), (unsigned int)(record.timeStamp % 1000), i + 1 );
+            if( record.phase == paUtilTracePhaseInstant )
+                fprintf( f, ",\"s\":\"t\"" );
+            fprintf( f, ",\"args\":{\"arg0\":%ld,\"arg1\":%ld}}", record.arg0, record.arg1 );
+            separator = ",\n";
+        }
+
+        thread->readIndex = writeIndex;
+    }
+
+    fprintf( f, "\n],\"otherData\":{\"droppedEvents\":%ld}}\n", traceDroppedEventCount_ );
+
+    if( fclose( f ) != 0 )
+        return paInternalError;
+
+    return paNoError;
+}
+
+#endif /* PA_TRACE_EVENTS */
+
+#if !PA_TRACE_REALTIME_EVENTS && !PA_TRACE_EVENTS
 /* This stub was added so that this file will generate a symbol.
  * Otherwise linker/archiver programs will complain.
  */
@@ -235,4 +610,4 @@ int PaUtil_TraceStubToSatisfyLinker(void)
 {
 	return 0;
 }
-#endif /* TRACE_REALTIME_EVENTS */
+#endif
@@ -63,6 +63,9 @@
 
  @fn PaUtil_DumpTraceMessages
  @brief Print all messages in the trace buffer to stdout and clear the trace buffer.
+
+ A second facility records the binary trace events declared in
+ pa_trace_events.h, which is public so that clients can add their own events.
 */
 
 #ifndef PA_TRACE_REALTIME_EVENTS
@@ -73,6 +76,24 @@
 #define PA_MAX_TRACE_RECORDS      (2048)   /**< Maximum number of records stored in trace buffer */   
 #endif
 
+#include "pa_trace_events.h"
+
+#ifndef PA_MAX_TRACE_THREADS
+#define PA_MAX_TRACE_THREADS          (16)   /**< Maximum number of threads that can add trace events at the same time, a thread's ring is reused after it exits. Events from any others are dropped and counted in the dump */
+#endif
+
+#ifndef PA_MAX_TRACE_EVENTS_PER_THREAD
+#define PA_MAX_TRACE_EVENTS_PER_THREAD (4096)   /**< Size of each thread's event ring, which keeps the latest PA_MAX_TRACE_EVENTS_PER_THREAD - 1 events. Must be a power of 2 */
+#endif
+
+#ifndef PA_MAX_TRACE_EVENT_IDS
+#define PA_MAX_TRACE_EVENT_IDS        (64)   /**< Number of event ids that can be named */
+#endif
+
+#ifndef PA_TRACE_EVENTS_FILE
+#define PA_TRACE_EVENTS_FILE     "portaudio_trace.json"   /**< File that Pa_Terminate() dumps the trace events to */
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -144,11 +144,38 @@ void PaUtil_InitializeClock( void );
 
 /** Return the system time in seconds. Used to implement CPU load functions
 
+ The time is read from the same monotonic clock as PaUtil_GetNanoseconds()
+ where the platform provides one, so it isn't affected by changes to the
+ wall clock time.
+
  @see PaUtil_InitializeClock
 */
 double PaUtil_GetTime( void );
 
 
+/** An integer timestamp in nanoseconds, see PaUtil_GetNanoseconds(). */
+#if defined(_MSC_VER)
+typedef unsigned __int64 PaUtilNanoseconds;
+#else
+typedef unsigned long long PaUtilNanoseconds;
+#endif
+
+
+/** Return a monotonic timestamp in nanoseconds, with an unspecified origin.
+ This is the cheapest clock available to implementations and is intended for
+ timing intervals on real-time threads, such as CPU load measurement.
+ Timestamps should be subtracted as integers and only converted to seconds
+ with PaUtil_NanosecondsToTime() where a PaTime is needed.
+
+ @see PaUtil_InitializeClock
+*/
+PaUtilNanoseconds PaUtil_GetNanoseconds( void );
+
+
+/** Convert a PaUtilNanoseconds timestamp or interval to seconds. */
+#define PaUtil_NanosecondsToTime( nanoseconds ) ((PaTime)(nanoseconds) * 1e-9)
+
+
 /* void Pa_Sleep( long msec );  must also be implemented in per-platform .c file */
 
 
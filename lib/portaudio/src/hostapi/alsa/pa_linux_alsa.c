@@ -60,6 +60,7 @@
 #include <pthread.h>
 #include <signal.h>
 #include <time.h>
+#include <sys/time.h>
 #include <sys/mman.h>
 #include <signal.h> /* For sig_atomic_t */
 #ifdef PA_ALSA_DYNAMIC
@@ -76,6 +77,7 @@
 #include "pa_process.h"
 #include "pa_endianness.h"
 #include "pa_debugprint.h"
+#include "pa_trace.h"
 
 #include "pa_linux_alsa.h"
 
@@ -84,6 +86,11 @@
     #define SND_PCM_TSTAMP_ENABLE SND_PCM_TSTAMP_MMAP
 #endif
 
+/* Monotonic timestamps (snd_pcm_sw_params_set_tstamp_type) were added in Alsa 1.0.29 */
+#if defined(SND_LIB_VERSION) && SND_LIB_VERSION >= 0x01001d
+    #define PA_ALSA_HAVE_TSTAMP_TYPE
+#endif
+
 /* Combine version elements into a single (unsigned) integer */
 #define ALSA_VERSION_INT(major, minor, subminor)  ((major << 16) | (minor << 8) | subminor)
 
@@ -182,6 +189,9 @@ _PA_DEFINE_FUNC(snd_pcm_sw_params_set_silence_threshold);
 _PA_DEFINE_FUNC(snd_pcm_sw_params_set_silence_size);
 _PA_DEFINE_FUNC(snd_pcm_sw_params_set_xfer_align);
 _PA_DEFINE_FUNC(snd_pcm_sw_params_set_tstamp_mode);
+#ifdef PA_ALSA_HAVE_TSTAMP_TYPE
+_PA_DEFINE_FUNC(snd_pcm_sw_params_set_tstamp_type);
+#endif
 #define alsa_snd_pcm_sw_params_alloca(ptr) __alsa_snd_alloca(ptr, snd_pcm_sw_params)
 
 _PA_DEFINE_FUNC(snd_pcm_info);
@@ -462,6 +472,9 @@ static int PaAlsa_LoadLibrary()
     _PA_LOAD_FUNC(snd_pcm_sw_params_set_silence_size);
     _PA_LOAD_FUNC(snd_pcm_sw_params_set_xfer_align);
     _PA_LOAD_FUNC(snd_pcm_sw_params_set_tstamp_mode);
+#ifdef PA_ALSA_HAVE_TSTAMP_TYPE
+    _PA_LOAD_FUNC(snd_pcm_sw_params_set_tstamp_type);
+#endif
 
     _PA_LOAD_FUNC(snd_pcm_info);
     _PA_LOAD_FUNC(snd_pcm_info_sizeof);
@@ -610,6 +623,7 @@ typedef struct
     PaDeviceIndex device;     /* Keep the device index */
     int deviceIsPlug; /* Distinguish plug types from direct 'hw:' devices */
     int useReventFix; /* Alsa older than 1.0.16, plug devices need a fix */
+    int monotonicTimestamps; /* Alsa timestamps are taken from PaUtil_GetTime()'s clock rather than the wall clock */
 
     snd_pcm_t *pcm;
     snd_pcm_uframes_t framesPerPeriod, alsaBufferSize;
@@ -2122,6 +2136,18 @@ static PaError PaAlsaStreamComponent_FinishConfigure( PaAlsaStreamComponent *sel
     ENSURE_( alsa_snd_pcm_sw_params_set_xfer_align( self->pcm, swParams, 1 ), paUnanticipatedHostError );
     ENSURE_( alsa_snd_pcm_sw_params_set_tstamp_mode( self->pcm, swParams, SND_PCM_TSTAMP_ENABLE ), paUnanticipatedHostError );
 
+    /* Take timestamps from the monotonic clock, so that stream times are in the same time base as
+     * PaUtil_GetTime() and don't jump when the wall clock is set. Older Alsa versions only have wall
+     * clock timestamps. */
+    self->monotonicTimestamps = 0;
+#ifdef PA_ALSA_HAVE_TSTAMP_TYPE
+    if( alsa_snd_pcm_sw_params_set_tstamp_type
+            && alsa_snd_pcm_sw_params_set_tstamp_type( self->pcm, swParams, SND_PCM_TSTAMP_TYPE_MONOTONIC ) >= 0 )
+    {
+        self->monotonicTimestamps = 1;
+    }
+#endif
+
     /* Set the parameters! */
     ENSURE_( alsa_snd_pcm_sw_params( self->pcm, swParams ), paUnanticipatedHostError );
 
@@ -2176,6 +2202,7 @@ static PaError PaAlsaStream_Initialize( PaAlsaStream *self, PaAlsaHostApiReprese
                     self->playback.nfds ) * sizeof( struct pollfd ) ), paInsufficientMemory );
 
     PaUtil_InitializeCpuLoadMeasurer( &self->cpuLoadMeasurer, sampleRate );
+    self->streamRepresentation.cpuLoadMeasurer = &self->cpuLoadMeasurer;
     ASSERT_CALL_( PaUnixMutex_Initialize( &self->stateMtx ), paNoError );
 
 error:
@@ -3248,6 +3275,20 @@ error:
     return result;
 }
 
+/** Get the current time in the time base of the component's Alsa timestamps.
+ *
+ */
+static PaTime PaAlsaStreamComponent_GetTimestampNow( const PaAlsaStreamComponent *self )
+{
+    struct timeval tv;
+
+    if( self->monotonicTimestamps )
+        return PaUtil_GetTime();
+
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + (PaTime)tv.tv_usec / 1e6;
+}
+
 /** Recover from xrun state.
  *
  */
@@ -3255,7 +3296,6 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
 {
     PaError result = paNoError;
     snd_pcm_status_t *st;
-    PaTime now = PaUtil_GetTime();
     snd_timestamp_t t;
     int restartAlsa = 0; /* do not restart Alsa by default */
 
@@ -3267,7 +3307,7 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
         if( alsa_snd_pcm_status_get_state( st ) == SND_PCM_STATE_XRUN )
         {
             alsa_snd_pcm_status_get_trigger_tstamp( st, &t );
-            self->underrun = now * 1000 - ( (PaTime)t.tv_sec * 1000 + (PaTime)t.tv_usec / 1000 );
+            self->underrun = PaAlsaStreamComponent_GetTimestampNow( &self->playback ) * 1000 - ( (PaTime)t.tv_sec * 1000 + (PaTime)t.tv_usec / 1000 );
 
             if( !self->playback.canMmap )
             {
@@ -3287,7 +3327,7 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
         if( alsa_snd_pcm_status_get_state( st ) == SND_PCM_STATE_XRUN )
         {
             alsa_snd_pcm_status_get_trigger_tstamp( st, &t );
-            self->overrun = now * 1000 - ((PaTime) t.tv_sec * 1000 + (PaTime) t.tv_usec / 1000);
+            self->overrun = PaAlsaStreamComponent_GetTimestampNow( &self->capture ) * 1000 - ((PaTime) t.tv_sec * 1000 + (PaTime) t.tv_usec / 1000);
 
             if (!self->capture.canMmap)
             {
@@ -3805,6 +3845,8 @@ static PaError PaAlsaStream_WaitForFrames( PaAlsaStream *self, unsigned long *fr
             totalFds += self->playback.nfds;
         }
 
+        PaTrace_BeginEvent( paTraceHostWait, (long)totalFds, (long)pollTimeout );
+
 #ifdef PTHREAD_CANCELED
         if( self->callbackMode )
         {
@@ -3822,6 +3864,8 @@ static PaError PaAlsaStream_WaitForFrames( PaAlsaStream *self, unsigned long *fr
         }
 #endif
 
+        PaTrace_EndEvent( paTraceHostWait, (long)pollResults, 0 );
+
         if( pollResults < 0 )
         {
             /*  XXX: Depend on preprocessor condition? */
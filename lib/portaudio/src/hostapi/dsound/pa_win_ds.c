@@ -2039,6 +2039,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     stream->streamFlags = streamFlags;
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
 
     if( inputParameters )
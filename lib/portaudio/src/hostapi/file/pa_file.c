@@ -0,0 +1,1740 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library file host API implementation
+ * software-only devices backed by WAV and raw files, running on a
+ * simulated clock
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Ross Bencina, Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however, 
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also 
+ * requested that these non-binding requests be included along with the 
+ * license above.
+ */
+
+/** @file
+ @ingroup hostapi_src
+
+ @brief File-backed host API, for testing and benchmarking without audio hardware.
+
+ Each device is described by a PaFileDeviceConfig (see pa_file.h). Capture data is
+ read from a WAV or raw file and playback is written to one, with host buffers
+ exchanged as interleaved float32 so that the buffer processor performs all user
+ format conversion and buffer adaption, as with any other host API.
+
+ Callback streams are driven by a processing thread that waits for the simulated
+ clock before each host buffer. Blocking streams model a device buffer of
+ PA_FILE_BLOCKING_HOST_BUFFERS host buffers that is filled (input) or drained
+ (output) by the simulated clock, so reads and writes block, overflow and
+ underflow as they would with a real device. A clock rate of 0 never blocks.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#endif
+
+#include "pa_util.h"
+#include "pa_allocation.h"
+#include "pa_hostapi.h"
+#include "pa_stream.h"
+#include "pa_cpuload.h"
+#include "pa_process.h"
+#include "pa_trace.h"
+
+#include "pa_file.h"
+
+
+/* prototypes for functions declared in this file */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+PaError PaFile_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+static void Terminate( struct PaUtilHostApiRepresentation *hostApi );
+static PaError IsFormatSupported( struct PaUtilHostApiRepresentation *hostApi,
+                                  const PaStreamParameters *inputParameters,
+                                  const PaStreamParameters *outputParameters,
+                                  double sampleRate );
+static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
+                           PaStream** s,
+                           const PaStreamParameters *inputParameters,
+                           const PaStreamParameters *outputParameters,
+                           double sampleRate,
+                           unsigned long framesPerBuffer,
+                           PaStreamFlags streamFlags,
+                           PaStreamCallback *streamCallback,
+                           void *userData );
+static PaError CloseStream( PaStream* stream );
+static PaError StartStream( PaStream *stream );
+static PaError StopStream( PaStream *stream );
+static PaError AbortStream( PaStream *stream );
+static PaError IsStreamStopped( PaStream *s );
+static PaError IsStreamActive( PaStream *stream );
+static PaTime GetStreamTime( PaStream *stream );
+static double GetStreamCpuLoad( PaStream* stream );
+static PaError ReadStream( PaStream* stream, void *buffer, unsigned long frames );
+static PaError WriteStream( PaStream* stream, const void *buffer, unsigned long frames );
+static signed long GetStreamReadAvailable( PaStream* stream );
+static signed long GetStreamWriteAvailable( PaStream* stream );
+
+
+#define PA_FILE_SET_LAST_HOST_ERROR( errorCode, errorText ) \
+    PaUtil_SetLastHostErrorInfo( paFile, errorCode, errorText )
+
+/* frames per host buffer when neither the device, the stream nor the suggested latency specify one */
+#define PA_FILE_DEFAULT_FRAMES_PER_HOST_BUFFER  256
+/* device buffer size of blocking streams, in host buffers */
+#define PA_FILE_BLOCKING_HOST_BUFFERS           4
+
+
+/* ------------------------------------------------------------------------- */
+/* device configuration, set with PaFile_SetDevices() before Pa_Initialize() */
+
+static PaFileDeviceConfig *fileDeviceConfigs_ = NULL;
+static int fileDeviceConfigCount_ = 0;
+
+
+static char *CopyString( const char *s )
+{
+    char *result;
+
+    if( !s )
+        return NULL;
+
+    result = (char*)malloc( strlen( s ) + 1 );
+    if( result )
+        strcpy( result, s );
+    return result;
+}
+
+
+static void FreeDeviceConfigs( void )
+{
+    int i;
+
+    for( i = 0; i < fileDeviceConfigCount_; ++i )
+    {
+        free( (char*)fileDeviceConfigs_[i].name );
+        free( (char*)fileDeviceConfigs_[i].inputFile );
+        free( (char*)fileDeviceConfigs_[i].outputFile );
+    }
+    free( fileDeviceConfigs_ );
+
+    fileDeviceConfigs_ = NULL;
+    fileDeviceConfigCount_ = 0;
+}
+
+
+void PaFile_InitializeDeviceConfig( PaFileDeviceConfig *config )
+{
+    memset( config, 0, sizeof(PaFileDeviceConfig) );
+    config->name = "File Device";
+    config->maxInputChannels = 2;
+    config->maxOutputChannels = 2;
+    config->defaultSampleRate = 44100.;
+    config->fileSampleFormat = paFloat32;
+    config->clockRate = 1.;
+    config->randomSeed = 1;
+}
+
+
+PaError PaFile_SetDevices( const PaFileDeviceConfig *configs, int count )
+{
+    int i;
+
+    /* devices are enumerated by Pa_Initialize() */
+    if( Pa_GetHostApiCount() != paNotInitialized )
+        return paInternalError;
+
+    if( count < 0 || ( count > 0 && !configs ) )
+        return paBadBufferPtr;
+
+    FreeDeviceConfigs();
+    if( count == 0 )
+        return paNoError;
+
+    fileDeviceConfigs_ = (PaFileDeviceConfig*)malloc( sizeof(PaFileDeviceConfig) * count );
+    if( !fileDeviceConfigs_ )
+        return paInsufficientMemory;
+
+    for( i = 0; i < count; ++i )
+    {
+        PaFileDeviceConfig *config = &fileDeviceConfigs_[i];
+        *config = configs[i];
+        config->name = CopyString( configs[i].name ? configs[i].name : "File Device" );
+        config->inputFile = CopyString( configs[i].inputFile );
+        config->outputFile = CopyString( configs[i].outputFile );
+        ++fileDeviceConfigCount_;
+
+        if( !config->name || ( configs[i].inputFile && !config->inputFile ) || ( configs[i].outputFile && !config->outputFile ) )
+        {
+            FreeDeviceConfigs();
+            return paInsufficientMemory;
+        }
+    }
+
+    return paNoError;
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* sample encoding, files are always little endian */
+
+static int GetFileBytesPerSample( PaSampleFormat format )
+{
+    switch( format )
+    {
+        case paUInt8:   return 1;
+        case paInt16:   return 2;
+        case paInt24:   return 3;
+        default:        return 4; /* paInt32, paFloat32 */
+    }
+}
+
+
+static int IsWritableFileFormat( PaSampleFormat format )
+{
+    return format == paFloat32 || format == paInt32 || format == paInt24 || format == paInt16;
+}
+
+
+static float DecodeSample( const unsigned char *b, PaSampleFormat format )
+{
+    switch( format )
+    {
+        case paUInt8:
+            return (float)( (int)b[0] - 128 ) * ( 1.0f / 128.0f );
+        case paInt16:
+            return (float)(short)( b[0] | ( b[1] << 8 ) ) * ( 1.0f / 32768.0f );
+        case paInt24:
+            /* sign extend by shifting into the top of a 32 bit int */
+            return (float)( (int)( ( (unsigned int)b[0] << 8 ) | ( (unsigned int)b[1] << 16 ) | ( (unsigned int)b[2] << 24 ) ) >> 8 ) * ( 1.0f / 8388608.0f );
+        case paInt32:
+            return (float)( (double)(int)( b[0] | ( b[1] << 8 ) | ( b[2] << 16 ) | ( (unsigned int)b[3] << 24 ) ) * ( 1.0 / 2147483648.0 ) );
+        default: /* paFloat32 */
+        {
+            unsigned int bits = b[0] | ( b[1] << 8 ) | ( b[2] << 16 ) | ( (unsigned int)b[3] << 24 );
+            float value;
+            memcpy( &value, &bits, sizeof(float) );
+            return value;
+        }
+    }
+}
+
+
+/* Integer formats are scaled by the same power of two as DecodeSample(), so that integer
+    samples survive a round trip through float unchanged. */
+static void EncodeSample( float value, unsigned char *b, PaSampleFormat format )
+{
+    unsigned int bits;
+    double scale, scaled;
+    int bytes, i;
+
+    switch( format )
+    {
+        case paInt16:   scale = 32768.;         bytes = 2; break;
+        case paInt24:   scale = 8388608.;       bytes = 3; break;
+        case paInt32:   scale = 2147483648.;    bytes = 4; break;
+        default: /* paFloat32 */
+            memcpy( &bits, &value, sizeof(float) );
+            scale = 0.;
+            bytes = 4;
+            break;
+    }
+
+    if( scale > 0. )
+    {
+        /* clamp before converting to int, which is undefined out of range. NaN fails both
+            comparisons and is written as silence */
+        scaled = (double)value * scale;
+        if( scaled >= scale - 1. )
+            scaled = scale - 1.;
+        else if( scaled <= -scale )
+            scaled = -scale;
+        else if( scaled == scaled )
+            scaled = floor( scaled + 0.5 );
+        else
+            scaled = 0.;
+        bits = (unsigned int)(int)scaled;
+    }
+
+    for( i = 0; i < bytes; ++i )
+        b[i] = (unsigned char)( bits >> ( 8 * i ) );
+}
+
+
+static unsigned int ReadLE( const unsigned char *b, int bytes )
+{
+    unsigned int result = 0;
+    int i;
+
+    for( i = 0; i < bytes; ++i )
+        result |= (unsigned int)b[i] << ( 8 * i );
+    return result;
+}
+
+
+static void WriteLE( unsigned char *b, unsigned int value, int bytes )
+{
+    int i;
+
+    for( i = 0; i < bytes; ++i )
+        b[i] = (unsigned char)( value >> ( 8 * i ) );
+}
+
+
+static int HasWavExtension( const char *path )
+{
+    size_t length = strlen( path );
+    const char *extension;
+    int i;
+
+    if( length < 4 )
+        return 0;
+
+    extension = path + length - 4;
+    for( i = 0; i < 4; ++i )
+    {
+        char c = extension[i];
+        if( c >= 'A' && c <= 'Z' )
+            c = (char)( c - 'A' + 'a' );
+        if( c != ".wav"[i] )
+            return 0;
+    }
+    return 1;
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* PaFileReader - reads capture data as interleaved float */
+
+typedef struct PaFileReader
+{
+    FILE *file;
+    int channelCount;           /* channels in the file */
+    PaSampleFormat format;
+    int bytesPerFrame;
+    long dataStart;             /* file offset of the first sample */
+    double dataBytes;           /* bytes of sample data, or -1 to read until the end of the file */
+    double bytesRead;
+    int loop;
+    unsigned char *scratch;     /* encoded samples for one host buffer */
+    unsigned long scratchFrames;
+}
+PaFileReader;
+
+
+/* Parses a RIFF WAVE header, leaving the file at the start of the sample data. Sets *isWav to 0,
+    and returns paNoError, if the file isn't a WAV file. Returns paSampleFormatNotSupported for a
+    WAV file with a sample format that can't be read, and paUnanticipatedHostError for a WAV file
+    without a format or data chunk. */
+static PaError ParseWavHeader( PaFileReader *reader, int *isWav )
+{
+    unsigned char header[12], chunk[8], fmt[40];
+    int haveFormat = 0;
+
+    *isWav = 0;
+    if( fread( header, 1, 12, reader->file ) != 12 || memcmp( header, "RIFF", 4 ) != 0 || memcmp( header + 8, "WAVE", 4 ) != 0 )
+        return paNoError;
+
+    *isWav = 1;
+
+    while( fread( chunk, 1, 8, reader->file ) == 8 )
+    {
+        unsigned int chunkSize = ReadLE( chunk + 4, 4 );
+
+        if( memcmp( chunk, "fmt ", 4 ) == 0 )
+        {
+            unsigned int formatTag, bitsPerSample;
+            size_t fmtSize = chunkSize < sizeof(fmt) ? chunkSize : sizeof(fmt);
+
+            if( chunkSize < 16 || fread( fmt, 1, fmtSize, reader->file ) != fmtSize )
+                break;
+            if( chunkSize > fmtSize )
+                fseek( reader->file, (long)( chunkSize - fmtSize ), SEEK_CUR );
+            if( chunkSize & 1 )
+                fseek( reader->file, 1, SEEK_CUR );
+
+            formatTag = ReadLE( fmt, 2 );
+            reader->channelCount = (int)ReadLE( fmt + 2, 2 );
+            bitsPerSample = ReadLE( fmt + 14, 2 );
+            if( formatTag == 0xFFFE && fmtSize >= 26 ) /* WAVE_FORMAT_EXTENSIBLE, the sub format GUID starts with the format tag */
+                formatTag = ReadLE( fmt + 24, 2 );
+
+            if( formatTag == 3 && bitsPerSample == 32 )
+                reader->format = paFloat32;
+            else if( formatTag == 1 && bitsPerSample == 8 )
+                reader->format = paUInt8;
+            else if( formatTag == 1 && bitsPerSample == 16 )
+                reader->format = paInt16;
+            else if( formatTag == 1 && bitsPerSample == 24 )
+                reader->format = paInt24;
+            else if( formatTag == 1 && bitsPerSample == 32 )
+                reader->format = paInt32;
+            else
+                return paSampleFormatNotSupported;
+
+            haveFormat = reader->channelCount > 0;
+        }
+        else if( memcmp( chunk, "data", 4 ) == 0 )
+        {
+            if( !haveFormat )
+                break;
+
+            reader->dataStart = ftell( reader->file );
+            reader->dataBytes = chunkSize;
+            return paNoError;
+        }
+        else
+        {
+            fseek( reader->file, (long)( chunkSize + ( chunkSize & 1 ) ), SEEK_CUR );
+        }
+    }
+
+    PA_FILE_SET_LAST_HOST_ERROR( 0, "malformed WAV input file" );
+    return paUnanticipatedHostError;
+}
+
+
+static PaError PaFileReader_Open( PaFileReader *reader, const PaFileDeviceConfig *config, unsigned long framesPerHostBuffer )
+{
+    PaError result;
+    int isWav;
+
+    memset( reader, 0, sizeof(PaFileReader) );
+    reader->loop = config->loopInput;
+
+    if( !config->inputFile )
+        return paNoError; /* silence */
+
+    reader->file = fopen( config->inputFile, "rb" );
+    if( !reader->file )
+    {
+        PA_FILE_SET_LAST_HOST_ERROR( 0, "could not open input file" );
+        return paUnanticipatedHostError;
+    }
+
+    result = ParseWavHeader( reader, &isWav );
+    if( result != paNoError )
+        return result;
+
+    if( !isWav )
+    {
+        /* not a WAV file, read it as raw interleaved samples */
+        reader->channelCount = config->maxInputChannels;
+        reader->format = config->fileSampleFormat;
+        reader->dataStart = 0;
+        reader->dataBytes = -1;
+        fseek( reader->file, 0, SEEK_SET );
+    }
+
+    reader->bytesPerFrame = reader->channelCount * GetFileBytesPerSample( reader->format );
+    reader->scratchFrames = framesPerHostBuffer;
+    reader->scratch = (unsigned char*)PaUtil_AllocateMemory( reader->scratchFrames * reader->bytesPerFrame );
+    if( !reader->scratch )
+        return paInsufficientMemory;
+
+    return paNoError;
+}
+
+
+static void PaFileReader_Close( PaFileReader *reader )
+{
+    if( reader->file )
+        fclose( reader->file );
+    if( reader->scratch )
+        PaUtil_FreeMemory( reader->scratch );
+    memset( reader, 0, sizeof(PaFileReader) );
+}
+
+
+/* Reads up to frames from the file, returning the number read. Stops at the end of the data. */
+static unsigned long ReadFileFrames( PaFileReader *reader, unsigned long frames )
+{
+    size_t bytes = frames * reader->bytesPerFrame;
+    size_t bytesRead;
+
+    if( reader->dataBytes >= 0 && reader->bytesRead + bytes > reader->dataBytes )
+        bytes = (size_t)( reader->dataBytes - reader->bytesRead );
+
+    bytesRead = fread( reader->scratch, 1, bytes, reader->file );
+    reader->bytesRead += bytesRead;
+    return (unsigned long)( bytesRead / reader->bytesPerFrame );
+}
+
+
+/* Reads frames into dest as interleaved float with channelCount channels. Channels that aren't in the file, and frames after the end of a file that doesn't loop, are silent. */
+static void PaFileReader_Read( PaFileReader *reader, float *dest, unsigned long frames, int channelCount )
+{
+    const int bytesPerSample = reader->file ? GetFileBytesPerSample( reader->format ) : 0;
+    const int copyChannels = reader->channelCount < channelCount ? reader->channelCount : channelCount;
+
+    while( frames > 0 )
+    {
+        unsigned long chunk = frames < reader->scratchFrames ? frames : reader->scratchFrames;
+        unsigned long framesRead = reader->file ? ReadFileFrames( reader, chunk ) : 0;
+        unsigned long i;
+        int ch;
+
+        if( framesRead == 0 && reader->file && reader->loop && reader->bytesRead > 0 )
+        {
+            /* rewind, only if the previous pass read something so that an empty file can't spin */
+            fseek( reader->file, reader->dataStart, SEEK_SET );
+            reader->bytesRead = 0;
+            framesRead = ReadFileFrames( reader, chunk );
+        }
+
+        if( framesRead == 0 )
+        {
+            memset( dest, 0, sizeof(float) * frames * channelCount );
+            return;
+        }
+
+        for( i = 0; i < framesRead; ++i )
+        {
+            const unsigned char *src = reader->scratch + i * reader->bytesPerFrame;
+            for( ch = 0; ch < copyChannels; ++ch )
+                dest[ch] = DecodeSample( src + ch * bytesPerSample, reader->format );
+            for( ; ch < channelCount; ++ch )
+                dest[ch] = 0.0f;
+            dest += channelCount;
+        }
+
+        frames -= framesRead;
+    }
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* PaFileWriter - writes playback from interleaved float */
+
+typedef struct PaFileWriter
+{
+    FILE *file;
+    int isWav;
+    int channelCount;
+    PaSampleFormat format;
+    int bytesPerFrame;
+    double dataBytes;
+    unsigned char *scratch;     /* encoded samples for one host buffer */
+    unsigned long scratchFrames;
+}
+PaFileWriter;
+
+
+static void WriteWavHeader( PaFileWriter *writer, double sampleRate )
+{
+    unsigned char header[44];
+    unsigned int dataBytes = writer->dataBytes < 0xFFFFFFFF - 36 ? (unsigned int)writer->dataBytes : 0xFFFFFFFF - 36;
+    unsigned int bytesPerSample = (unsigned int)GetFileBytesPerSample( writer->format );
+
+    memcpy( header, "RIFF", 4 );
+    WriteLE( header + 4, 36 + dataBytes, 4 );
+    memcpy( header + 8, "WAVEfmt ", 8 );
+    WriteLE( header + 16, 16, 4 );
+    WriteLE( header + 20, writer->format == paFloat32 ? 3 : 1, 2 );
+    WriteLE( header + 22, (unsigned int)writer->channelCount, 2 );
+    WriteLE( header + 24, (unsigned int)sampleRate, 4 );
+    WriteLE( header + 28, (unsigned int)sampleRate * writer->bytesPerFrame, 4 );
+    WriteLE( header + 32, (unsigned int)writer->bytesPerFrame, 2 );
+    WriteLE( header + 34, bytesPerSample * 8, 2 );
+    memcpy( header + 36, "data", 4 );
+    WriteLE( header + 40, dataBytes, 4 );
+
+    fseek( writer->file, 0, SEEK_SET );
+    fwrite( header, 1, sizeof(header), writer->file );
+}
+
+
+static PaError PaFileWriter_Open( PaFileWriter *writer, const PaFileDeviceConfig *config, int channelCount, double sampleRate, unsigned long framesPerHostBuffer )
+{
+    memset( writer, 0, sizeof(PaFileWriter) );
+    writer->channelCount = channelCount;
+    writer->format = IsWritableFileFormat( config->fileSampleFormat ) ? config->fileSampleFormat : paFloat32;
+    writer->bytesPerFrame = channelCount * GetFileBytesPerSample( writer->format );
+
+    if( !config->outputFile )
+        return paNoError; /* discard */
+
+    writer->file = fopen( config->outputFile, "wb" );
+    if( !writer->file )
+    {
+        PA_FILE_SET_LAST_HOST_ERROR( 0, "could not open output file" );
+        return paUnanticipatedHostError;
+    }
+
+    writer->isWav = HasWavExtension( config->outputFile );
+    if( writer->isWav )
+        WriteWavHeader( writer, sampleRate ); /* rewritten with the data size when the file is closed */
+
+    writer->scratchFrames = framesPerHostBuffer;
+    writer->scratch = (unsigned char*)PaUtil_AllocateMemory( writer->scratchFrames * writer->bytesPerFrame );
+    if( !writer->scratch )
+        return paInsufficientMemory;
+
+    return paNoError;
+}
+
+
+static void PaFileWriter_Close( PaFileWriter *writer, double sampleRate )
+{
+    if( writer->file )
+    {
+        if( writer->isWav )
+            WriteWavHeader( writer, sampleRate );
+        fclose( writer->file );
+    }
+    if( writer->scratch )
+        PaUtil_FreeMemory( writer->scratch );
+    memset( writer, 0, sizeof(PaFileWriter) );
+}
+
+
+/* Writes frames of interleaved float from src, or silence if src is NULL. */
+static void PaFileWriter_Write( PaFileWriter *writer, const float *src, unsigned long frames )
+{
+    const int bytesPerSample = GetFileBytesPerSample( writer->format );
+
+    if( !writer->file )
+        return;
+
+    while( frames > 0 )
+    {
+        unsigned long chunk = frames < writer->scratchFrames ? frames : writer->scratchFrames;
+        size_t bytes = chunk * writer->bytesPerFrame;
+
+        if( src )
+        {
+            unsigned long i;
+            for( i = 0; i < chunk * writer->channelCount; ++i )
+                EncodeSample( src[i], writer->scratch + i * bytesPerSample, writer->format );
+            src += chunk * writer->channelCount;
+        }
+        else
+        {
+            memset( writer->scratch, 0, bytes ); /* zero in all of the writable formats */
+        }
+
+        fwrite( writer->scratch, 1, bytes, writer->file );
+        writer->dataBytes += bytes;
+        frames -= chunk;
+    }
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* threads and sleeping */
+
+#ifdef _WIN32
+typedef HANDLE PaFileThread;
+#define PA_FILE_THREAD_FUNCTION unsigned __stdcall
+#define PA_FILE_THREAD_RETURN   0
+#else
+typedef pthread_t PaFileThread;
+#define PA_FILE_THREAD_FUNCTION void*
+#define PA_FILE_THREAD_RETURN   NULL
+#endif
+
+
+static void SleepSeconds( double seconds )
+{
+    if( seconds <= 0. )
+        return;
+#ifdef _WIN32
+    Sleep( (DWORD)( seconds * 1000. + 0.5 ) );
+#else
+    {
+        struct timespec remaining;
+        remaining.tv_sec = (time_t)seconds;
+        remaining.tv_nsec = (long)( ( seconds - (double)remaining.tv_sec ) * 1e9 );
+        while( nanosleep( &remaining, &remaining ) != 0 && errno == EINTR )
+            ;
+    }
+#endif
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* PaFileHostApiRepresentation - host api datastructure specific to this implementation */
+
+typedef struct
+{
+    PaUtilHostApiRepresentation inheritedHostApiRep;
+    PaUtilStreamInterface callbackStreamInterface;
+    PaUtilStreamInterface blockingStreamInterface;
+
+    PaUtilAllocationGroup *allocations;
+
+    PaFileDeviceConfig *deviceConfigs;  /* one per device, owned by allocations */
+}
+PaFileHostApiRepresentation;
+
+
+static char *GroupCopyString( PaUtilAllocationGroup *allocations, const char *s )
+{
+    char *result;
+
+    if( !s )
+        return NULL;
+
+    result = (char*)PaUtil_GroupAllocateMemory( allocations, (long)strlen( s ) + 1 );
+    if( result )
+        strcpy( result, s );
+    return result;
+}
+
+
+static unsigned long GetDefaultFramesPerHostBuffer( const PaFileDeviceConfig *config )
+{
+    return config->framesPerHostBuffer ? config->framesPerHostBuffer : PA_FILE_DEFAULT_FRAMES_PER_HOST_BUFFER;
+}
+
+
+PaError PaFile_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex hostApiIndex )
+{
+    PaError result = paNoError;
+    int i, deviceCount;
+    PaFileHostApiRepresentation *fileHostApi;
+    PaDeviceInfo *deviceInfoArray;
+    PaFileDeviceConfig defaultConfig;
+    const PaFileDeviceConfig *configs;
+
+    fileHostApi = (PaFileHostApiRepresentation*)PaUtil_AllocateMemory( sizeof(PaFileHostApiRepresentation) );
+    if( !fileHostApi )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    fileHostApi->allocations = PaUtil_CreateAllocationGroup();
+    if( !fileHostApi->allocations )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    if( fileDeviceConfigCount_ > 0 )
+    {
+        configs = fileDeviceConfigs_;
+        deviceCount = fileDeviceConfigCount_;
+    }
+    else
+    {
+        PaFile_InitializeDeviceConfig( &defaultConfig );
+        configs = &defaultConfig;
+        deviceCount = 1;
+    }
+
+    *hostApi = &fileHostApi->inheritedHostApiRep;
+    (*hostApi)->info.structVersion = 1;
+    (*hostApi)->info.type = paFile;
+    (*hostApi)->info.name = "File";
+
+    (*hostApi)->info.defaultInputDevice = paNoDevice;
+    (*hostApi)->info.defaultOutputDevice = paNoDevice;
+
+    (*hostApi)->info.deviceCount = 0;
+
+    (*hostApi)->deviceInfos = (PaDeviceInfo**)PaUtil_GroupAllocateMemory(
+            fileHostApi->allocations, sizeof(PaDeviceInfo*) * deviceCount );
+    if( !(*hostApi)->deviceInfos )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    /* allocate all device info structs in a contiguous block */
+    deviceInfoArray = (PaDeviceInfo*)PaUtil_GroupAllocateMemory(
+            fileHostApi->allocations, sizeof(PaDeviceInfo) * deviceCount );
+    fileHostApi->deviceConfigs = (PaFileDeviceConfig*)PaUtil_GroupAllocateMemory(
+            fileHostApi->allocations, sizeof(PaFileDeviceConfig) * deviceCount );
+    if( !deviceInfoArray || !fileHostApi->deviceConfigs )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    for( i=0; i < deviceCount; ++i )
+    {
+        PaDeviceInfo *deviceInfo = &deviceInfoArray[i];
+        PaFileDeviceConfig *config = &fileHostApi->deviceConfigs[i];
+        double hostBufferSeconds;
+
+        /* copy the configuration so that it stays valid if PaFile_SetDevices() is called after Pa_Terminate() */
+        *config = configs[i];
+        config->name = GroupCopyString( fileHostApi->allocations, configs[i].name );
+        config->inputFile = GroupCopyString( fileHostApi->allocations, configs[i].inputFile );
+        config->outputFile = GroupCopyString( fileHostApi->allocations, configs[i].outputFile );
+        if( !config->name || ( configs[i].inputFile && !config->inputFile ) || ( configs[i].outputFile && !config->outputFile ) )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        if( config->defaultSampleRate <= 0. )
+            config->defaultSampleRate = 44100.;
+        if( config->clockRate < 0. )
+            config->clockRate = 0.;
+
+        hostBufferSeconds = (double)GetDefaultFramesPerHostBuffer( config ) / config->defaultSampleRate;
+
+        deviceInfo->structVersion = 2;
+        deviceInfo->hostApi = hostApiIndex;
+        deviceInfo->name = config->name;
+
+        deviceInfo->maxInputChannels = config->maxInputChannels;
+        deviceInfo->maxOutputChannels = config->maxOutputChannels;
+
+        deviceInfo->defaultLowInputLatency = hostBufferSeconds;
+        deviceInfo->defaultLowOutputLatency = hostBufferSeconds;
+        deviceInfo->defaultHighInputLatency = hostBufferSeconds * PA_FILE_BLOCKING_HOST_BUFFERS;
+        deviceInfo->defaultHighOutputLatency = hostBufferSeconds * PA_FILE_BLOCKING_HOST_BUFFERS;
+
+        deviceInfo->defaultSampleRate = config->defaultSampleRate;
+
+        if( config->maxInputChannels > 0 && (*hostApi)->info.defaultInputDevice == paNoDevice )
+            (*hostApi)->info.defaultInputDevice = i;
+        if( config->maxOutputChannels > 0 && (*hostApi)->info.defaultOutputDevice == paNoDevice )
+            (*hostApi)->info.defaultOutputDevice = i;
+
+        (*hostApi)->deviceInfos[i] = deviceInfo;
+        ++(*hostApi)->info.deviceCount;
+    }
+
+    (*hostApi)->Terminate = Terminate;
+    (*hostApi)->OpenStream = OpenStream;
+    (*hostApi)->IsFormatSupported = IsFormatSupported;
+
+    PaUtil_InitializeStreamInterface( &fileHostApi->callbackStreamInterface, CloseStream, StartStream,
+                                      StopStream, AbortStream, IsStreamStopped, IsStreamActive,
+                                      GetStreamTime, GetStreamCpuLoad,
+                                      PaUtil_DummyRead, PaUtil_DummyWrite,
+                                      PaUtil_DummyGetReadAvailable, PaUtil_DummyGetWriteAvailable );
+
+    PaUtil_InitializeStreamInterface( &fileHostApi->blockingStreamInterface, CloseStream, StartStream,
+                                      StopStream, AbortStream, IsStreamStopped, IsStreamActive,
+                                      GetStreamTime, PaUtil_DummyGetCpuLoad,
+                                      ReadStream, WriteStream, GetStreamReadAvailable, GetStreamWriteAvailable );
+
+    return result;
+
+error:
+    if( fileHostApi )
+    {
+        if( fileHostApi->allocations )
+        {
+            PaUtil_FreeAllAllocations( fileHostApi->allocations );
+            PaUtil_DestroyAllocationGroup( fileHostApi->allocations );
+        }
+
+        PaUtil_FreeMemory( fileHostApi );
+    }
+    return result;
+}
+
+
+static void Terminate( struct PaUtilHostApiRepresentation *hostApi )
+{
+    PaFileHostApiRepresentation *fileHostApi = (PaFileHostApiRepresentation*)hostApi;
+
+    if( fileHostApi->allocations )
+    {
+        PaUtil_FreeAllAllocations( fileHostApi->allocations );
+        PaUtil_DestroyAllocationGroup( fileHostApi->allocations );
+    }
+
+    PaUtil_FreeMemory( fileHostApi );
+}
+
+
+static PaError ValidateParameters( struct PaUtilHostApiRepresentation *hostApi,
+                                   const PaStreamParameters *parameters, int isInput )
+{
+    const PaDeviceInfo *deviceInfo;
+
+    if( !parameters )
+        return paNoError;
+
+    /* all standard sample formats are supported by the buffer adapter,
+        this implementation doesn't support any custom sample formats */
+    if( parameters->sampleFormat & paCustomFormat )
+        return paSampleFormatNotSupported;
+
+    if( parameters->device == paUseHostApiSpecificDeviceSpecification )
+        return paInvalidDevice;
+
+    deviceInfo = hostApi->deviceInfos[ parameters->device ];
+    if( parameters->channelCount > ( isInput ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels ) )
+        return paInvalidChannelCount;
+
+    /* this implementation doesn't use custom stream info */
+    if( parameters->hostApiSpecificStreamInfo )
+        return paIncompatibleHostApiSpecificStreamInfo;
+
+    return paNoError;
+}
+
+
+static PaError IsFormatSupported( struct PaUtilHostApiRepresentation *hostApi,
+                                  const PaStreamParameters *inputParameters,
+                                  const PaStreamParameters *outputParameters,
+                                  double sampleRate )
+{
+    PaError result;
+
+    if( (result = ValidateParameters( hostApi, inputParameters, 1 )) != paNoError )
+        return result;
+    if( (result = ValidateParameters( hostApi, outputParameters, 0 )) != paNoError )
+        return result;
+
+    /* any sample rate is accepted, files are read and written at the stream's rate */
+    if( sampleRate <= 0. )
+        return paInvalidSampleRate;
+
+    return paFormatIsSupported;
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* PaFileStream - a stream data structure specifically for this implementation */
+
+typedef struct PaFileStream
+{
+    PaUtilStreamRepresentation streamRepresentation;
+    PaUtilCpuLoadMeasurer cpuLoadMeasurer;
+    PaUtilBufferProcessor bufferProcessor;
+
+    const PaFileDeviceConfig *inputConfig;      /* NULL if there is no input */
+    const PaFileDeviceConfig *outputConfig;     /* NULL if there is no output */
+    const PaFileDeviceConfig *clockConfig;      /* clock, jitter and xrun settings, the output device's for full duplex streams */
+
+    int inputChannelCount;
+    int outputChannelCount;
+    double sampleRate;
+    unsigned long framesPerHostBuffer;
+    unsigned long blockingCapacityFrames;       /* device buffer size of blocking streams */
+
+    float *hostInputBuffer;                     /* interleaved float32 */
+    float *hostOutputBuffer;
+    void **blockingUserBuffers;                 /* copy of non-interleaved user buffer pointers, advanced by PaUtil_CopyInput/Output() */
+
+    PaFileReader reader;
+    PaFileWriter writer;
+
+    unsigned int randomState;
+    unsigned long hostBufferCount;
+
+    /* the simulated clock. framePosition counts frames since the stream was opened and
+        only advances while the stream runs, stream time is framePosition / sampleRate. */
+    double framePosition;
+    double startFramePosition;                  /* framePosition when the stream was started */
+    double startRealTime;                       /* PaUtil_GetTime() when the stream was started */
+    volatile double streamTime;
+
+    /* blocking streams, frames transferred since the stream was started */
+    double framesRead;
+    double framesWritten;
+    double xrunPeriodsDecided;                  /* host buffers that ShouldInjectBlockingXrun() has decided on */
+    unsigned long xrunHistory;                  /* bit n is set if host buffer xrunPeriodsDecided - 1 - n is dropped */
+
+    PaFileThread thread;
+    int threadRunning;
+
+    volatile int stopRequested;
+    volatile int abortRequested;
+    volatile int isActive;
+    volatile int isStopped;
+}
+PaFileStream;
+
+
+/* xorshift32, deterministic for a given PaFileDeviceConfig::randomSeed */
+static double RandomUnit( PaFileStream *stream )
+{
+    unsigned int x = stream->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    stream->randomState = x;
+    return (double)( x >> 8 ) / 16777216.0;
+}
+
+
+/* Decides whether the next host buffer is dropped. Called once per host buffer. */
+static int ShouldInjectXrun( PaFileStream *stream )
+{
+    const PaFileDeviceConfig *config = stream->clockConfig;
+
+    ++stream->hostBufferCount;
+
+    if( config->xrunInterval > 0 && stream->hostBufferCount % config->xrunInterval == 0 )
+        return 1;
+    if( config->xrunProbability > 0. && RandomUnit( stream ) < config->xrunProbability )
+        return 1;
+    return 0;
+}
+
+
+/* Decides whether the host buffer of a blocking stream that contains frame framePosition
+    (counted since the stream was started) is dropped. Reads and writes of a full duplex
+    stream share the decision, so that each host buffer counts once towards xrunInterval.
+    A dropped host buffer is never followed by another, since the caller's frames are
+    transferred in the next one. */
+static int ShouldInjectBlockingXrun( PaFileStream *stream, double framePosition )
+{
+    double period = floor( framePosition / stream->framesPerHostBuffer );
+    double age;
+
+    while( stream->xrunPeriodsDecided <= period )
+    {
+        int previousDropped = stream->xrunHistory & 1;
+        int dropped = ShouldInjectXrun( stream ) && !previousDropped;
+        stream->xrunHistory = ( stream->xrunHistory << 1 ) | (unsigned long)dropped;
+        stream->xrunPeriodsDecided += 1.;
+    }
+
+    /* the read and write positions of a full duplex stream stay within a few host buffers */
+    age = stream->xrunPeriodsDecided - 1. - period;
+    return age < 32. ? (int)( ( stream->xrunHistory >> (int)age ) & 1 ) : 0;
+}
+
+
+/* Real time at which the simulated clock reaches framePosition. */
+static double GetRealTimeForFramePosition( PaFileStream *stream, double framePosition )
+{
+    return stream->startRealTime + ( framePosition - stream->startFramePosition ) / ( stream->sampleRate * stream->clockConfig->clockRate );
+}
+
+
+/* Frames of simulated time that have elapsed since the stream was started, for real-time clocks. */
+static double GetElapsedFrames( PaFileStream *stream )
+{
+    return floor( ( PaUtil_GetTime() - stream->startRealTime ) * stream->clockConfig->clockRate * stream->sampleRate );
+}
+
+
+/* Sleeps until the real time for framePosition plus jitter, in short slices so that
+    an abort is noticed. Returns immediately when the clock runs as fast as possible. */
+static void WaitForFramePosition( PaFileStream *stream, double framePosition )
+{
+    double target;
+
+    if( stream->clockConfig->clockRate <= 0. )
+        return;
+
+    target = GetRealTimeForFramePosition( stream, framePosition );
+    if( stream->clockConfig->jitterSeconds > 0. )
+        target += stream->clockConfig->jitterSeconds * RandomUnit( stream );
+
+    while( !stream->abortRequested )
+    {
+        double remaining = target - PaUtil_GetTime();
+        if( remaining <= 0. )
+            break;
+        SleepSeconds( remaining < .01 ? remaining : .01 );
+    }
+}
+
+
+static unsigned long SelectFramesPerHostBuffer( const PaFileDeviceConfig *clockConfig,
+                                                 unsigned long framesPerBuffer, PaTime suggestedLatency, double sampleRate )
+{
+    unsigned long result;
+
+    if( clockConfig->framesPerHostBuffer )
+        return clockConfig->framesPerHostBuffer;
+    if( framesPerBuffer != paFramesPerBufferUnspecified )
+        return framesPerBuffer;
+
+    result = (unsigned long)( suggestedLatency * sampleRate + 0.5 );
+    return result > 0 ? result : PA_FILE_DEFAULT_FRAMES_PER_HOST_BUFFER;
+}
+
+
+static void FreeStream( PaFileStream *stream )
+{
+    PaFileReader_Close( &stream->reader );
+    PaFileWriter_Close( &stream->writer, stream->sampleRate );
+
+    if( stream->hostInputBuffer )
+        PaUtil_FreeMemory( stream->hostInputBuffer );
+    if( stream->hostOutputBuffer )
+        PaUtil_FreeMemory( stream->hostOutputBuffer );
+    if( stream->blockingUserBuffers )
+        PaUtil_FreeMemory( stream->blockingUserBuffers );
+
+    PaUtil_FreeMemory( stream );
+}
+
+
+/* see pa_hostapi.h for a list of validity guarantees made about OpenStream parameters */
+
+static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
+                           PaStream** s,
+                           const PaStreamParameters *inputParameters,
+                           const PaStreamParameters *outputParameters,
+                           double sampleRate,
+                           unsigned long framesPerBuffer,
+                           PaStreamFlags streamFlags,
+                           PaStreamCallback *streamCallback,
+                           void *userData )
+{
+    PaError result = paNoError;
+    PaFileHostApiRepresentation *fileHostApi = (PaFileHostApiRepresentation*)hostApi;
+    PaFileStream *stream = 0;
+    int bufferProcessorInitialized = 0;
+    int inputChannelCount, outputChannelCount;
+    PaSampleFormat inputSampleFormat, outputSampleFormat;
+    PaTime suggestedLatency;
+    unsigned long hostBufferLatencyFrames;
+
+    if( (result = ValidateParameters( hostApi, inputParameters, 1 )) != paNoError )
+        return result;
+    if( (result = ValidateParameters( hostApi, outputParameters, 0 )) != paNoError )
+        return result;
+
+    /* validate platform specific flags */
+    if( (streamFlags & paPlatformSpecificFlags) != 0 )
+        return paInvalidFlag; /* unexpected platform specific flag */
+
+    inputChannelCount = inputParameters ? inputParameters->channelCount : 0;
+    inputSampleFormat = inputParameters ? inputParameters->sampleFormat : paFloat32;
+    outputChannelCount = outputParameters ? outputParameters->channelCount : 0;
+    outputSampleFormat = outputParameters ? outputParameters->sampleFormat : paFloat32;
+
+    stream = (PaFileStream*)PaUtil_AllocateMemory( sizeof(PaFileStream) );
+    if( !stream )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+    memset( stream, 0, sizeof(PaFileStream) );
+
+    stream->inputConfig = inputParameters ? &fileHostApi->deviceConfigs[ inputParameters->device ] : NULL;
+    stream->outputConfig = outputParameters ? &fileHostApi->deviceConfigs[ outputParameters->device ] : NULL;
+    stream->clockConfig = stream->outputConfig ? stream->outputConfig : stream->inputConfig;
+    stream->inputChannelCount = inputChannelCount;
+    stream->outputChannelCount = outputChannelCount;
+    stream->sampleRate = sampleRate;
+    stream->randomState = stream->clockConfig->randomSeed ? stream->clockConfig->randomSeed : 1;
+    stream->isStopped = 1;
+
+    suggestedLatency = outputParameters ? outputParameters->suggestedLatency : inputParameters->suggestedLatency;
+    stream->framesPerHostBuffer = SelectFramesPerHostBuffer( stream->clockConfig, framesPerBuffer, suggestedLatency, sampleRate );
+    stream->blockingCapacityFrames = stream->framesPerHostBuffer * PA_FILE_BLOCKING_HOST_BUFFERS;
+
+    if( streamCallback )
+    {
+        PaUtil_InitializeStreamRepresentation( &stream->streamRepresentation,
+                                               &fileHostApi->callbackStreamInterface, streamCallback, userData );
+    }
+    else
+    {
+        PaUtil_InitializeStreamRepresentation( &stream->streamRepresentation,
+                                               &fileHostApi->blockingStreamInterface, streamCallback, userData );
+    }
+
+    PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
+
+    /* the host format is interleaved float32, the buffer processor converts to and from the user's format */
+    result =  PaUtil_InitializeBufferProcessor( &stream->bufferProcessor,
+              inputChannelCount, inputSampleFormat, paFloat32,
+              outputChannelCount, outputSampleFormat, paFloat32,
+              sampleRate, streamFlags, framesPerBuffer,
+              stream->framesPerHostBuffer, paUtilFixedHostBufferSize,
+              streamCallback, userData );
+    if( result != paNoError )
+        goto error;
+    bufferProcessorInitialized = 1;
+
+    if( inputChannelCount > 0 )
+    {
+        stream->hostInputBuffer = (float*)PaUtil_AllocateMemory( sizeof(float) * stream->framesPerHostBuffer * inputChannelCount );
+        if( !stream->hostInputBuffer )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        result = PaFileReader_Open( &stream->reader, stream->inputConfig, stream->framesPerHostBuffer );
+        if( result != paNoError )
+            goto error;
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        stream->hostOutputBuffer = (float*)PaUtil_AllocateMemory( sizeof(float) * stream->framesPerHostBuffer * outputChannelCount );
+        if( !stream->hostOutputBuffer )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
+        result = PaFileWriter_Open( &stream->writer, stream->outputConfig, outputChannelCount, sampleRate, stream->framesPerHostBuffer );
+        if( result != paNoError )
+            goto error;
+    }
+
+    if( !streamCallback )
+    {
+        int userChannelCount = inputChannelCount > outputChannelCount ? inputChannelCount : outputChannelCount;
+        stream->blockingUserBuffers = (void**)PaUtil_AllocateMemory( sizeof(void*) * userChannelCount );
+        if( !stream->blockingUserBuffers )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+    }
+
+    /* callback streams hold one host buffer, blocking streams a device buffer of several */
+    hostBufferLatencyFrames = streamCallback ? stream->framesPerHostBuffer : stream->blockingCapacityFrames;
+    stream->streamRepresentation.streamInfo.inputLatency = inputChannelCount > 0 ?
+            (PaTime)( PaUtil_GetBufferProcessorInputLatencyFrames(&stream->bufferProcessor) + hostBufferLatencyFrames ) / sampleRate : 0.;
+    stream->streamRepresentation.streamInfo.outputLatency = outputChannelCount > 0 ?
+            (PaTime)( PaUtil_GetBufferProcessorOutputLatencyFrames(&stream->bufferProcessor) + hostBufferLatencyFrames ) / sampleRate : 0.;
+    stream->streamRepresentation.streamInfo.sampleRate = sampleRate;
+
+    *s = (PaStream*)stream;
+
+    return result;
+
+error:
+    if( stream )
+    {
+        if( bufferProcessorInitialized )
+            PaUtil_TerminateBufferProcessor( &stream->bufferProcessor );
+        FreeStream( stream );
+    }
+
+    return result;
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* callback streams */
+
+static PA_FILE_THREAD_FUNCTION ProcessingThreadProc( void *userData )
+{
+    PaFileStream *stream = (PaFileStream*)userData;
+    const unsigned long hostFrames = stream->framesPerHostBuffer;
+    PaStreamCallbackFlags statusFlags = 0;
+    int callbackResult = paContinue;
+
+    while( !stream->abortRequested )
+    {
+        PaStreamCallbackTimeInfo timeInfo;
+        unsigned long framesProcessed;
+
+        /* a host buffer is delivered once the simulated clock reaches its end */
+        PaTrace_BeginEvent( paTraceHostWait, (long)hostFrames, 0 );
+        WaitForFramePosition( stream, stream->framePosition + hostFrames );
+        PaTrace_EndEvent( paTraceHostWait, (long)hostFrames, 0 );
+        if( stream->abortRequested )
+            break;
+
+        if( stream->stopRequested && callbackResult == paContinue )
+            callbackResult = paComplete; /* let the buffer processor drain its output */
+
+        if( ShouldInjectXrun( stream ) )
+        {
+            if( stream->inputChannelCount > 0 )
+            {
+                PaFileReader_Read( &stream->reader, stream->hostInputBuffer, hostFrames, stream->inputChannelCount );
+                statusFlags |= paInputOverflow;
+            }
+            if( stream->outputChannelCount > 0 )
+            {
+                PaFileWriter_Write( &stream->writer, NULL, hostFrames );
+                statusFlags |= paOutputUnderflow;
+            }
+
+            stream->framePosition += hostFrames;
+            stream->streamTime = stream->framePosition / stream->sampleRate;
+            continue;
+        }
+
+        if( stream->inputChannelCount > 0 )
+            PaFileReader_Read( &stream->reader, stream->hostInputBuffer, hostFrames, stream->inputChannelCount );
+
+        timeInfo.currentTime = stream->streamTime;
+        timeInfo.inputBufferAdcTime = timeInfo.currentTime - stream->streamRepresentation.streamInfo.inputLatency;
+        timeInfo.outputBufferDacTime = timeInfo.currentTime + stream->streamRepresentation.streamInfo.outputLatency;
+
+        PaUtil_BeginCpuLoadMeasurement( &stream->cpuLoadMeasurer );
+
+        PaUtil_BeginBufferProcessing( &stream->bufferProcessor, &timeInfo, statusFlags );
+        statusFlags = 0;
+
+        if( stream->inputChannelCount > 0 )
+        {
+            PaUtil_SetInputFrameCount( &stream->bufferProcessor, 0 /* default to host buffer size */ );
+            PaUtil_SetInterleavedInputChannels( &stream->bufferProcessor, 0, stream->hostInputBuffer, 0 /* all channels */ );
+        }
+        if( stream->outputChannelCount > 0 )
+        {
+            PaUtil_SetOutputFrameCount( &stream->bufferProcessor, 0 /* default to host buffer size */ );
+            PaUtil_SetInterleavedOutputChannels( &stream->bufferProcessor, 0, stream->hostOutputBuffer, 0 /* all channels */ );
+        }
+
+        framesProcessed = PaUtil_EndBufferProcessing( &stream->bufferProcessor, &callbackResult );
+
+        PaUtil_EndCpuLoadMeasurement( &stream->cpuLoadMeasurer, framesProcessed );
+
+        if( stream->outputChannelCount > 0 )
+            PaFileWriter_Write( &stream->writer, stream->hostOutputBuffer, hostFrames );
+
+        stream->framePosition += hostFrames;
+        stream->streamTime = stream->framePosition / stream->sampleRate;
+
+        if( callbackResult == paAbort )
+            break;
+        if( callbackResult == paComplete
+                && ( stream->outputChannelCount == 0 || PaUtil_IsBufferProcessorOutputEmpty( &stream->bufferProcessor ) ) )
+            break;
+    }
+
+    stream->isActive = 0;
+    if( stream->streamRepresentation.streamFinishedCallback != 0 )
+        stream->streamRepresentation.streamFinishedCallback( stream->streamRepresentation.userData );
+
+    return PA_FILE_THREAD_RETURN;
+}
+
+
+static PaError StartThread( PaFileStream *stream )
+{
+#ifdef _WIN32
+    stream->thread = (HANDLE)_beginthreadex( NULL, 0, ProcessingThreadProc, stream, 0, NULL );
+    if( !stream->thread )
+    {
+        PA_FILE_SET_LAST_HOST_ERROR( (long)GetLastError(), "could not create the processing thread" );
+        return paUnanticipatedHostError;
+    }
+#else
+    int error = pthread_create( &stream->thread, NULL, ProcessingThreadProc, stream );
+    if( error != 0 )
+    {
+        PA_FILE_SET_LAST_HOST_ERROR( error, "could not create the processing thread" );
+        return paUnanticipatedHostError;
+    }
+#endif
+
+    stream->threadRunning = 1;
+    return paNoError;
+}
+
+
+static void JoinThread( PaFileStream *stream )
+{
+    if( !stream->threadRunning )
+        return;
+
+#ifdef _WIN32
+    WaitForSingleObject( stream->thread, INFINITE );
+    CloseHandle( stream->thread );
+#else
+    pthread_join( stream->thread, NULL );
+#endif
+
+    stream->threadRunning = 0;
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* stream control */
+
+/*
+    When CloseStream() is called, the multi-api layer ensures that
+    the stream has already been stopped or aborted.
+*/
+static PaError CloseStream( PaStream* s )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+
+    PaUtil_TerminateBufferProcessor( &stream->bufferProcessor );
+    PaUtil_TerminateStreamRepresentation( &stream->streamRepresentation );
+    FreeStream( stream );
+
+    return paNoError;
+}
+
+
+static PaError StartStream( PaStream *s )
+{
+    PaError result = paNoError;
+    PaFileStream *stream = (PaFileStream*)s;
+
+    PaUtil_ResetBufferProcessor( &stream->bufferProcessor );
+
+    stream->startFramePosition = stream->framePosition;
+    stream->startRealTime = PaUtil_GetTime();
+    stream->framesRead = 0.;
+    stream->framesWritten = 0.;
+    stream->xrunPeriodsDecided = 0.;
+    stream->xrunHistory = 0;
+    stream->stopRequested = 0;
+    stream->abortRequested = 0;
+    stream->isStopped = 0;
+    stream->isActive = 1;
+
+    if( stream->streamRepresentation.streamCallback )
+    {
+        result = StartThread( stream );
+        if( result != paNoError )
+        {
+            stream->isActive = 0;
+            stream->isStopped = 1;
+        }
+    }
+
+    return result;
+}
+
+
+/* Advances the clock of a blocking stream to the end of the stream, or to now if aborting. */
+static void EndBlockingStream( PaFileStream *stream, int abort )
+{
+    double endFrame = stream->framesRead > stream->framesWritten ? stream->framesRead : stream->framesWritten;
+
+    if( stream->clockConfig->clockRate > 0. )
+    {
+        if( !abort && stream->outputChannelCount > 0 )
+        {
+            /* wait for the buffered output to play */
+            double remaining = GetRealTimeForFramePosition( stream, stream->startFramePosition + stream->framesWritten ) - PaUtil_GetTime();
+            SleepSeconds( remaining );
+        }
+        else
+        {
+            endFrame = GetElapsedFrames( stream );
+        }
+    }
+
+    stream->framePosition = stream->startFramePosition + endFrame;
+    stream->streamTime = stream->framePosition / stream->sampleRate;
+}
+
+
+static PaError EndStream( PaFileStream *stream, int abort )
+{
+    if( stream->streamRepresentation.streamCallback )
+    {
+        if( abort )
+            stream->abortRequested = 1;
+        else
+            stream->stopRequested = 1;
+
+        JoinThread( stream );
+    }
+    else
+    {
+        EndBlockingStream( stream, abort );
+
+        stream->isActive = 0;
+        if( stream->streamRepresentation.streamFinishedCallback != 0 )
+            stream->streamRepresentation.streamFinishedCallback( stream->streamRepresentation.userData );
+    }
+
+    stream->isStopped = 1;
+    return paNoError;
+}
+
+
+static PaError StopStream( PaStream *s )
+{
+    return EndStream( (PaFileStream*)s, 0 );
+}
+
+
+static PaError AbortStream( PaStream *s )
+{
+    return EndStream( (PaFileStream*)s, 1 );
+}
+
+
+static PaError IsStreamStopped( PaStream *s )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+
+    return stream->isStopped;
+}
+
+
+static PaError IsStreamActive( PaStream *s )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+
+    return stream->isActive;
+}
+
+
+static PaTime GetStreamTime( PaStream *s )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+
+    /* blocking streams on a real-time clock advance continuously, as a device would */
+    if( !stream->streamRepresentation.streamCallback && stream->isActive && stream->clockConfig->clockRate > 0. )
+        return ( stream->startFramePosition + GetElapsedFrames( stream ) ) / stream->sampleRate;
+
+    return stream->streamTime;
+}
+
+
+static double GetStreamCpuLoad( PaStream* s )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+
+    return PaUtil_GetCpuLoad( &stream->cpuLoadMeasurer );
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* blocking streams */
+
+/* Frames that can be read without blocking, and the frames lost to overflow if the reader fell behind. */
+static unsigned long GetReadAvailable( PaFileStream *stream, double *overflowFrames )
+{
+    double available;
+
+    *overflowFrames = 0.;
+    if( stream->clockConfig->clockRate <= 0. )
+        return stream->blockingCapacityFrames;
+
+    available = GetElapsedFrames( stream ) - stream->framesRead;
+    if( available > stream->blockingCapacityFrames )
+    {
+        *overflowFrames = available - stream->blockingCapacityFrames;
+        available = stream->blockingCapacityFrames;
+    }
+    return available > 0. ? (unsigned long)available : 0;
+}
+
+
+/* Frames that can be written without blocking, and the frames of silence played if the writer fell behind. */
+static unsigned long GetWriteAvailable( PaFileStream *stream, double *underflowFrames )
+{
+    double buffered;
+
+    *underflowFrames = 0.;
+    if( stream->clockConfig->clockRate <= 0. )
+        return stream->blockingCapacityFrames;
+
+    buffered = stream->framesWritten - GetElapsedFrames( stream );
+    if( buffered < 0. )
+    {
+        *underflowFrames = -buffered;
+        buffered = 0.;
+    }
+    return buffered < stream->blockingCapacityFrames ? (unsigned long)( stream->blockingCapacityFrames - buffered ) : 0;
+}
+
+
+/* Discards frames of capture data, in host buffer sized chunks. */
+static void SkipInput( PaFileStream *stream, double frames )
+{
+    while( frames > 0. )
+    {
+        unsigned long chunk = frames < stream->framesPerHostBuffer ? (unsigned long)frames : stream->framesPerHostBuffer;
+        PaFileReader_Read( &stream->reader, stream->hostInputBuffer, chunk, stream->inputChannelCount );
+        frames -= chunk;
+    }
+}
+
+
+static void UpdateBlockingStreamTime( PaFileStream *stream )
+{
+    if( stream->clockConfig->clockRate <= 0. )
+    {
+        double frames = stream->framesRead > stream->framesWritten ? stream->framesRead : stream->framesWritten;
+        stream->streamTime = ( stream->startFramePosition + frames ) / stream->sampleRate;
+    }
+}
+
+
+static PaError ReadStream( PaStream* s,
+                           void *buffer,
+                           unsigned long frames )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+    PaError result = paNoError;
+    void *userBuffer;
+
+    if( stream->bufferProcessor.userInputIsInterleaved )
+    {
+        userBuffer = buffer;
+    }
+    else
+    {
+        /* PaUtil_CopyInput() advances the channel pointers, so work on a copy */
+        userBuffer = (void*)stream->blockingUserBuffers;
+        memcpy( stream->blockingUserBuffers, buffer, sizeof(void*) * stream->inputChannelCount );
+    }
+
+    while( frames > 0 )
+    {
+        unsigned long framesToRead = frames < stream->framesPerHostBuffer ? frames : stream->framesPerHostBuffer;
+        double overflowFrames;
+        unsigned long available;
+
+        while( (available = GetReadAvailable( stream, &overflowFrames )) < framesToRead )
+            SleepSeconds( (double)( framesToRead - available ) / ( stream->sampleRate * stream->clockConfig->clockRate ) );
+
+        /* the device delivers the frames late by the jitter */
+        WaitForFramePosition( stream, stream->startFramePosition + stream->framesRead + framesToRead );
+
+        if( overflowFrames > 0. )
+        {
+            SkipInput( stream, overflowFrames );
+            stream->framesRead += overflowFrames;
+            result = paInputOverflowed;
+        }
+
+        if( ShouldInjectBlockingXrun( stream, stream->framesRead ) )
+        {
+            /* the dropped frames are lost, wait for the next ones */
+            SkipInput( stream, framesToRead );
+            stream->framesRead += framesToRead;
+            result = paInputOverflowed;
+            continue;
+        }
+
+        PaFileReader_Read( &stream->reader, stream->hostInputBuffer, framesToRead, stream->inputChannelCount );
+
+        PaUtil_SetInputFrameCount( &stream->bufferProcessor, framesToRead );
+        PaUtil_SetInterleavedInputChannels( &stream->bufferProcessor, 0, stream->hostInputBuffer, 0 /* all channels */ );
+        PaUtil_CopyInput( &stream->bufferProcessor, &userBuffer, framesToRead );
+
+        stream->framesRead += framesToRead;
+        frames -= framesToRead;
+    }
+
+    UpdateBlockingStreamTime( stream );
+    return result;
+}
+
+
+static PaError WriteStream( PaStream* s,
+                            const void *buffer,
+                            unsigned long frames )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+    PaError result = paNoError;
+    const void *userBuffer;
+
+    if( stream->bufferProcessor.userOutputIsInterleaved )
+    {
+        userBuffer = buffer;
+    }
+    else
+    {
+        /* PaUtil_CopyOutput() advances the channel pointers, so work on a copy */
+        userBuffer = (const void*)stream->blockingUserBuffers;
+        memcpy( stream->blockingUserBuffers, buffer, sizeof(void*) * stream->outputChannelCount );
+    }
+
+    while( frames > 0 )
+    {
+        unsigned long framesToWrite = frames < stream->framesPerHostBuffer ? frames : stream->framesPerHostBuffer;
+        double underflowFrames;
+        unsigned long available;
+
+        while( (available = GetWriteAvailable( stream, &underflowFrames )) < framesToWrite )
+            SleepSeconds( (double)( framesToWrite - available ) / ( stream->sampleRate * stream->clockConfig->clockRate ) );
+
+        /* the device asks for the frames late by the jitter, once there is room for them */
+        WaitForFramePosition( stream, stream->startFramePosition + stream->framesWritten + framesToWrite - stream->blockingCapacityFrames );
+
+        if( underflowFrames > 0. )
+        {
+            /* the device played silence while the buffer was empty */
+            PaFileWriter_Write( &stream->writer, NULL, (unsigned long)underflowFrames );
+            stream->framesWritten += underflowFrames;
+            result = paOutputUnderflowed;
+        }
+
+        if( ShouldInjectBlockingXrun( stream, stream->framesWritten ) )
+        {
+            /* the device plays silence in place of the dropped frames, then waits for room for them again */
+            PaFileWriter_Write( &stream->writer, NULL, framesToWrite );
+            stream->framesWritten += framesToWrite;
+            result = paOutputUnderflowed;
+            continue;
+        }
+
+        PaUtil_SetOutputFrameCount( &stream->bufferProcessor, framesToWrite );
+        PaUtil_SetInterleavedOutputChannels( &stream->bufferProcessor, 0, stream->hostOutputBuffer, 0 /* all channels */ );
+        PaUtil_CopyOutput( &stream->bufferProcessor, &userBuffer, framesToWrite );
+
+        PaFileWriter_Write( &stream->writer, stream->hostOutputBuffer, framesToWrite );
+
+        stream->framesWritten += framesToWrite;
+        frames -= framesToWrite;
+    }
+
+    UpdateBlockingStreamTime( stream );
+    return result;
+}
+
+
+static signed long GetStreamReadAvailable( PaStream* s )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+    double overflowFrames;
+
+    return (signed long)GetReadAvailable( stream, &overflowFrames );
+}
+
+
+static signed long GetStreamWriteAvailable( PaStream* s )
+{
+    PaFileStream *stream = (PaFileStream*)s;
+    double underflowFrames;
+
+    return (signed long)GetWriteAvailable( stream, &underflowFrames );
+}
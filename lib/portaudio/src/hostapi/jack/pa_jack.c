@@ -70,6 +70,7 @@
 #include "pa_cpuload.h"
 #include "pa_ringbuffer.h"
 #include "pa_debugprint.h"
+#include "pa_unix_util.h"
 
 static pthread_t mainThread_;
 static char *jackErr_ = NULL;
@@ -221,8 +222,8 @@ typedef struct PaJackStream
     /* These are useful for the blocking API */
 
     int                     isBlockingStream;
-    PaUtilRingBuffer        inFIFO;
-    PaUtilRingBuffer        outFIFO;
+    PaUtilPaddedRingBuffer  inFIFO;
+    PaUtilPaddedRingBuffer  outFIFO;
     volatile sig_atomic_t   data_available;
     sem_t                   data_semaphore;
     int                     bytesPerFrame;
@@ -255,17 +256,17 @@ static int JackCallback( jack_nframes_t frames, void *userData );
 /* ---- blocking emulation layer ---- */
 
 /* Allocate buffer. */
-static PaError BlockingInitFIFO( PaUtilRingBuffer *rbuf, long numFrames, long bytesPerFrame )
+static PaError BlockingInitFIFO( PaUtilPaddedRingBuffer *rbuf, long numFrames, long bytesPerFrame )
 {
     long numBytes = numFrames * bytesPerFrame;
     char *buffer = (char *) malloc( numBytes );
     if( buffer == NULL ) return paInsufficientMemory;
     memset( buffer, 0, numBytes );
-    return (PaError) PaUtil_InitializeRingBuffer( rbuf, 1, numBytes, buffer );
+    return (PaError) PaUtil_InitializePaddedRingBuffer( rbuf, 1, numBytes, buffer );
 }
 
 /* Free buffer. */
-static PaError BlockingTermFIFO( PaUtilRingBuffer *rbuf )
+static PaError BlockingTermFIFO( PaUtilPaddedRingBuffer *rbuf )
 {
     if( rbuf->buffer ) free( rbuf->buffer );
     rbuf->buffer = NULL;
@@ -286,11 +287,11 @@ BlockingCallback( const void                      *inputBuffer,
     /* This may get called with NULL inputBuffer during initial setup. */
     if( inputBuffer != NULL )
     {
-        PaUtil_WriteRingBuffer( &stream->inFIFO, inputBuffer, numBytes );
+        PaUtil_WritePaddedRingBuffer( &stream->inFIFO, inputBuffer, numBytes );
     }
     if( outputBuffer != NULL )
     {
-        int numRead = PaUtil_ReadRingBuffer( &stream->outFIFO, outputBuffer, numBytes );
+        int numRead = PaUtil_ReadPaddedRingBuffer( &stream->outFIFO, outputBuffer, numBytes );
         /* Zero out remainder of buffer if we run out of data. */
         memset( (char *)outputBuffer + numRead, 0, numBytes - numRead );
     }
@@ -332,8 +333,8 @@ BlockingBegin( PaJackStream *stream, int minimum_buffer_size )
         ENSURE_PA( BlockingInitFIFO( &stream->outFIFO, numFrames, stream->bytesPerFrame ) );
 
         /* Make Write FIFO appear full initially. */
-        numBytes = PaUtil_GetRingBufferWriteAvailable( &stream->outFIFO );
-        PaUtil_AdvanceRingBufferWriteIndex( &stream->outFIFO, numBytes );
+        numBytes = PaUtil_GetPaddedRingBufferWriteAvailable( &stream->outFIFO );
+        PaUtil_AdvancePaddedRingBufferWriteIndex( &stream->outFIFO, numBytes );
     }
 
     stream->data_available = 0;
@@ -362,7 +363,7 @@ static PaError BlockingReadStream( PaStream* s, void *data, unsigned long numFra
     long numBytes = stream->bytesPerFrame * numFrames;
     while( numBytes > 0 )
     {
-        bytesRead = PaUtil_ReadRingBuffer( &stream->inFIFO, p, numBytes );
+        bytesRead = PaUtil_ReadPaddedRingBuffer( &stream->inFIFO, p, numBytes );
         numBytes -= bytesRead;
         p += bytesRead;
         if( numBytes > 0 )
@@ -387,7 +388,7 @@ static PaError BlockingWriteStream( PaStream* s, const void *data, unsigned long
     long numBytes = stream->bytesPerFrame * numFrames;
     while( numBytes > 0 )
     {
-        bytesWritten = PaUtil_WriteRingBuffer( &stream->outFIFO, p, numBytes );
+        bytesWritten = PaUtil_WritePaddedRingBuffer( &stream->outFIFO, p, numBytes );
         numBytes -= bytesWritten;
         p += bytesWritten;
         if( numBytes > 0 )
@@ -421,7 +422,7 @@ BlockingGetStreamReadAvailable( PaStream* s )
 {
     PaJackStream *stream = (PaJackStream *)s;
 
-    int bytesFull = PaUtil_GetRingBufferReadAvailable( &stream->inFIFO );
+    int bytesFull = PaUtil_GetPaddedRingBufferReadAvailable( &stream->inFIFO );
     return bytesFull / stream->bytesPerFrame;
 }
 
@@ -430,7 +431,7 @@ BlockingGetStreamWriteAvailable( PaStream* s )
 {
     PaJackStream *stream = (PaJackStream *)s;
 
-    int bytesEmpty = PaUtil_GetRingBufferWriteAvailable( &stream->outFIFO );
+    int bytesEmpty = PaUtil_GetPaddedRingBufferWriteAvailable( &stream->outFIFO );
     return bytesEmpty / stream->bytesPerFrame;
 }
 
@@ -439,7 +440,7 @@ BlockingWaitEmpty( PaStream *s )
 {
     PaJackStream *stream = (PaJackStream *)s;
 
-    while( PaUtil_GetRingBufferReadAvailable( &stream->outFIFO ) > 0 )
+    while( PaUtil_GetPaddedRingBufferReadAvailable( &stream->outFIFO ) > 0 )
     {
         stream->data_available = 0;
         sem_wait( &stream->data_semaphore );
@@ -1005,11 +1006,9 @@ static PaError WaitCondition( PaJackHostApiRepresentation *hostApi )
 {
     PaError result = paNoError;
     int err = 0;
-    PaTime pt = PaUtil_GetTime();
     struct timespec ts;
 
-    ts.tv_sec = (time_t) floor( pt + 10 * 60 /* 10 minutes */ );
-    ts.tv_nsec = (long) ((pt - floor( pt )) * 1000000000);
+    PaUnix_GetConditionDeadline( 10 * 60 /* 10 minutes */, &ts );
     /* XXX: Best enclose in loop, in case of spurious wakeups? */
     err = pthread_cond_timedwait( &hostApi->cond, &hostApi->mtx, &ts );
 
@@ -1201,6 +1200,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     }
     srInitialized = 1;
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, jackSr );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     /* create the JACK ports.  We cannot connect them until audio
      * processing begins */
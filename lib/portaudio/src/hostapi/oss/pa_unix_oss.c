@@ -89,6 +89,7 @@
 #include "pa_process.h"
 #include "pa_unix_util.h"
 #include "pa_debugprint.h"
+#include "pa_trace.h"
 
 static int sysErr_;
 static pthread_t mainThread_;
@@ -1251,6 +1252,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     PA_ENSURE( PaOssStream_Configure( stream, sampleRate, framesPerBuffer, &inLatency, &outLatency ) );
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     if( inputParameters )
     {
@@ -1358,7 +1360,9 @@ static PaError PaOssStream_WaitForFrames( PaOssStream *stream, unsigned long *fr
             FD_SET( playbackFd, &writeFds );
             nfds = PA_MAX( nfds, playbackFd + 1 );
         }
+        PaTrace_BeginEvent( paTraceHostWait, (long)pollCapture, (long)pollPlayback );
         ENSURE_( select( nfds, &readFds, &writeFds, NULL, &selectTimeval ), paUnanticipatedHostError );
+        PaTrace_EndEvent( paTraceHostWait, 0, 0 );
         /*
         if( poll( stream->pfds + ofs, nfds, stream->pollTimeout ) < 0 )
         {
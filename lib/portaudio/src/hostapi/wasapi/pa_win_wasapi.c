@@ -3419,6 +3419,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
 	// Initialize CPU measurer
     PaUtil_InitializeCpuLoadMeasurer(&stream->cpuLoadMeasurer, sampleRate);
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
 	if (outputParameters && inputParameters)
 	{
@@ -2512,6 +2512,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     streamRepresentationIsInitialized = 1;
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
 
     if( inputParameters && outputParameters ) /* full duplex */
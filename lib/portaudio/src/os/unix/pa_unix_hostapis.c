@@ -51,6 +51,7 @@ PaError PaSGI_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
 PaError PaAsiHpi_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 PaError PaMacCore_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 PaError PaSkeleton_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
+PaError PaFile_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 
 /** Note that on Linux, ALSA is placed before OSS so that the former is preferred over the latter.
  */
@@ -99,5 +100,61 @@ PaUtilHostApiInitializer *paHostApiInitializers[] =
         PaSkeleton_Initialize,
 #endif
 
+#if PA_USE_FILE
+        PaFile_Initialize, /* after the hardware host APIs so it isn't marked as default. */
+#endif
+
         0   /* NULL terminated array */
     };
+
+/** Must be kept in the same order as paHostApiInitializers. */
+PaHostApiTypeId paHostApiInitializerTypeIds[] =
+    {
+#ifdef __linux__
+
+#if PA_USE_ALSA
+        paALSA,
+#endif
+
+#if PA_USE_OSS
+        paOSS,
+#endif
+
+#else   /* __linux__ */
+
+#if PA_USE_OSS
+        paOSS,
+#endif
+
+#if PA_USE_ALSA
+        paALSA,
+#endif
+
+#endif  /* __linux__ */
+
+#if PA_USE_JACK
+        paJACK,
+#endif
+
+#if PA_USE_SGI 
+        paAL,
+#endif
+
+#if PA_USE_ASIHPI
+        paAudioScienceHPI,
+#endif
+
+#if PA_USE_COREAUDIO
+        paCoreAudio,
+#endif
+
+#if PA_USE_SKELETON
+        paInDevelopment,
+#endif
+
+#if PA_USE_FILE
+        paFile,
+#endif
+
+        paInDevelopment   /* matches the NULL terminator of paHostApiInitializers */
+    };
@@ -57,6 +57,21 @@
 #ifdef HAVE_MACH_ABSOLUTE_TIME
 #include <mach/mach_time.h>
 #endif
+#if defined(__linux__) && !defined(HAVE_MACH_ABSOLUTE_TIME) && !defined(HAVE_CLOCK_GETTIME)
+#define HAVE_CLOCK_GETTIME
+#endif
+
+/* CLOCK_MONOTONIC is read without a system call through the vDSO on all Linux
+    versions, CLOCK_MONOTONIC_RAW only since Linux 5.3. It is also the clock that
+    the ALSA host API asks for its stream timestamps in. Define PA_UNIX_CLOCK_ID
+    to use another clock. */
+#if defined(HAVE_CLOCK_GETTIME) && !defined(PA_UNIX_CLOCK_ID)
+#ifdef CLOCK_MONOTONIC
+#define PA_UNIX_CLOCK_ID CLOCK_MONOTONIC
+#else
+#define PA_UNIX_CLOCK_ID CLOCK_REALTIME
+#endif
+#endif
 
 #include "pa_util.h"
 #include "pa_unix_util.h"
@@ -139,8 +154,8 @@ void Pa_Sleep( long msec )
     http://www.macresearch.org/tutorial_performance_and_time
 */
 
-/* Scaler to convert the result of mach_absolute_time to seconds */
-static double machSecondsConversionScaler_ = 0.0; 
+/* Ratio of nanoseconds to mach_absolute_time units */
+static mach_timebase_info_data_t machTimebase_ = { 1, 1 };
 #endif
 
 void PaUtil_InitializeClock( void )
@@ -148,27 +163,50 @@ void PaUtil_InitializeClock( void )
 #ifdef HAVE_MACH_ABSOLUTE_TIME
     mach_timebase_info_data_t info;
     kern_return_t err = mach_timebase_info( &info );
-    if( err == 0  )
-        machSecondsConversionScaler_ = 1e-9 * (double) info.numer / (double) info.denom;
+    if( err == 0 && info.denom != 0 )
+        machTimebase_ = info;
 #endif
 }
 
 
-PaTime PaUtil_GetTime( void )
+PaUtilNanoseconds PaUtil_GetNanoseconds( void )
 {
 #ifdef HAVE_MACH_ABSOLUTE_TIME
-    return mach_absolute_time() * machSecondsConversionScaler_;
+    PaUtilNanoseconds ticks = mach_absolute_time();
+    if( machTimebase_.numer == machTimebase_.denom )
+        return ticks;
+    /* split the conversion so that ticks * numer can't overflow */
+    return (ticks / machTimebase_.denom) * machTimebase_.numer
+            + (ticks % machTimebase_.denom) * machTimebase_.numer / machTimebase_.denom;
 #elif defined(HAVE_CLOCK_GETTIME)
     struct timespec tp;
-    clock_gettime(CLOCK_REALTIME, &tp);
-    return (PaTime)(tp.tv_sec + tp.tv_nsec * 1e-9);
+    clock_gettime( PA_UNIX_CLOCK_ID, &tp );
+    return (PaUtilNanoseconds)tp.tv_sec * 1000000000 + (PaUtilNanoseconds)tp.tv_nsec;
 #else
     struct timeval tv;
     gettimeofday( &tv, NULL );
-    return (PaTime) tv.tv_usec * 1e-6 + tv.tv_sec;
+    return (PaUtilNanoseconds)tv.tv_sec * 1000000000 + (PaUtilNanoseconds)tv.tv_usec * 1000;
 #endif
 }
 
+
+PaTime PaUtil_GetTime( void )
+{
+    return PaUtil_NanosecondsToTime( PaUtil_GetNanoseconds() );
+}
+
+
+void PaUnix_GetConditionDeadline( PaTime timeout, struct timespec *deadline )
+{
+    struct timeval tv;
+    PaTime till;
+
+    gettimeofday( &tv, NULL );
+    till = tv.tv_sec + tv.tv_usec * 1e-6 + timeout;
+    deadline->tv_sec = (time_t) floor( till );
+    deadline->tv_nsec = (long) ((till - floor( till )) * 1e9);
+}
+
 PaError PaUtil_InitializeThreading( PaUtilThreading *threading )
 {
     (void) paUtilErr_;
@@ -353,23 +391,21 @@ PaError PaUnixThread_New( PaUnixThread* self, void* (*threadFunc)( void* ), void
     
     if( self->parentWaiting )
     {
-        PaTime till;
         struct timespec ts;
         int res = 0;
-        PaTime now;
+#ifdef PA_ENABLE_DEBUG_OUTPUT
+        PaTime now = PaUtil_GetTime();
+#endif
 
         PA_ENSURE( PaUnixMutex_Lock( &self->mtx ) );
 
         /* Wait for stream to be started */
-        now = PaUtil_GetTime();
-        till = now + waitForChild;
+        PaUnix_GetConditionDeadline( waitForChild, &ts );
 
         while( self->parentWaiting && !res )
         {
             if( waitForChild > 0 )
             {
-                ts.tv_sec = (time_t) floor( till );
-                ts.tv_nsec = (long) ((till - floor( till )) * 1e9);
                 res = pthread_cond_timedwait( &self->cond, &self->mtx.mtx, &ts );
             }
             else
@@ -144,6 +144,12 @@ PaError PaUnixMutex_Terminate( PaUnixMutex* self );
 PaError PaUnixMutex_Lock( PaUnixMutex* self );
 PaError PaUnixMutex_Unlock( PaUnixMutex* self );
 
+/** Fill deadline with the time timeout seconds from now for pthread_cond_timedwait(),
+ which measures deadlines against the wall clock rather than PaUtil_GetTime()'s
+ monotonic clock.
+*/
+void PaUnix_GetConditionDeadline( PaTime timeout, struct timespec *deadline );
+
 typedef struct
 {
     pthread_t thread;
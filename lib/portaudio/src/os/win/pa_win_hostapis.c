@@ -58,6 +58,7 @@ extern "C"
 #endif /* __cplusplus */
 
 PaError PaSkeleton_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
+PaError PaFile_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 PaError PaWinMme_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 PaError PaWinDs_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 PaError PaAsio_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
@@ -96,7 +97,46 @@ PaUtilHostApiInitializer *paHostApiInitializers[] =
         PaSkeleton_Initialize, /* just for testing. last in list so it isn't marked as default. */
 #endif
 
+#if PA_USE_FILE
+        PaFile_Initialize, /* after the hardware host APIs so it isn't marked as default. */
+#endif
+
         0   /* NULL terminated array */
     };
 
+/** Must be kept in the same order as paHostApiInitializers. */
+PaHostApiTypeId paHostApiInitializerTypeIds[] =
+    {
+
+#if PA_USE_WMME
+        paMME,
+#endif
+
+#if PA_USE_DS
+        paDirectSound,
+#endif
+
+#if PA_USE_ASIO
+        paASIO,
+#endif
+
+#if PA_USE_WASAPI
+		paWASAPI,
+#endif
+
+#if PA_USE_WDMKS
+        paWDMKS,
+#endif
+
+#if PA_USE_SKELETON
+        paInDevelopment,
+#endif
+
+#if PA_USE_FILE
+        paFile,
+#endif
+
+        paInDevelopment   /* matches the NULL terminator of paHostApiInitializers */
+    };
+
 
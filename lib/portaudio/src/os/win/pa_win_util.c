@@ -106,6 +106,7 @@ void Pa_Sleep( long msec )
 
 static int usePerformanceCounter_;
 static double secondsPerTick_;
+static PaUtilNanoseconds ticksPerSecond_;
 
 void PaUtil_InitializeClock( void )
 {
@@ -115,6 +116,7 @@ void PaUtil_InitializeClock( void )
     {
         usePerformanceCounter_ = 1;
         secondsPerTick_ = 1.0 / (double)ticksPerSecond.QuadPart;
+        ticksPerSecond_ = (PaUtilNanoseconds)ticksPerSecond.QuadPart;
     }
     else
     {
@@ -158,3 +160,23 @@ double PaUtil_GetTime( void )
 #endif                
     }
 }
+
+
+PaUtilNanoseconds PaUtil_GetNanoseconds( void )
+{
+    if( usePerformanceCounter_ )
+    {
+        LARGE_INTEGER time;
+        PaUtilNanoseconds ticks;
+
+        QueryPerformanceCounter( &time );
+        ticks = (PaUtilNanoseconds)time.QuadPart;
+        /* split the conversion so that ticks * 1e9 can't overflow */
+        return (ticks / ticksPerSecond_) * 1000000000
+                + (ticks % ticksPerSecond_) * 1000000000 / ticksPerSecond_;
+    }
+    else
+    {
+        return (PaUtilNanoseconds)( PaUtil_GetTime() * 1e9 );
+    }
+}
@@ -7,6 +7,9 @@ if( NOT TARGET Cinder-PortAudio )
 	add_library( Cinder-PortAudio 
 					${CI_PA_SOURCE_PATH}/cinder/audio/ContextPortAudio.cpp 
 					${CI_PA_SOURCE_PATH}/cinder/audio/DeviceManagerPortAudio.cpp 
+					${CI_PA_SOURCE_PATH}/cinder/audio/NodeProfilerPortAudio.cpp 
+					${CI_PA_SOURCE_PATH}/cinder/audio/RuntimePortAudio.cpp 
+					${CI_PA_SOURCE_PATH}/cinder/audio/SampleFormatPortAudio.cpp 
 	)
 	
 	target_include_directories( Cinder-PortAudio PUBLIC ${CI_PA_SOURCE_PATH} )
@@ -23,14 +23,19 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "cinder/audio/ContextPortAudio.h"
 #include "cinder/audio/DeviceManagerPortAudio.h"
+#include "cinder/audio/RuntimePortAudio.h"
 #include "cinder/audio/dsp/Converter.h"
-#include "cinder/audio/dsp/RingBuffer.h"
 #include "cinder/Log.h"
 
 #include "portaudio.h"
+#include "pa_trace_events.h"
 
-#define LOG_XRUN( stream )	CI_LOG_W( stream )
-//#define LOG_XRUN( stream )	    ( (void)( 0 ) )
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 #define LOG_CI_PORTAUDIO( stream )	CI_LOG_I( stream )
 //#define LOG_CI_PORTAUDIO( stream )	    ( (void)( 0 ) )
@@ -43,6 +48,731 @@ using namespace ci;
 
 namespace cinder { namespace audio {
 
+namespace {
+
+// Trace events added to PortAudio's event trace, which is only recorded when PortAudio is built with PA_TRACE_EVENTS (see pa_trace_events.h)
+enum TraceEventPortAudio {
+	TRACE_EVENT_GRAPH_PULL = paTraceFirstClientEvent,	// args: frames pulled, frames processed by the Context before the pull
+	TRACE_EVENT_CAPTURE_READ							// args: frames available to read, frames read
+};
+
+// Returns true if the stream parameters can be opened with non-interleaved buffers.
+bool isNonInterleavedSupported( const PaStreamParameters *inputParams, const PaStreamParameters *outputParams, double sampleRate )
+{
+	PaStreamParameters inputParamsNonInterleaved, outputParamsNonInterleaved;
+	if( inputParams ) {
+		inputParamsNonInterleaved = *inputParams;
+		inputParamsNonInterleaved.sampleFormat |= paNonInterleaved;
+	}
+	if( outputParams ) {
+		outputParamsNonInterleaved = *outputParams;
+		outputParamsNonInterleaved.sampleFormat |= paNonInterleaved;
+	}
+
+	PaError err = Pa_IsFormatSupported( inputParams ? &inputParamsNonInterleaved : nullptr, outputParams ? &outputParamsNonInterleaved : nullptr, sampleRate );
+	return err == paFormatIsSupported;
+}
+
+// Sets params->sampleFormat to the requested format if the host supports it, otherwise falls back to paFloat32. Returns the format that was chosen.
+SampleFormatPortAudio selectSampleFormat( SampleFormatPortAudio requested, PaStreamParameters *params, bool isInput, double sampleRate )
+{
+	params->sampleFormat = toPaSampleFormat( requested );
+	if( requested == SampleFormatPortAudio::FLOAT_32 )
+		return requested;
+
+	PaError err = isInput ? Pa_IsFormatSupported( params, nullptr, sampleRate ) : Pa_IsFormatSupported( nullptr, params, sampleRate );
+	if( err != paFormatIsSupported ) {
+		LOG_CI_PORTAUDIO( "\t- requested sample format not supported (" << Pa_GetErrorText( err ) << "), falling back to float32" );
+		params->sampleFormat = paFloat32;
+		return SampleFormatPortAudio::FLOAT_32;
+	}
+
+	return requested;
+}
+
+// Converts numFrames from the non-interleaved float channels at source (each sourceFramesPerChannel long) into a PortAudio host buffer, starting at hostOffset.
+// hostBuffer is either an interleaved array or an array of per-channel pointers, depending on nonInterleaved.
+void writeHostBuffer( const float *source, size_t sourceFramesPerChannel, size_t numChannels, void *hostBuffer, size_t hostOffset, size_t numFrames, SampleFormatPortAudio format, bool nonInterleaved )
+{
+	if( nonInterleaved ) {
+		void **hostChannels = (void **)hostBuffer;
+		for( size_t ch = 0; ch < numChannels; ch++ ) {
+			const float *sourceChannel = source + ch * sourceFramesPerChannel;
+			switch( format ) {
+				case SampleFormatPortAudio::FLOAT_32:	memcpy( (float *)hostChannels[ch] + hostOffset, sourceChannel, numFrames * sizeof( float ) ); break;
+				case SampleFormatPortAudio::INT_32:		dsp::interleaveToInt32( sourceChannel, (int32_t *)hostChannels[ch] + hostOffset, numFrames, 1, numFrames ); break;
+				case SampleFormatPortAudio::INT_24:		dsp::interleaveToInt24( sourceChannel, (uint8_t *)hostChannels[ch] + hostOffset * 3, numFrames, 1, numFrames ); break;
+				case SampleFormatPortAudio::INT_16:		dsp::interleaveToInt16( sourceChannel, (int16_t *)hostChannels[ch] + hostOffset, numFrames, 1, numFrames ); break;
+			}
+		}
+	}
+	else {
+		const size_t hostSampleOffset = hostOffset * numChannels;
+		switch( format ) {
+			case SampleFormatPortAudio::FLOAT_32:	dsp::interleave( source, (float *)hostBuffer + hostSampleOffset, sourceFramesPerChannel, numChannels, numFrames ); break;
+			case SampleFormatPortAudio::INT_32:		dsp::interleaveToInt32( source, (int32_t *)hostBuffer + hostSampleOffset, sourceFramesPerChannel, numChannels, numFrames ); break;
+			case SampleFormatPortAudio::INT_24:		dsp::interleaveToInt24( source, (uint8_t *)hostBuffer + hostSampleOffset * 3, sourceFramesPerChannel, numChannels, numFrames ); break;
+			case SampleFormatPortAudio::INT_16:		dsp::interleaveToInt16( source, (int16_t *)hostBuffer + hostSampleOffset, sourceFramesPerChannel, numChannels, numFrames ); break;
+		}
+	}
+}
+
+// Converts numFrames from a PortAudio host buffer, starting at hostOffset, into the non-interleaved float channels at dest (each destFramesPerChannel long).
+void readHostBuffer( const void *hostBuffer, size_t hostOffset, float *dest, size_t destFramesPerChannel, size_t numChannels, size_t numFrames, SampleFormatPortAudio format, bool nonInterleaved )
+{
+	if( nonInterleaved ) {
+		const void * const *hostChannels = (const void * const *)hostBuffer;
+		for( size_t ch = 0; ch < numChannels; ch++ ) {
+			float *destChannel = dest + ch * destFramesPerChannel;
+			switch( format ) {
+				case SampleFormatPortAudio::FLOAT_32:	memcpy( destChannel, (const float *)hostChannels[ch] + hostOffset, numFrames * sizeof( float ) ); break;
+				case SampleFormatPortAudio::INT_32:		dsp::deinterleaveFromInt32( (const int32_t *)hostChannels[ch] + hostOffset, destChannel, numFrames, 1, numFrames ); break;
+				case SampleFormatPortAudio::INT_24:		dsp::deinterleaveFromInt24( (const uint8_t *)hostChannels[ch] + hostOffset * 3, destChannel, numFrames, 1, numFrames ); break;
+				case SampleFormatPortAudio::INT_16:		dsp::deinterleaveFromInt16( (const int16_t *)hostChannels[ch] + hostOffset, destChannel, numFrames, 1, numFrames ); break;
+			}
+		}
+	}
+	else {
+		const size_t hostSampleOffset = hostOffset * numChannels;
+		switch( format ) {
+			case SampleFormatPortAudio::FLOAT_32:	dsp::deinterleave( (const float *)hostBuffer + hostSampleOffset, dest, destFramesPerChannel, numChannels, numFrames ); break;
+			case SampleFormatPortAudio::INT_32:		dsp::deinterleaveFromInt32( (const int32_t *)hostBuffer + hostSampleOffset, dest, destFramesPerChannel, numChannels, numFrames ); break;
+			case SampleFormatPortAudio::INT_24:		dsp::deinterleaveFromInt24( (const uint8_t *)hostBuffer + hostSampleOffset * 3, dest, destFramesPerChannel, numChannels, numFrames ); break;
+			case SampleFormatPortAudio::INT_16:		dsp::deinterleaveFromInt16( (const int16_t *)hostBuffer + hostSampleOffset, dest, destFramesPerChannel, numChannels, numFrames ); break;
+		}
+	}
+}
+
+const size_t CACHE_LINE_SIZE = 64;
+
+//! Bounded, lock-free multiple producer queue with a sequence number per slot, so producers never block or allocate. Consumers are serialized by the owner.
+template <typename T>
+class EventQueue {
+  public:
+	//! \a capacity must be a power of two
+	explicit EventQueue( size_t capacity )
+		: mSlots( capacity ), mMask( capacity - 1 )
+	{
+		CI_ASSERT( capacity > 0 && ( capacity & mMask ) == 0 );
+		for( size_t i = 0; i < capacity; i++ )
+			mSlots[i].mSequence.store( i, memory_order_relaxed );
+	}
+
+	//! Returns false if the queue is full.
+	bool push( const T &value )
+	{
+		Slot *slot;
+		size_t pos = mWritePos.load( memory_order_relaxed );
+		while( true ) {
+			slot = &mSlots[pos & mMask];
+			size_t seq = slot->mSequence.load( memory_order_acquire );
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if( diff == 0 ) {
+				if( mWritePos.compare_exchange_weak( pos, pos + 1, memory_order_relaxed ) )
+					break;
+			}
+			else if( diff < 0 )
+				return false;
+			else
+				pos = mWritePos.load( memory_order_relaxed );
+		}
+
+		slot->mValue = value;
+		slot->mSequence.store( pos + 1, memory_order_release );
+		return true;
+	}
+
+	//! Returns false if the queue is empty.
+	bool pop( T *value )
+	{
+		Slot *slot;
+		size_t pos = mReadPos.load( memory_order_relaxed );
+		while( true ) {
+			slot = &mSlots[pos & mMask];
+			size_t seq = slot->mSequence.load( memory_order_acquire );
+			intptr_t diff = (intptr_t)seq - (intptr_t)( pos + 1 );
+			if( diff == 0 ) {
+				if( mReadPos.compare_exchange_weak( pos, pos + 1, memory_order_relaxed ) )
+					break;
+			}
+			else if( diff < 0 )
+				return false;
+			else
+				pos = mReadPos.load( memory_order_relaxed );
+		}
+
+		*value = slot->mValue;
+		slot->mSequence.store( pos + mMask + 1, memory_order_release );
+		return true;
+	}
+
+  private:
+	struct Slot {
+		atomic<size_t>	mSequence;
+		T				mValue;
+	};
+
+	vector<Slot>	mSlots;
+	const size_t	mMask;
+
+	// producer and consumer positions are padded onto separate cache lines
+	char			mPad0[CACHE_LINE_SIZE];
+	atomic<size_t>	mWritePos = { 0 };
+	char			mPad1[CACHE_LINE_SIZE - sizeof( atomic<size_t> )];
+	atomic<size_t>	mReadPos = { 0 };
+	char			mPad2[CACHE_LINE_SIZE - sizeof( atomic<size_t> )];
+};
+
+//! Single producer, single consumer ring buffer that stores all channels of a frame together (interleaved), sharing one pair of read / write indices.
+//! Writes and reads always transfer all channels or nothing, so channels can never become misaligned.
+class FrameRingBuffer {
+  public:
+	FrameRingBuffer() = default;
+
+	void resize( size_t numFrames, size_t numChannels )
+	{
+		mNumFrames = numFrames;
+		mNumChannels = numChannels;
+
+		// over-allocate so the storage can start on a cache line boundary
+		mAllocation.reset( new float[numFrames * numChannels + CACHE_LINE_SIZE / sizeof( float )] );
+		size_t address = (size_t)mAllocation.get();
+		mData = (float *)( ( address + CACHE_LINE_SIZE - 1 ) & ~( CACHE_LINE_SIZE - 1 ) );
+
+		clear();
+	}
+
+	//! Not thread-safe, only call when neither the producer or consumer are active.
+	void clear()
+	{
+		mWriteIndex = 0;
+		mReadIndex = 0;
+	}
+
+	size_t getNumFrames() const		{ return mNumFrames; }
+	size_t getNumChannels() const	{ return mNumChannels; }
+
+	size_t getAvailableRead() const
+	{
+		return size_t( mWriteIndex.load( memory_order_acquire ) - mReadIndex.load( memory_order_relaxed ) );
+	}
+
+	size_t getAvailableWrite() const
+	{
+		return mNumFrames - size_t( mWriteIndex.load( memory_order_relaxed ) - mReadIndex.load( memory_order_acquire ) );
+	}
+
+	//! Writes \a numFrames from an interleaved array. Returns false and writes nothing if there isn't enough space.
+	bool writeInterleaved( const float *source, size_t numFrames )
+	{
+		if( getAvailableWrite() < numFrames )
+			return false;
+
+		const uint64_t writeIndex = mWriteIndex.load( memory_order_relaxed );
+		const size_t start = size_t( writeIndex % mNumFrames );
+		const size_t firstFrames = min( numFrames, mNumFrames - start );
+
+		memcpy( mData + start * mNumChannels, source, firstFrames * mNumChannels * sizeof( float ) );
+		memcpy( mData, source + firstFrames * mNumChannels, ( numFrames - firstFrames ) * mNumChannels * sizeof( float ) );
+
+		mWriteIndex.store( writeIndex + numFrames, memory_order_release );
+		return true;
+	}
+
+	//! Writes \a numFrames from an array of per-channel pointers, starting at \a frameOffset. Returns false and writes nothing if there isn't enough space.
+	bool write( const float * const *channels, size_t numFrames, size_t frameOffset = 0 )
+	{
+		return writePlanar( numFrames, [channels, frameOffset]( size_t ch ) { return channels[ch] + frameOffset; } );
+	}
+
+	//! Writes \a numFrames from the channels of \a source. Returns false and writes nothing if there isn't enough space.
+	bool write( const Buffer &source, size_t numFrames )
+	{
+		return writePlanar( numFrames, [&source]( size_t ch ) { return source.getChannel( ch ); } );
+	}
+
+	//! Reads \a numFrames into the channels of \a dest, starting at \a destFrameOffset. Returns false and reads nothing if there aren't enough frames available.
+	bool read( Buffer *dest, size_t numFrames, size_t destFrameOffset = 0 )
+	{
+		if( getAvailableRead() < numFrames )
+			return false;
+
+		const uint64_t readIndex = mReadIndex.load( memory_order_relaxed );
+		const size_t start = size_t( readIndex % mNumFrames );
+		const size_t firstFrames = min( numFrames, mNumFrames - start );
+		const size_t destFrames = dest->getNumFrames();
+		float *destData = dest->getData() + destFrameOffset;
+
+		dsp::deinterleave( mData + start * mNumChannels, destData, destFrames, mNumChannels, firstFrames );
+		if( firstFrames < numFrames )
+			dsp::deinterleave( mData, destData + firstFrames, destFrames, mNumChannels, numFrames - firstFrames );
+
+		mReadIndex.store( readIndex + numFrames, memory_order_release );
+		return true;
+	}
+
+  private:
+	template <typename ChannelFn>
+	bool writePlanar( size_t numFrames, const ChannelFn &getChannel )
+	{
+		if( getAvailableWrite() < numFrames )
+			return false;
+
+		const uint64_t writeIndex = mWriteIndex.load( memory_order_relaxed );
+		const size_t start = size_t( writeIndex % mNumFrames );
+		const size_t firstFrames = min( numFrames, mNumFrames - start );
+
+		for( size_t ch = 0; ch < mNumChannels; ch++ ) {
+			const float *channel = getChannel( ch );
+			float *dest = mData + start * mNumChannels + ch;
+			for( size_t i = 0; i < firstFrames; i++ )
+				dest[i * mNumChannels] = channel[i];
+
+			dest = mData + ch;
+			for( size_t i = firstFrames; i < numFrames; i++ )
+				dest[( i - firstFrames ) * mNumChannels] = channel[i];
+		}
+
+		mWriteIndex.store( writeIndex + numFrames, memory_order_release );
+		return true;
+	}
+
+	std::unique_ptr<float[]>	mAllocation;
+	float*						mData = nullptr;
+	size_t						mNumFrames = 0;
+	size_t						mNumChannels = 0;
+
+	// read and write indices are monotonic frame counts, kept on separate cache lines so the producer and consumer don't contend
+	char						mPad0[CACHE_LINE_SIZE];
+	atomic<uint64_t>			mWriteIndex = { 0 };
+	char						mPad1[CACHE_LINE_SIZE - sizeof( atomic<uint64_t> )];
+	atomic<uint64_t>			mReadIndex = { 0 };
+	char						mPad2[CACHE_LINE_SIZE - sizeof( atomic<uint64_t> )];
+};
+
+//! Adaptive jitter buffer for input devices that run on a different clock than the output device. Tracks the capture jitter
+//! to choose a target fill level for the ring buffer, then holds the fill at that target with a PI controller that drives a
+//! variable-ratio linear resampler. The controller's integral term converges to the clock drift between the two devices.
+class DriftCompensator {
+  public:
+	void init( size_t framesPerBlock, size_t sampleRate, size_t numChannels, size_t ringBufferFrames )
+	{
+		mFramesPerBlock = framesPerBlock;
+		mRingBufferFrames = ringBufferFrames;
+
+		double blockSeconds = double( framesPerBlock ) / double( sampleRate );
+		mProportionalGain = 1.0 / ( double( sampleRate ) * PROPORTIONAL_SECONDS );
+		mIntegralGain = mProportionalGain * blockSeconds / INTEGRAL_SECONDS;
+		mJitterWindowBlocks = max<size_t>( 1, size_t( JITTER_WINDOW_SECONDS / blockSeconds ) );
+
+		// frame 0 of each channel holds the last source frame of the previous block
+		mSourceBuffer.setSize( size_t( framesPerBlock * ( 1 + MAX_CORRECTION ) ) + 2, numChannels );
+
+		reset();
+	}
+
+	void reset()
+	{
+		mRatio = 1;
+		mIntegral = 0;
+		mPhase = 0;
+		mFillSmoothed = -1;
+		mTarget = double( min( mFramesPerBlock * 2, mRingBufferFrames - mFramesPerBlock ) );
+		mPriming = true;
+		mSourceBuffer.zero();
+		resetJitterWindow();
+	}
+
+	//! Updates the target fill level and resampling ratio from the number of frames currently buffered. Returns the number of source frames needed to produce \a numFrames.
+	size_t update( size_t framesBuffered, size_t numFrames )
+	{
+		mWindowMin = min( mWindowMin, framesBuffered );
+		mWindowMax = max( mWindowMax, framesBuffered );
+		if( ++mWindowBlocks >= mJitterWindowBlocks ) {
+			// grow the target immediately when jitter increases, shrink it slowly when it decreases
+			double jitter = double( mWindowMax - mWindowMin );
+			double target = min( double( numFrames ) + jitter * JITTER_HEADROOM, double( mRingBufferFrames - numFrames ) );
+			if( target > mTarget )
+				mTarget = target;
+			else
+				mTarget += ( target - mTarget ) * TARGET_DECAY;
+
+			resetJitterWindow();
+		}
+
+		if( mFillSmoothed < 0 )
+			mFillSmoothed = double( framesBuffered );
+		else
+			mFillSmoothed += ( double( framesBuffered ) - mFillSmoothed ) * FILL_SMOOTHING;
+
+		if( ! mPriming ) {
+			double error = mFillSmoothed - mTarget;
+			mIntegral = max( -MAX_DRIFT, min( MAX_DRIFT, mIntegral + error * mIntegralGain ) );
+			mRatio = max( 1 - MAX_CORRECTION, min( 1 + MAX_CORRECTION, 1 + error * mProportionalGain + mIntegral ) );
+		}
+
+		return size_t( mPhase + numFrames * mRatio );
+	}
+
+	//! Reads \a numSourceFrames (as returned from update()) from \a ringBuffer and resamples them into all frames of \a dest.
+	bool process( FrameRingBuffer *ringBuffer, Buffer *dest, size_t numSourceFrames )
+	{
+		if( ! ringBuffer->read( &mSourceBuffer, numSourceFrames, 1 ) )
+			return false;
+
+		const size_t numFrames = dest->getNumFrames();
+		for( size_t ch = 0; ch < dest->getNumChannels(); ch++ ) {
+			float *source = mSourceBuffer.getChannel( ch );
+			float *channel = dest->getChannel( ch );
+
+			double position = mPhase;
+			for( size_t i = 0; i < numFrames; i++ ) {
+				size_t index = size_t( position );
+				if( index < numSourceFrames ) {
+					float frac = float( position - double( index ) );
+					channel[i] = source[index] + ( source[index + 1] - source[index] ) * frac;
+				}
+				else {
+					channel[i] = source[numSourceFrames];
+				}
+				position += mRatio;
+			}
+
+			source[0] = source[numSourceFrames];
+		}
+
+		mPhase += numFrames * mRatio - double( numSourceFrames );
+		return true;
+	}
+
+	bool	isPriming() const		{ return mPriming; }
+	void	setPriming( bool b )	{ mPriming = b; }
+	double	getTarget() const		{ return mTarget; }
+	double	getDepth() const		{ return max( 0.0, mFillSmoothed ); }
+	double	getRatio() const		{ return mRatio; }
+	double	getDriftPpm() const		{ return mIntegral * 1e6; }
+
+  private:
+	void resetJitterWindow()
+	{
+		mWindowBlocks = 0;
+		mWindowMin = numeric_limits<size_t>::max();
+		mWindowMax = 0;
+	}
+
+	const double PROPORTIONAL_SECONDS = 8;		// seconds to correct a fill error through the proportional term alone
+	const double INTEGRAL_SECONDS = 30;			// integral time of the controller
+	const double JITTER_WINDOW_SECONDS = 1;
+	const double JITTER_HEADROOM = 1.5;
+	const double TARGET_DECAY = 0.002;			// per jitter window, so rare jitter spikes are remembered for minutes
+	const double FILL_SMOOTHING = 0.05;
+	const double MAX_DRIFT = 0.001;				// 1000 ppm
+	const double MAX_CORRECTION = 0.002;
+
+	size_t			mFramesPerBlock = 0, mRingBufferFrames = 0;
+	double			mProportionalGain = 0, mIntegralGain = 0;
+	size_t			mJitterWindowBlocks = 1, mWindowBlocks = 0, mWindowMin = 0, mWindowMax = 0;
+	double			mRatio = 1, mIntegral = 0, mPhase = 0, mFillSmoothed = -1, mTarget = 0;
+	bool			mPriming = true;
+	BufferDynamic	mSourceBuffer;
+};
+
+//! Per-stream callback counters and a log-spaced histogram of callback durations, updated lock-free from the stream's callback.
+class StreamStats {
+  public:
+	StreamStats()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		mNumCallbacks = 0;
+		for( auto &count : mStatusCounts )
+			count = 0;
+		for( auto &count : mDurationBuckets )
+			count = 0;
+		mDurationSumNanos = 0;
+		mDurationMaxNanos = 0;
+	}
+
+	// Called on the stream's callback thread
+	void recordCallback( PaStreamCallbackFlags statusFlags, chrono::steady_clock::duration duration )
+	{
+		mNumCallbacks.fetch_add( 1, memory_order_relaxed );
+		if( statusFlags ) {
+			for( size_t i = 0; i < NUM_STATUS_FLAGS; i++ ) {
+				if( statusFlags & ( 1 << i ) )
+					mStatusCounts[i].fetch_add( 1, memory_order_relaxed );
+			}
+		}
+
+		uint64_t nanos = (uint64_t)chrono::duration_cast<chrono::nanoseconds>( duration ).count();
+		mDurationBuckets[getBucket( nanos )].fetch_add( 1, memory_order_relaxed );
+		mDurationSumNanos.fetch_add( nanos, memory_order_relaxed );
+
+		uint64_t prevMax = mDurationMaxNanos.load( memory_order_relaxed );
+		while( nanos > prevMax && ! mDurationMaxNanos.compare_exchange_weak( prevMax, nanos, memory_order_relaxed ) )
+			;
+	}
+
+	void fill( StreamTelemetryPortAudio *telemetry ) const
+	{
+		uint64_t numCallbacks = mNumCallbacks.load( memory_order_relaxed );
+		telemetry->mNumCallbacks = numCallbacks;
+		telemetry->mNumInputUnderflows = mStatusCounts[0].load( memory_order_relaxed );		// paInputUnderflow
+		telemetry->mNumInputOverflows = mStatusCounts[1].load( memory_order_relaxed );		// paInputOverflow
+		telemetry->mNumOutputUnderflows = mStatusCounts[2].load( memory_order_relaxed );	// paOutputUnderflow
+		telemetry->mNumOutputOverflows = mStatusCounts[3].load( memory_order_relaxed );		// paOutputOverflow
+		telemetry->mNumPrimingOutputs = mStatusCounts[4].load( memory_order_relaxed );		// paPrimingOutput
+
+		if( numCallbacks == 0 )
+			return;
+
+		telemetry->mCallbackDurationAverage = (double)mDurationSumNanos.load( memory_order_relaxed ) * 1e-9 / (double)numCallbacks;
+		telemetry->mCallbackDurationMax = (double)mDurationMaxNanos.load( memory_order_relaxed ) * 1e-9;
+
+		uint64_t counts[NUM_BUCKETS];
+		uint64_t total = 0;
+		for( size_t i = 0; i < NUM_BUCKETS; i++ ) {
+			counts[i] = mDurationBuckets[i].load( memory_order_relaxed );
+			total += counts[i];
+		}
+
+		telemetry->mCallbackDurationP50 = getPercentile( counts, total, 0.50 );
+		telemetry->mCallbackDurationP95 = getPercentile( counts, total, 0.95 );
+		telemetry->mCallbackDurationP99 = getPercentile( counts, total, 0.99 );
+	}
+
+  private:
+	static const size_t NUM_STATUS_FLAGS = 5;		// paInputUnderflow through paPrimingOutput
+	static const size_t NUM_BUCKETS = 96;			// quarter octaves from 1 microsecond, up to about 14 seconds
+	static const size_t BUCKETS_PER_OCTAVE = 4;
+
+	static size_t getBucket( uint64_t nanos )
+	{
+		double micros = (double)nanos * 1e-3;
+		if( micros <= 1 )
+			return 0;
+
+		size_t bucket = 1 + (size_t)( log2( micros ) * BUCKETS_PER_OCTAVE );
+		return min( bucket, NUM_BUCKETS - 1 );
+	}
+
+	// Returns the upper bound of a bucket, in seconds
+	static double getBucketUpperBound( size_t bucket )
+	{
+		return exp2( (double)bucket / BUCKETS_PER_OCTAVE ) * 1e-6;
+	}
+
+	static double getPercentile( const uint64_t *counts, uint64_t total, double percentile )
+	{
+		if( total == 0 )
+			return 0;
+
+		uint64_t threshold = (uint64_t)ceil( percentile * (double)total );
+		uint64_t accumulated = 0;
+		for( size_t i = 0; i < NUM_BUCKETS; i++ ) {
+			accumulated += counts[i];
+			if( accumulated >= threshold )
+				return getBucketUpperBound( i );
+		}
+
+		return getBucketUpperBound( NUM_BUCKETS - 1 );
+	}
+
+	atomic<uint64_t>	mNumCallbacks;
+	atomic<uint64_t>	mStatusCounts[NUM_STATUS_FLAGS];
+	atomic<uint64_t>	mDurationBuckets[NUM_BUCKETS];
+	atomic<uint64_t>	mDurationSumNanos, mDurationMaxNanos;
+};
+
+// Fills in the fields of telemetry that come from PortAudio's stream API
+void fillStreamTelemetry( PaStream *stream, StreamTelemetryPortAudio *telemetry )
+{
+	telemetry->mIsOpen = stream != nullptr;
+	if( ! stream )
+		return;
+
+	telemetry->mCpuLoad = Pa_GetStreamCpuLoad( stream );
+
+	PaStreamCpuLoadStats cpuLoadStats;
+	if( Pa_GetStreamCpuLoadStats( stream, &cpuLoadStats ) == paNoError ) {
+		telemetry->mCpuLoadPeak = cpuLoadStats.peakLoad;
+		telemetry->mNumCpuOverloads = cpuLoadStats.overloadCount;
+	}
+
+	const PaStreamInfo *streamInfo = Pa_GetStreamInfo( stream );
+	if( streamInfo ) {
+		telemetry->mInputLatency = streamInfo->inputLatency;
+		telemetry->mOutputLatency = streamInfo->outputLatency;
+		telemetry->mSampleRate = streamInfo->sampleRate;
+	}
+}
+
+class DeadlineWatchdog;
+
+// the watchdog of the output stream callback that is running on the current thread, so that input nodes processed during it can report their ring levels
+thread_local DeadlineWatchdog *sCurrentDeadlineWatchdog = nullptr;
+
+//! Checks output stream callbacks against their deadline, capturing a snapshot of each miss into one of a fixed number of preallocated slots.
+//! The audio thread never waits on a slot: if a reader is copying it, that snapshot is dropped (the miss is still counted).
+class DeadlineWatchdog {
+  public:
+	static const size_t NUM_SLOTS = 16;
+	static const size_t MAX_NODES = 64;
+	static const size_t MAX_RING_LEVELS = 8;
+	// lower bound of the deadline fraction, a callback can't be expected to finish in less than 1% of its budget
+	static constexpr double MIN_FRACTION = 0.01;
+
+	static DeadlineWatchdog* getCurrent()	{ return sCurrentDeadlineWatchdog; }
+
+	bool	isEnabled() const					{ return mEnabled.load( memory_order_relaxed ); }
+	void	setEnabled( bool enable )			{ mEnabled = enable; }
+	double	getFraction() const					{ return mFraction.load( memory_order_relaxed ); }
+	void	setFraction( double fraction )		{ mFraction = ( fraction >= MIN_FRACTION ) ? std::min( fraction, 1.0 ) : MIN_FRACTION; }
+	uint64_t	getNumMisses() const			{ return mNumMisses.load( memory_order_relaxed ); }
+
+	// Called on the callback thread before the graph is rendered
+	void beginCallback( uint64_t frame, uint64_t timestampNanos )
+	{
+		mFrame = frame;
+		mTimestampNanos = timestampNanos;
+		mNumNodes = 0;
+		mNumRingLevels = 0;
+		sCurrentDeadlineWatchdog = this;
+	}
+
+	// Called after each block is rendered, accumulating node times when the callback renders more than one block
+	void addNodeTimings( const NodeProfilerPortAudio *profiler )
+	{
+		const Node *nodes[MAX_NODES];
+		double seconds[MAX_NODES];
+		size_t numNodes = profiler->copyLastBlock( nodes, seconds, MAX_NODES );
+		for( size_t i = 0; i < numNodes; i++ ) {
+			size_t index = 0;
+			while( index < mNumNodes && mNodeTimings[index].mNode != nodes[i] )
+				index++;
+
+			if( index == mNumNodes ) {
+				if( mNumNodes == MAX_NODES )
+					continue;
+
+				mNodeTimings[mNumNodes++] = { nodes[i], 0 };
+			}
+
+			mNodeTimings[index].mSeconds += seconds[i];
+		}
+	}
+
+	void addRingLevel( const Node *node, size_t framesBuffered, size_t capacity )
+	{
+		if( mNumRingLevels < MAX_RING_LEVELS )
+			mRingLevels[mNumRingLevels++] = { node, framesBuffered, capacity };
+	}
+
+	// Called on the callback thread after the graph is rendered. Returns true and fills in threshold if the callback missed its deadline.
+	bool endCallback( size_t framesPerBuffer, double sampleRate, double duration, PaStreamCallbackFlags statusFlags, const PaStreamCallbackTimeInfo *timeInfo, double *threshold )
+	{
+		sCurrentDeadlineWatchdog = nullptr;
+
+		const double budget = sampleRate > 0 ? (double)framesPerBuffer / sampleRate : 0;
+		*threshold = budget * getFraction();
+		if( duration <= *threshold )
+			return false;
+
+		uint64_t missIndex = mNumMisses.fetch_add( 1, memory_order_relaxed ) + 1;
+		Slot &slot = mSlots[missIndex % NUM_SLOTS];
+		if( slot.mBusy.exchange( true, memory_order_acquire ) )
+			return true; // being read, drop this snapshot
+
+		auto &snapshot = slot.mSnapshot;
+		snapshot.mMissIndex = missIndex;
+		snapshot.mFrame = mFrame;
+		snapshot.mTimestampNanos = mTimestampNanos;
+		snapshot.mFramesPerBuffer = framesPerBuffer;
+		snapshot.mBudget = budget;
+		snapshot.mThreshold = *threshold;
+		snapshot.mDuration = duration;
+		snapshot.mStatusFlags = statusFlags;
+		if( timeInfo ) {
+			snapshot.mInputBufferAdcTime = timeInfo->inputBufferAdcTime;
+			snapshot.mCurrentTime = timeInfo->currentTime;
+			snapshot.mOutputBufferDacTime = timeInfo->outputBufferDacTime;
+		}
+
+		copy( mNodeTimings, mNodeTimings + mNumNodes, slot.mNodeTimings );
+		slot.mNumNodes = mNumNodes;
+		copy( mRingLevels, mRingLevels + mNumRingLevels, slot.mRingLevels );
+		slot.mNumRingLevels = mNumRingLevels;
+
+		slot.mBusy.store( false, memory_order_release );
+		return true;
+	}
+
+	// Call from a non-realtime thread
+	vector<DeadlineSnapshotPortAudio> getSnapshots() const
+	{
+		vector<DeadlineSnapshotPortAudio> result;
+		for( auto &slot : mSlots ) {
+			lockSlot( slot );
+			if( slot.mSnapshot.mMissIndex ) {
+				result.push_back( slot.mSnapshot );
+				auto &snapshot = result.back();
+				snapshot.mNodeTimings.assign( slot.mNodeTimings, slot.mNodeTimings + slot.mNumNodes );
+				snapshot.mRingLevels.assign( slot.mRingLevels, slot.mRingLevels + slot.mNumRingLevels );
+			}
+			slot.mBusy.store( false, memory_order_release );
+		}
+
+		sort( result.begin(), result.end(), []( const DeadlineSnapshotPortAudio &a, const DeadlineSnapshotPortAudio &b ) { return a.mMissIndex < b.mMissIndex; } );
+		for( auto &snapshot : result ) {
+			sort( snapshot.mNodeTimings.begin(), snapshot.mNodeTimings.end(), []( const DeadlineSnapshotPortAudio::NodeTiming &a, const DeadlineSnapshotPortAudio::NodeTiming &b ) { return a.mSeconds > b.mSeconds; } );
+		}
+
+		return result;
+	}
+
+	void clear()
+	{
+		mNumMisses = 0;
+		for( auto &slot : mSlots ) {
+			lockSlot( slot );
+			slot.mSnapshot.mMissIndex = 0;
+			slot.mBusy.store( false, memory_order_release );
+		}
+	}
+
+  private:
+	// The snapshot's vectors are left empty so that the audio thread never allocates, node timings and ring levels are kept in fixed arrays alongside it
+	struct Slot {
+		mutable atomic<bool>					mBusy = { false };
+		DeadlineSnapshotPortAudio				mSnapshot;
+		DeadlineSnapshotPortAudio::NodeTiming	mNodeTimings[MAX_NODES];
+		DeadlineSnapshotPortAudio::RingLevel	mRingLevels[MAX_RING_LEVELS];
+		size_t									mNumNodes = 0, mNumRingLevels = 0;
+	};
+
+	static void lockSlot( const Slot &slot )
+	{
+		while( slot.mBusy.exchange( true, memory_order_acquire ) )
+			this_thread::yield();
+	}
+
+	atomic<bool>		mEnabled = { false };
+	atomic<double>		mFraction = { 0.8 };
+	atomic<uint64_t>	mNumMisses = { 0 };
+	Slot				mSlots[NUM_SLOTS];
+
+	// current callback, only touched on the callback thread
+	uint64_t								mFrame = 0, mTimestampNanos = 0;
+	DeadlineSnapshotPortAudio::NodeTiming	mNodeTimings[MAX_NODES];
+	DeadlineSnapshotPortAudio::RingLevel	mRingLevels[MAX_RING_LEVELS];
+	size_t									mNumNodes = 0, mNumRingLevels = 0;
+};
+
+} // anonymous namespace
+
 // ----------------------------------------------------------------------------------------------------
 // OutputDeviceNodePortAudio::Impl
 // ----------------------------------------------------------------------------------------------------
@@ -56,17 +786,174 @@ struct OutputDeviceNodePortAudio::Impl {
 	{
 		auto parent = (OutputDeviceNodePortAudio *)userData;
 
-		float *out = (float*)outputBuffer;
-		const float *in = (const float *)inputBuffer; // needed in the case of full duplex I/O
-
+		// inputBuffer is needed in the case of full duplex I/O. Both buffers are either interleaved arrays or arrays of per-channel pointers, depending on mNonInterleaved, with samples in the stream's sample format
 		LOG_CAPTURE( "framesPerBuffer: " << framesPerBuffer << ", statusFlags: " << statusFlags << hex << ", input buffer: " << inputBuffer << ", outputBuffer: " << outputBuffer << dec );		
-		parent->renderAudio( in, out, (size_t)framesPerBuffer );
+		auto impl = parent->mImpl.get();
+		auto startTime = chrono::steady_clock::now();
+		const bool watchdogEnabled = impl->mDeadlineWatchdog.isEnabled();
+		if( watchdogEnabled )
+			impl->mDeadlineWatchdog.beginCallback( impl->mContext ? impl->mContext->getNumProcessedFrames() : 0, (uint64_t)chrono::duration_cast<chrono::nanoseconds>( startTime.time_since_epoch() ).count() );
+
+		parent->renderAudio( inputBuffer, outputBuffer, (size_t)framesPerBuffer );
+
+		auto duration = chrono::steady_clock::now() - startTime;
+		impl->mStreamStats.recordCallback( statusFlags, duration );
+		if( watchdogEnabled )
+			impl->checkDeadline( (size_t)framesPerBuffer, chrono::duration<double>( duration ).count(), statusFlags, timeInfo );
 
 		return paContinue;
 	}
 
+	// Called on the callback thread when the deadline watchdog is enabled
+	void checkDeadline( size_t framesPerBuffer, double duration, PaStreamCallbackFlags statusFlags, const PaStreamCallbackTimeInfo *timeInfo )
+	{
+		double threshold;
+		if( mDeadlineWatchdog.endCallback( framesPerBuffer, mStreamSampleRate, duration, statusFlags, timeInfo, &threshold ) && mContext )
+			mContext->recordDiagnosticEvent( ContextPortAudio::DiagnosticEvent::Type::DEADLINE_MISS, mParent, mContext->getNumProcessedFrames(), (uint64_t)( duration * 1e6 ), (uint64_t)( threshold * 1e6 ) );
+	}
+
+	// Copies numFrames from source, starting at sourceOffset, to the host's outputBuffer starting at outputOffset
+	void writeOutputBuffer( const Buffer *source, size_t sourceOffset, void *outputBuffer, size_t outputOffset, size_t numFrames )
+	{
+		writeHostBuffer( source->getData() + sourceOffset, source->getNumFrames(), source->getNumChannels(), outputBuffer, outputOffset, numFrames, mStreamSampleFormat, mNonInterleaved );
+	}
+
+	// Sets up rendering to mVirtualBuffer in place of a PortAudio stream, for the virtual output device
+	void initVirtual( size_t numChannels, size_t framesPerBlock, double sampleRate )
+	{
+		mVirtual = true;
+		mNonInterleaved = true;
+		mStreamSampleFormat = SampleFormatPortAudio::FLOAT_32;
+		mVariableBufferSize = false;
+		mAdapterFramesRemaining = 0;
+		mStreamSampleRate = sampleRate;
+		mStreamStats.reset();
+
+		mVirtualFramesRendered = 0;
+		mVirtualComplete = false;
+		mVirtualBuffer.setSize( framesPerBlock, numChannels );
+		mVirtualChannels.resize( numChannels );
+		for( size_t ch = 0; ch < numChannels; ch++ )
+			mVirtualChannels[ch] = mVirtualBuffer.getChannel( ch );
+
+		mVirtualTargetFile.reset();
+		if( ! mVirtualFilePath.empty() )
+			mVirtualTargetFile = TargetFile::create( mVirtualFilePath, (size_t)sampleRate, numChannels, mVirtualFileSampleType );
+	}
+
+	void startVirtualRender()
+	{
+		if( mVirtualThread.joinable() )
+			return;
+
+		mVirtualShouldQuit = false;
+		mVirtualThread = thread( [this] { runVirtualRender(); } );
+	}
+
+	void stopVirtualRender()
+	{
+		if( ! mVirtualThread.joinable() )
+			return;
+
+		mVirtualShouldQuit = true;
+		mVirtualThread.join();
+	}
+
+	// Runs on mVirtualThread, calling streamCallback() with timestamps from the virtual clock, as a PortAudio stream would
+	void runVirtualRender()
+	{
+		const auto sink = mVirtualSink;
+		const size_t framesPerBlock = mVirtualBuffer.getNumFrames();
+
+		// pacing restarts from the current time whenever the clock rate changes
+		auto pacingStartTime = chrono::steady_clock::now();
+		uint64_t pacingFrames = 0;
+		double pacingRate = mVirtualClockRate;
+
+		while( ! mVirtualShouldQuit ) {
+			uint64_t frameLimit = mVirtualFrameLimit;
+			if( frameLimit && mVirtualFramesRendered >= frameLimit ) {
+				mVirtualComplete = true;
+				break;
+			}
+
+			PaStreamCallbackTimeInfo timeInfo;
+			timeInfo.currentTime = (double)mVirtualFramesRendered / mStreamSampleRate;
+			timeInfo.inputBufferAdcTime = timeInfo.currentTime;
+			timeInfo.outputBufferDacTime = timeInfo.currentTime;
+			streamCallback( nullptr, mVirtualChannels.data(), (unsigned long)framesPerBlock, &timeInfo, 0, mParent );
+
+			if( sink )
+				sink( mVirtualBuffer );
+			if( mVirtualTargetFile )
+				mVirtualTargetFile->write( &mVirtualBuffer );
+
+			mVirtualFramesRendered += framesPerBlock;
+			pacingFrames += framesPerBlock;
+
+			double rate = mVirtualClockRate;
+			if( rate != pacingRate ) {
+				pacingStartTime = chrono::steady_clock::now();
+				pacingFrames = 0;
+				pacingRate = rate;
+			}
+			else if( rate > 0 ) {
+				auto pacingDuration = chrono::duration<double>( (double)pacingFrames / ( mStreamSampleRate * rate ) );
+				this_thread::sleep_until( pacingStartTime + chrono::duration_cast<chrono::steady_clock::duration>( pacingDuration ) );
+			}
+		}
+	}
+
+	void zeroOutputBuffer( void *outputBuffer, size_t numFrames, size_t numChannels )
+	{
+		const size_t bytesPerSample = getBytesPerSample( mStreamSampleFormat );
+		if( mNonInterleaved ) {
+			void **outChannels = (void **)outputBuffer;
+			for( size_t ch = 0; ch < numChannels; ch++ )
+				memset( outChannels[ch], 0, numFrames * bytesPerSample );
+		}
+		else {
+			memset( outputBuffer, 0, numFrames * numChannels * bytesPerSample );
+		}
+	}
+
 	PaStream *mStream = nullptr;
 	OutputDeviceNodePortAudio*	mParent;
+
+	bool	mNonInterleavedEnabled = true;
+	bool	mNonInterleaved = false;
+	bool	mVariableBufferSizeEnabled = false;
+	bool	mVariableBufferSize = false;
+	bool	mNoiseShapedDitherEnabled = false;
+	size_t	mAdapterFramesRemaining = 0; // frames of the internal buffer that haven't yet been written to the host, when mVariableBufferSize is true
+
+	SampleFormatPortAudio	mSampleFormat = SampleFormatPortAudio::FLOAT_32;
+	SampleFormatPortAudio	mStreamSampleFormat = SampleFormatPortAudio::FLOAT_32;
+	SampleFormatPortAudio	mFullDuplexInputSampleFormat = SampleFormatPortAudio::FLOAT_32;
+
+	ContextPortAudio*	mContext = nullptr; // cached in initialize() for recording diagnostic events
+	StreamStats			mStreamStats;
+	DeadlineWatchdog	mDeadlineWatchdog;
+	double				mStreamSampleRate = 0;
+
+	atomic<bool>		mNonBlockingRender = { false };
+	atomic<uint64_t>	mNumRenderContentions = { 0 };
+	atomic<uint64_t>	mNumSkippedBlocks = { 0 };
+
+	// virtual output, used in place of mStream when the device is DeviceManagePortAudio::getVirtualOutput()
+	bool							mVirtual = false;
+	BufferDynamic					mVirtualBuffer;
+	vector<void *>					mVirtualChannels;
+	function<void( const Buffer & )>	mVirtualSink;
+	fs::path						mVirtualFilePath;
+	SampleType						mVirtualFileSampleType = SampleType::INT_16;
+	unique_ptr<TargetFile>			mVirtualTargetFile;
+	thread							mVirtualThread;
+	atomic<bool>					mVirtualShouldQuit = { false };
+	atomic<bool>					mVirtualComplete = { false };
+	atomic<double>					mVirtualClockRate = { 1 };
+	atomic<uint64_t>				mVirtualFrameLimit = { 0 };
+	atomic<uint64_t>				mVirtualFramesRendered = { 0 };
 };
 
 // ----------------------------------------------------------------------------------------------------
@@ -82,14 +969,24 @@ OutputDeviceNodePortAudio::OutputDeviceNodePortAudio( const DeviceRef &device, c
 
 OutputDeviceNodePortAudio::~OutputDeviceNodePortAudio()
 {
+	// the virtual render thread calls back into this node, so must be stopped before it is destroyed
+	mImpl->stopVirtualRender();
 }
 
 void OutputDeviceNodePortAudio::initialize()
 {
 	LOG_CI_PORTAUDIO( "bang" );
 
+	mImpl->mContext = dynamic_cast<ContextPortAudio *>( getContext().get() );
 	auto manager = dynamic_cast<DeviceManagePortAudio *>( Context::deviceManager() );
 
+	mImpl->mVirtual = false;
+	if( manager->isVirtual( getDevice() ) ) {
+		LOG_CI_PORTAUDIO( "\t- rendering to virtual output" );
+		mImpl->initVirtual( getNumChannels(), getOutputFramesPerBlock(), getOutputSampleRate() );
+		return;
+	}
+
 	PaDeviceIndex devIndex = (PaDeviceIndex) manager->getPaDeviceIndex( getDevice() );
 	const PaDeviceInfo *devInfo = Pa_GetDeviceInfo( devIndex );
 
@@ -97,13 +994,12 @@ void OutputDeviceNodePortAudio::initialize()
 	PaStreamParameters outputParams;
 	outputParams.device = devIndex;
 	outputParams.channelCount = getNumChannels();
-	//outputParams.sampleFormat = paFloat32 | paNonInterleaved; // TODO: try non-interleaved
-	outputParams.sampleFormat = paFloat32;
 	outputParams.hostApiSpecificStreamInfo = NULL;
 
 	size_t framesPerBlock = getOutputFramesPerBlock();
 	double sampleRate = getOutputSampleRate();
-	outputParams.suggestedLatency = getDevice()->getFramesPerBlock() / sampleRate;	
+	outputParams.suggestedLatency = manager->getSuggestedOutputLatency( getDevice() );
+	mImpl->mStreamSampleFormat = selectSampleFormat( mImpl->mSampleFormat, &outputParams, false, sampleRate );
 
 	// check if any current device nodes are an input device node and have this same device
 	auto ctx = dynamic_pointer_cast<ContextPortAudio>( getContext() );
@@ -122,34 +1018,66 @@ void OutputDeviceNodePortAudio::initialize()
 		}
 	}
 
+	// the block adapter in renderAudio() allows the host to choose its own buffer size. Full duplex I/O needs input to arrive in whole blocks, so isn't supported.
+	mImpl->mVariableBufferSize = mImpl->mVariableBufferSizeEnabled && ! mFullDuplexIO;
+	mImpl->mAdapterFramesRemaining = 0;
+	unsigned long framesPerBuffer = mImpl->mVariableBufferSize ? paFramesPerBufferUnspecified : (unsigned long)framesPerBlock;
+
 	// if full duplex I/O, this output node's stream will be used instead of the input node
-	PaStreamFlags streamFlags = 0;
+	PaStreamFlags streamFlags = mImpl->mNoiseShapedDitherEnabled ? paDitherNoiseShaped : 0;
 	if( mFullDuplexIO ) {
 		LOG_CI_PORTAUDIO( "\t- opening full duplex stream" );
 		mFullDuplexIO = true;
 		PaStreamParameters inputParams;
 		inputParams.device = devIndex;
 		inputParams.channelCount = getNumChannels();
-		inputParams.sampleFormat = paFloat32;
 		inputParams.hostApiSpecificStreamInfo = NULL;
-		inputParams.suggestedLatency = getDevice()->getFramesPerBlock() / sampleRate;
+		inputParams.suggestedLatency = manager->getSuggestedInputLatency( getDevice() );
+		mImpl->mFullDuplexInputSampleFormat = selectSampleFormat( mFullDuplexInputDeviceNode->getSampleFormat(), &inputParams, true, sampleRate );
+
+		mImpl->mNonInterleaved = mImpl->mNonInterleavedEnabled && isNonInterleavedSupported( &inputParams, &outputParams, sampleRate );
+		if( mImpl->mNonInterleaved ) {
+			inputParams.sampleFormat |= paNonInterleaved;
+			outputParams.sampleFormat |= paNonInterleaved;
+		}
 
-		PaError err = Pa_OpenStream( &mImpl->mStream, &inputParams, &outputParams, sampleRate, framesPerBlock, streamFlags, &Impl::streamCallback, this );
+		LOG_CI_PORTAUDIO( "\t- non-interleaved: " << boolalpha << mImpl->mNonInterleaved );
+		PaError err = Pa_OpenStream( &mImpl->mStream, &inputParams, &outputParams, sampleRate, framesPerBuffer, streamFlags, &Impl::streamCallback, this );
 		if( err != paNoError ) {
 			throw ContextPortAudioExc( "Failed to open stream for output device named '" + getDevice()->getName() + " (full duplex)", err );
 		}
 	}
 	else {
 		LOG_CI_PORTAUDIO( "\t- opening half duplex stream" );
-		PaError err = Pa_OpenStream( &mImpl->mStream, nullptr, &outputParams, sampleRate, framesPerBlock, streamFlags, &Impl::streamCallback, this );
+		mImpl->mNonInterleaved = mImpl->mNonInterleavedEnabled && isNonInterleavedSupported( nullptr, &outputParams, sampleRate );
+		if( mImpl->mNonInterleaved )
+			outputParams.sampleFormat |= paNonInterleaved;
+
+		LOG_CI_PORTAUDIO( "\t- non-interleaved: " << boolalpha << mImpl->mNonInterleaved << ", variable buffer size: " << mImpl->mVariableBufferSize );
+		PaError err = Pa_OpenStream( &mImpl->mStream, nullptr, &outputParams, sampleRate, framesPerBuffer, streamFlags, &Impl::streamCallback, this );
 		if( err != paNoError ) {
 			throw ContextPortAudioExc( "Failed to open stream for output device named '" + getDevice()->getName() + " (half duplex)", err );
 		}
 	}
+
+	mImpl->mStreamStats.reset();
+	mImpl->mStreamSampleRate = sampleRate;
+
+	const PaStreamInfo *streamInfo = Pa_GetStreamInfo( mImpl->mStream );
+	if( streamInfo ) {
+		LOG_CI_PORTAUDIO( "\t- suggested output latency: " << outputParams.suggestedLatency << ", granted input latency: " << streamInfo->inputLatency << ", output latency: " << streamInfo->outputLatency );
+		manager->setGrantedLatency( getDevice(), mFullDuplexIO ? streamInfo->inputLatency : 0, streamInfo->outputLatency );
+	}
 }
 
 void OutputDeviceNodePortAudio::uninitialize()
 {
+	if( mImpl->mVirtual ) {
+		mImpl->stopVirtualRender();
+		mImpl->mVirtualTargetFile.reset();
+		return;
+	}
+
 	PaError err = Pa_CloseStream( mImpl->mStream );
 	CI_ASSERT( err == paNoError );
 
@@ -158,49 +1086,288 @@ void OutputDeviceNodePortAudio::uninitialize()
 
 void OutputDeviceNodePortAudio::enableProcessing()
 {
+	if( mImpl->mVirtual ) {
+		mImpl->startVirtualRender();
+		return;
+	}
+
 	PaError err = Pa_StartStream( mImpl->mStream );
 	CI_ASSERT( err == paNoError );
 }
 
 void OutputDeviceNodePortAudio::disableProcessing()
 {
+	if( mImpl->mVirtual ) {
+		mImpl->stopVirtualRender();
+		return;
+	}
+
 	PaError err = Pa_StopStream( mImpl->mStream );
 	CI_ASSERT( err == paNoError );
 }
 
-void OutputDeviceNodePortAudio::renderAudio( const float *inputBuffer, float *outputBuffer, size_t framesPerBuffer )
+void OutputDeviceNodePortAudio::enableNonBlockingRender( bool enable )
+{
+	mImpl->mNonBlockingRender = enable;
+}
+
+bool OutputDeviceNodePortAudio::isNonBlockingRenderEnabled() const
+{
+	return mImpl->mNonBlockingRender;
+}
+
+uint64_t OutputDeviceNodePortAudio::getNumRenderContentions() const
+{
+	return mImpl->mNumRenderContentions;
+}
+
+uint64_t OutputDeviceNodePortAudio::getNumSkippedBlocks() const
+{
+	return mImpl->mNumSkippedBlocks;
+}
+
+void OutputDeviceNodePortAudio::enableNonInterleavedStream( bool enable )
+{
+	mImpl->mNonInterleavedEnabled = enable;
+}
+
+bool OutputDeviceNodePortAudio::isNonInterleavedStreamEnabled() const
+{
+	return mImpl->mNonInterleavedEnabled;
+}
+
+bool OutputDeviceNodePortAudio::isStreamNonInterleaved() const
+{
+	return mImpl->mNonInterleaved;
+}
+
+void OutputDeviceNodePortAudio::setSampleFormat( SampleFormatPortAudio format )
+{
+	mImpl->mSampleFormat = format;
+}
+
+SampleFormatPortAudio OutputDeviceNodePortAudio::getSampleFormat() const
+{
+	return mImpl->mSampleFormat;
+}
+
+SampleFormatPortAudio OutputDeviceNodePortAudio::getStreamSampleFormat() const
+{
+	return mImpl->mStreamSampleFormat;
+}
+
+StreamTelemetryPortAudio OutputDeviceNodePortAudio::getStreamTelemetry() const
+{
+	StreamTelemetryPortAudio result;
+	result.mNode = this;
+	result.mDeviceName = getDevice()->getName();
+	result.mIsFullDuplex = mFullDuplexIO;
+	fillStreamTelemetry( mImpl->mStream, &result );
+	mImpl->mStreamStats.fill( &result );
+	if( mImpl->mVirtual ) {
+		result.mIsOpen = isInitialized();
+		result.mSampleRate = mImpl->mStreamSampleRate;
+	}
+
+	return result;
+}
+
+void OutputDeviceNodePortAudio::resetStreamTelemetry()
+{
+	mImpl->mStreamStats.reset();
+	if( mImpl->mStream )
+		Pa_ResetStreamCpuLoadStats( mImpl->mStream );
+}
+
+void OutputDeviceNodePortAudio::enableDeadlineWatchdog( bool enable )
+{
+	mImpl->mDeadlineWatchdog.setEnabled( enable );
+}
+
+bool OutputDeviceNodePortAudio::isDeadlineWatchdogEnabled() const
+{
+	return mImpl->mDeadlineWatchdog.isEnabled();
+}
+
+void OutputDeviceNodePortAudio::setDeadlineFraction( double fraction )
+{
+	CI_ASSERT( fraction > 0 && fraction <= 1 );
+	mImpl->mDeadlineWatchdog.setFraction( fraction );
+}
+
+double OutputDeviceNodePortAudio::getDeadlineFraction() const
+{
+	return mImpl->mDeadlineWatchdog.getFraction();
+}
+
+uint64_t OutputDeviceNodePortAudio::getNumDeadlineMisses() const
+{
+	return mImpl->mDeadlineWatchdog.getNumMisses();
+}
+
+std::vector<DeadlineSnapshotPortAudio> OutputDeviceNodePortAudio::getDeadlineSnapshots() const
+{
+	return mImpl->mDeadlineWatchdog.getSnapshots();
+}
+
+void OutputDeviceNodePortAudio::clearDeadlineSnapshots()
+{
+	mImpl->mDeadlineWatchdog.clear();
+}
+
+bool OutputDeviceNodePortAudio::isVirtual() const
+{
+	auto manager = dynamic_cast<DeviceManagePortAudio *>( Context::deviceManager() );
+	return manager && manager->isVirtual( getDevice() );
+}
+
+void OutputDeviceNodePortAudio::setVirtualSink( const std::function<void( const Buffer &buffer )> &sink )
+{
+	mImpl->mVirtualSink = sink;
+}
+
+void OutputDeviceNodePortAudio::setVirtualOutputFile( const fs::path &filePath, SampleType sampleType )
+{
+	mImpl->mVirtualFilePath = filePath;
+	mImpl->mVirtualFileSampleType = sampleType;
+}
+
+void OutputDeviceNodePortAudio::setVirtualClockRate( double rate )
+{
+	CI_ASSERT( rate >= 0 );
+	mImpl->mVirtualClockRate = rate;
+}
+
+double OutputDeviceNodePortAudio::getVirtualClockRate() const
+{
+	return mImpl->mVirtualClockRate;
+}
+
+void OutputDeviceNodePortAudio::setVirtualFrameLimit( uint64_t numFrames )
+{
+	mImpl->mVirtualFrameLimit = numFrames;
+}
+
+uint64_t OutputDeviceNodePortAudio::getVirtualFrameLimit() const
+{
+	return mImpl->mVirtualFrameLimit;
+}
+
+uint64_t OutputDeviceNodePortAudio::getNumVirtualFramesRendered() const
+{
+	return mImpl->mVirtualFramesRendered;
+}
+
+bool OutputDeviceNodePortAudio::isVirtualRenderComplete() const
+{
+	return mImpl->mVirtualComplete;
+}
+
+void OutputDeviceNodePortAudio::enableVariableHostBufferSize( bool enable )
+{
+	mImpl->mVariableBufferSizeEnabled = enable;
+}
+
+bool OutputDeviceNodePortAudio::isVariableHostBufferSizeEnabled() const
+{
+	return mImpl->mVariableBufferSizeEnabled;
+}
+
+void OutputDeviceNodePortAudio::enableNoiseShapedDither( bool enable )
+{
+	mImpl->mNoiseShapedDitherEnabled = enable;
+}
+
+bool OutputDeviceNodePortAudio::isNoiseShapedDitherEnabled() const
+{
+	return mImpl->mNoiseShapedDitherEnabled;
+}
+
+void OutputDeviceNodePortAudio::renderAudio( const void *inputBuffer, void *outputBuffer, size_t framesPerBuffer )
 {
 	auto ctx = getContext();
 	if( ! ctx )
 		return;
 
-	lock_guard<mutex> lock( ctx->getMutex() );
+	unique_lock<mutex> lock( ctx->getMutex(), try_to_lock );
+	if( ! lock.owns_lock() ) {
+		mImpl->mNumRenderContentions++;
+		if( mImpl->mNonBlockingRender ) {
+			// the graph is being modified on another thread, output silence for this block instead of waiting
+			mImpl->mNumSkippedBlocks++;
+			mImpl->zeroOutputBuffer( outputBuffer, framesPerBuffer, getNumChannels() );
+			if( mImpl->mContext )
+				mImpl->mContext->recordDiagnosticEvent( ContextPortAudio::DiagnosticEvent::Type::RENDER_SKIPPED, this, ctx->getNumProcessedFrames(), framesPerBuffer, 0 );
+			return;
+		}
+
+		lock.lock();
+	}
+
+	// verify context still exists, since its destructor may have been holding the lock
+	ctx = getContext();
+	if( ! ctx )
+		return;
+
+	auto internalBuffer = getInternalBuffer();
+	if( ! mImpl->mVariableBufferSize ) {
+		CI_ASSERT( framesPerBuffer == getOutputFramesPerBlock() ); // expecting these to always match when the host uses a fixed buffer size
+
+		renderBlock( ctx.get(), inputBuffer );
+		mImpl->writeOutputBuffer( internalBuffer, 0, outputBuffer, 0, framesPerBuffer );
+		return;
+	}
+
+	// Block adapter: the graph is always rendered in whole blocks, on demand, and any frames left over are written at the start of the next callback.
+	const size_t blockFrames = internalBuffer->getNumFrames();
+	size_t framesWritten = 0;
+	while( framesWritten < framesPerBuffer ) {
+		if( mImpl->mAdapterFramesRemaining == 0 ) {
+			renderBlock( ctx.get(), inputBuffer );
+			mImpl->mAdapterFramesRemaining = blockFrames;
+		}
 
-	// verify context still exists, since its destructor may have been holding the lock
-	ctx = getContext();
-	if( ! ctx )
-		return;
+		size_t numFrames = min( mImpl->mAdapterFramesRemaining, framesPerBuffer - framesWritten );
+		mImpl->writeOutputBuffer( internalBuffer, blockFrames - mImpl->mAdapterFramesRemaining, outputBuffer, framesWritten, numFrames );
 
-	CI_ASSERT( framesPerBuffer == getOutputFramesPerBlock() ); // currently expecting these to always match
+		framesWritten += numFrames;
+		mImpl->mAdapterFramesRemaining -= numFrames;
+	}
+}
 
+void OutputDeviceNodePortAudio::renderBlock( Context *ctx, const void *inputBuffer )
+{
 	ctx->preProcess();
 
 	if( mFullDuplexInputDeviceNode ) {
 		mFullDuplexInputDeviceNode->mFullDuplexInputBuffer = inputBuffer;
+		mFullDuplexInputDeviceNode->mFullDuplexNonInterleaved = mImpl->mNonInterleaved;
+		mFullDuplexInputDeviceNode->mFullDuplexSampleFormat = mImpl->mFullDuplexInputSampleFormat;
 	}
 
+	NodeProfilerPortAudio *profiler = mImpl->mContext ? mImpl->mContext->getActiveNodeProfiler() : nullptr;
+	if( profiler )
+		profiler->beginBlock( ctx->getNumProcessedFrames() );
+
 	auto internalBuffer = getInternalBuffer();
 	internalBuffer->zero();
-	pullInputs( internalBuffer );
+
+	PaTrace_BeginEvent( TRACE_EVENT_GRAPH_PULL, (long)internalBuffer->getNumFrames(), (long)ctx->getNumProcessedFrames() );
+	if( profiler )
+		profiler->pullInputs( shared_from_this(), internalBuffer );
+	else
+		pullInputs( internalBuffer );
+	PaTrace_EndEvent( TRACE_EVENT_GRAPH_PULL, (long)internalBuffer->getNumFrames(), 0 );
+
+	if( profiler ) {
+		profiler->endBlock();
+		if( auto watchdog = DeadlineWatchdog::getCurrent() )
+			watchdog->addNodeTimings( profiler );
+	}
 
 	if( checkNotClipping() )
 		internalBuffer->zero();
 
-	const size_t numFrames = internalBuffer->getNumFrames();
-	const size_t numChannels = internalBuffer->getNumChannels();
-
-	dsp::interleave( internalBuffer->getData(), outputBuffer, numFrames, numChannels, numFrames );
-
 	ctx->postProcess();
 }
 
@@ -210,6 +1377,7 @@ void OutputDeviceNodePortAudio::renderAudio( const float *inputBuffer, float *ou
 
 struct InputDeviceNodePortAudio::Impl {
 	const size_t RINGBUFFER_PADDING_FACTOR = 4;
+	const size_t RINGBUFFER_PADDING_FACTOR_DRIFT_CORRECTION = 8; // extra room for the jitter buffer to grow
 
 	Impl( InputDeviceNodePortAudio *parent )
 		: mParent( parent )
@@ -217,13 +1385,21 @@ struct InputDeviceNodePortAudio::Impl {
 
 	void init()
 	{
+		mContext = dynamic_cast<ContextPortAudio *>( mParent->getContext().get() );
 		mNumFramesBuffered = 0;
 		mTotalFramesCaptured = 0;
+		mNumPendingOverruns = 0;
+		mFillLevelResetRequested = true;
+		mCallbackCapture = mCallbackCaptureEnabled;
+		mDriftCorrection = mDriftCorrectionEnabled && ! mParent->mFullDuplexIO;
+		mDriftPpm = 0;
+		mJitterBufferDepth = 0;
+		mJitterBufferTarget = 0;
 
 		if( mParent->mFullDuplexIO ) {
 			// OutputDeviceNodePortAudio will provide the input buffer each frame, we don't need extra buffers or a stream.
 			mReadBuffer = {};
-			mRingBuffers.clear();
+			mRingBuffer.resize( 0, 0 );
 			return;
 		}
 
@@ -248,93 +1424,235 @@ struct InputDeviceNodePortAudio::Impl {
 			mMaxReadFrames = framesPerBlock;
 		}
 
-		for( size_t ch = 0; ch < numChannels; ch++ ) {
-			mRingBuffers.emplace_back( framesPerBlock * RINGBUFFER_PADDING_FACTOR );
-		}
+		mRingBuffer.resize( framesPerBlock * ( mDriftCorrection ? RINGBUFFER_PADDING_FACTOR_DRIFT_CORRECTION : RINGBUFFER_PADDING_FACTOR ), numChannels );
+		mFillLevelCapacity = mRingBuffer.getNumFrames();
+		if( mDriftCorrection )
+			mDriftCompensator.init( framesPerBlock, mParent->getSampleRate(), numChannels, mRingBuffer.getNumFrames() );
 
-		mReadBuffer.setSize( deviceFramesPerBlock, numChannels );
+		mReadBuffer.setSize( max( deviceFramesPerBlock, mMaxReadFrames ), numChannels );
 
-		// Open an audio I/O stream. No callbacks, we'll get pulled from the audio graph and read non-blocking
+		// Open an audio I/O stream. If callback capture is enabled, the stream callback writes to the ring buffers.
+		// Otherwise there are no callbacks, we'll get pulled from the audio graph and read non-blocking
 		PaStreamParameters inputParams;
 		inputParams.device = devIndex;
 		inputParams.channelCount = numChannels;
-		inputParams.sampleFormat = paFloat32;
 		inputParams.hostApiSpecificStreamInfo = NULL;
-		inputParams.suggestedLatency = (PaTime)framesPerBlock / (PaTime)deviceSampleRate;	
+		inputParams.suggestedLatency = manager->getSuggestedInputLatency( device );
+		mStreamSampleFormat = selectSampleFormat( mSampleFormat, &inputParams, true, deviceSampleRate );
+
+		mNonInterleaved = mNonInterleavedEnabled && isNonInterleavedSupported( &inputParams, nullptr, deviceSampleRate );
+		if( mNonInterleaved )
+			inputParams.sampleFormat |= paNonInterleaved;
+
+		// Pa_ReadStream() destination. Non-interleaved float streams read straight into the channels of mReadBuffer, other formats are read into mHostReadBuffer and then converted.
+		const size_t bytesPerSample = getBytesPerSample( mStreamSampleFormat );
+		mHostReadBuffer.resize( mReadBuffer.getSize() * bytesPerSample );
+		mReadChannels.resize( mNonInterleaved ? numChannels : 0 );
+		for( size_t ch = 0; ch < mReadChannels.size(); ch++ )
+			mReadChannels[ch] = mHostReadBuffer.data() + ch * mReadBuffer.getNumFrames() * bytesPerSample;
+
+		LOG_CI_PORTAUDIO( "\t- non-interleaved: " << boolalpha << mNonInterleaved << ", bytes per sample: " << getBytesPerSample( mStreamSampleFormat ) );
 
 		PaStreamFlags flags = 0;
-		PaError err = Pa_OpenStream( &mStream, &inputParams, nullptr, deviceSampleRate, framesPerBlock, flags, nullptr, nullptr );
+		PaStreamCallback *callback = mCallbackCapture ? &Impl::streamCallback : nullptr;
+		PaError err = Pa_OpenStream( &mStream, &inputParams, nullptr, deviceSampleRate, framesPerBlock, flags, callback, mCallbackCapture ? this : nullptr );
 		if( err != paNoError ) {
 			throw ContextPortAudioExc( "Failed to open stream for input device named '" + device->getName(), err );
 		}
+
+		mStreamStats.reset();
+
+		const PaStreamInfo *streamInfo = Pa_GetStreamInfo( mStream );
+		if( streamInfo ) {
+			LOG_CI_PORTAUDIO( "\t- suggested input latency: " << inputParams.suggestedLatency << ", granted: " << streamInfo->inputLatency );
+			manager->setGrantedLatency( device, streamInfo->inputLatency, 0 );
+		}
+	}
+
+	static int streamCallback( const void *inputBuffer, void *outputBuffer, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *userData )
+	{
+		auto impl = (InputDeviceNodePortAudio::Impl *)userData;
+		auto startTime = chrono::steady_clock::now();
+		impl->captureAudioFromCallback( inputBuffer, (size_t)framesPerBuffer );
+		impl->mStreamStats.recordCallback( statusFlags, chrono::steady_clock::now() - startTime );
+
+		return paContinue;
+	}
+
+	// Called on the input stream's thread when callback capture is enabled. Overruns are marked from process(), on the audio graph's thread
+	void captureAudioFromCallback( const void *inputBuffer, size_t framesPerBuffer )
+	{
+		const size_t numChannels = mRingBuffer.getNumChannels();
+
+		if( ! mConverter && mStreamSampleFormat == SampleFormatPortAudio::FLOAT_32 ) {
+			// write directly from PortAudio's buffer to the ring buffer
+			bool writeSuccess = mNonInterleaved ? mRingBuffer.write( (const float * const *)inputBuffer, framesPerBuffer ) : mRingBuffer.writeInterleaved( (const float *)inputBuffer, framesPerBuffer );
+			if( writeSuccess )
+				mTotalFramesCaptured += framesPerBuffer;
+			else
+				mNumPendingOverruns++;
+
+			return;
+		}
+
+		size_t offset = 0;
+		while( offset < framesPerBuffer ) {
+			size_t framesToRead = min( framesPerBuffer - offset, mMaxReadFrames );
+			mReadBuffer.setNumFrames( framesToRead );
+			readHostBuffer( inputBuffer, offset, mReadBuffer.getData(), framesToRead, numChannels, framesToRead, mStreamSampleFormat, mNonInterleaved );
+
+			bool writeSuccess;
+			size_t framesToWrite = framesToRead;
+			if( mConverter ) {
+				pair<size_t, size_t> count = mConverter->convert( &mReadBuffer, &mConverterDestBuffer );
+				framesToWrite = count.second;
+				writeSuccess = mRingBuffer.write( mConverterDestBuffer, framesToWrite );
+			}
+			else {
+				writeSuccess = mRingBuffer.write( mReadBuffer, framesToWrite );
+			}
+
+			if( writeSuccess )
+				mTotalFramesCaptured += framesToWrite;
+			else
+				mNumPendingOverruns++;
+
+			offset += framesToRead;
+		}
+	}
+
+	// Called on the audio thread
+	void recordEvent( ContextPortAudio::DiagnosticEvent::Type type, uint64_t count, uint64_t available )
+	{
+		if( mContext )
+			mContext->recordDiagnosticEvent( type, mParent, mContext->getNumProcessedFrames(), count, available );
+	}
+
+	// Called from process() with the number of frames buffered before they are consumed
+	void updateFillLevel( size_t framesBuffered )
+	{
+		if( mFillLevelResetRequested.exchange( false ) ) {
+			mFillLevelMin = framesBuffered;
+			mFillLevelMax = framesBuffered;
+			mFillLevelSum = 0;
+			mFillLevelCount = 0;
+		}
+
+		mFillLevelCurrent = framesBuffered;
+		if( framesBuffered < mFillLevelMin )
+			mFillLevelMin = framesBuffered;
+		if( framesBuffered > mFillLevelMax )
+			mFillLevelMax = framesBuffered;
+
+		mFillLevelSum += framesBuffered;
+		mFillLevelCount++;
 	}
 
-	void captureAudio( float *audioBuffer, size_t framesPerBuffer, size_t numChannels )
+	void captureAudio()
 	{
+		const size_t numChannels = mRingBuffer.getNumChannels();
+
 		// Using Read/Write I/O Methods
 		signed long readAvailable = Pa_GetStreamReadAvailable( mStream );
 		CI_ASSERT( readAvailable >= 0 );
-		LOG_CAPTURE( "[" << mParent->getContext()->getNumProcessedFrames() << "] read available: " << readAvailable << ", ring buffer write available: " << mRingBuffers[0].getAvailableWrite() );
+		LOG_CAPTURE( "[" << mParent->getContext()->getNumProcessedFrames() << "] read available: " << readAvailable << ", ring buffer write available: " << mRingBuffer.getAvailableWrite() );
+
+		PaTrace_BeginEvent( TRACE_EVENT_CAPTURE_READ, readAvailable, 0 );
+		unsigned long framesRead = 0;
 
 		while( readAvailable > 0 ) {
 			unsigned long framesToRead = min( (unsigned long)readAvailable, (unsigned long)mMaxReadFrames );
 			mReadBuffer.setNumFrames( framesToRead );
-			if( numChannels == 1 ) {
-				// capture directly into mReadBuffer
-				PaError err = Pa_ReadStream( mStream, mReadBuffer.getData(), framesToRead );
+
+			// Interleaved float streams without a Converter are written to the ring buffer without being de-interleaved.
+			// Otherwise capture into the channels of mReadBuffer, converting from the stream's sample format if needed
+			const bool isFloat = mStreamSampleFormat == SampleFormatPortAudio::FLOAT_32;
+			const bool readInterleaved = ! mNonInterleaved && ! mConverter && isFloat;
+			if( readInterleaved ) {
+				PaError err = Pa_ReadStream( mStream, mHostReadBuffer.data(), framesToRead );
+				CI_VERIFY( err == paNoError );
+			}
+			else if( mNonInterleaved && isFloat ) {
+				for( size_t ch = 0; ch < numChannels; ch++ )
+					mReadChannels[ch] = mReadBuffer.getChannel( ch );
+
+				PaError err = Pa_ReadStream( mStream, mReadChannels.data(), framesToRead );
+				CI_VERIFY( err == paNoError );
+			}
+			else if( mNonInterleaved ) {
+				PaError err = Pa_ReadStream( mStream, mReadChannels.data(), framesToRead );
 				CI_VERIFY( err == paNoError );
+				readHostBuffer( mReadChannels.data(), 0, mReadBuffer.getData(), framesToRead, numChannels, framesToRead, mStreamSampleFormat, true );
 			}
 			else {
-				// read into audioBuffer, then de-interleave into mReadBuffer
-				// TODO: does it make sense to pass in the audioBuffer here?
-				// - might also be too small when downsampling (ex. input: 48k, output: 44.1k)
-				PaError err = Pa_ReadStream( mStream, audioBuffer, framesToRead );
+				PaError err = Pa_ReadStream( mStream, mHostReadBuffer.data(), framesToRead );
 				CI_VERIFY( err == paNoError );
-				dsp::deinterleave( (float *)audioBuffer, mReadBuffer.getData(), framesPerBuffer, numChannels, framesPerBuffer );
+				readHostBuffer( mHostReadBuffer.data(), 0, mReadBuffer.getData(), framesToRead, numChannels, framesToRead, mStreamSampleFormat, false );
 			}
 
-			// write to ring buffer, use Converter if one was installed
+			// write to ring buffer, use Converter if one was installed. All channels are written or none are.
+			size_t framesToWrite = framesToRead;
+			bool writeSuccess;
 			if( mConverter ) {
 				pair<size_t, size_t> count = mConverter->convert( &mReadBuffer, &mConverterDestBuffer );
 				LOG_CAPTURE( "\t- frames read: " << framesToRead << ", converted: " << count.second );
-				for( size_t ch = 0; ch < numChannels; ch++ ) {
-					if( ! mRingBuffers[ch].write( mConverterDestBuffer.getChannel( ch ), count.second ) ) {
-						LOG_XRUN( "[" << mParent->getContext()->getNumProcessedFrames() << "] buffer overrun (with converter). failed to read from ringbuffer,  num samples to write: " << count.second << ", channel: " << ch );
-						mParent->markOverrun();
-					}
-				}
-
-				mNumFramesBuffered += count.second;
-				mTotalFramesCaptured += count.second;
+				framesToWrite = count.second;
+				writeSuccess = mRingBuffer.write( mConverterDestBuffer, framesToWrite );
 			}
 			else {
 				LOG_CAPTURE( "\t- frames read: " << framesToRead );
-				for( size_t ch = 0; ch < numChannels; ch++ ) {
-					if( ! mRingBuffers[ch].write( mReadBuffer.getChannel( ch ), framesToRead ) ) {
-						LOG_XRUN( "[" << mParent->getContext()->getNumProcessedFrames() << "] buffer overrun. failed to read from ringbuffer, num samples to write: " << framesToRead << ", channel: " << ch );
-						mParent->markOverrun();
-						return;
-					}
-				}
-				mNumFramesBuffered += framesToRead;
-				mTotalFramesCaptured += framesToRead;
+				writeSuccess = readInterleaved ? mRingBuffer.writeInterleaved( (const float *)mHostReadBuffer.data(), framesToWrite ) : mRingBuffer.write( mReadBuffer, framesToWrite );
+			}
+
+			if( ! writeSuccess ) {
+				recordEvent( ContextPortAudio::DiagnosticEvent::Type::INPUT_OVERRUN, framesToWrite, mRingBuffer.getAvailableWrite() );
+				mParent->markOverrun();
+				PaTrace_EndEvent( TRACE_EVENT_CAPTURE_READ, readAvailable, (long)( framesRead + framesToRead ) );
+				return;
 			}
 
+			framesRead += framesToRead;
+			mNumFramesBuffered += framesToWrite;
+			mTotalFramesCaptured += framesToWrite;
+
 			readAvailable = Pa_GetStreamReadAvailable( mStream );
-			LOG_CAPTURE( "[" << mParent->getContext()->getNumProcessedFrames() << "] frames buffered: " << mNumFramesBuffered << ", read available: " << readAvailable << ", ring buffer write available: " << mRingBuffers[0].getAvailableWrite() );
-			int flarg = 2;
+			LOG_CAPTURE( "[" << mParent->getContext()->getNumProcessedFrames() << "] frames buffered: " << mNumFramesBuffered << ", read available: " << readAvailable << ", ring buffer write available: " << mRingBuffer.getAvailableWrite() );
 		}
+
+		PaTrace_EndEvent( TRACE_EVENT_CAPTURE_READ, 0, (long)framesRead );
 	}
 
 	PaStream *mStream = nullptr;
 	InputDeviceNodePortAudio*	mParent;
+	ContextPortAudio*			mContext = nullptr; // cached in init() for recording diagnostic events
+	StreamStats					mStreamStats;
+	bool						mNonInterleavedEnabled = true;
+	bool						mNonInterleaved = false;
+	bool						mCallbackCaptureEnabled = false;
+	bool						mCallbackCapture = false;
+	bool						mDriftCorrectionEnabled = false;
+	bool						mDriftCorrection = false;
+	SampleFormatPortAudio		mSampleFormat = SampleFormatPortAudio::FLOAT_32;
+	SampleFormatPortAudio		mStreamSampleFormat = SampleFormatPortAudio::FLOAT_32;
+
+	DriftCompensator					mDriftCompensator;
+	atomic<double>						mDriftPpm = { 0 }, mJitterBufferDepth = { 0 }, mJitterBufferTarget = { 0 };
 
 	std::unique_ptr<dsp::Converter>		mConverter;
-	vector<dsp::RingBufferT<float>>		mRingBuffers; // storage for samples ready for consumption in the audio graph
+	FrameRingBuffer						mRingBuffer; // storage for samples ready for consumption in the audio graph
 	BufferDynamic						mReadBuffer, mConverterDestBuffer;
+	vector<uint8_t>						mHostReadBuffer; // Pa_ReadStream() destination for interleaved streams and non-interleaved integer streams
+	vector<void *>						mReadChannels; // per-channel Pa_ReadStream() pointers into mReadBuffer (float) or mHostReadBuffer (integer), used when the stream is non-interleaved
 	size_t								mNumFramesBuffered;
 	size_t								mMaxReadFrames;
-	uint64_t							mTotalFramesCaptured = 0;
+	atomic<uint64_t>					mTotalFramesCaptured = { 0 };
+	atomic<uint64_t>					mNumPendingOverruns = { 0 };
+
+	// fill level instrumentation, written from process() and read from any thread
+	atomic<size_t>						mFillLevelCurrent = { 0 }, mFillLevelMin = { 0 }, mFillLevelMax = { 0 };
+	atomic<uint64_t>					mFillLevelSum = { 0 }, mFillLevelCount = { 0 };
+	atomic<bool>						mFillLevelResetRequested = { true };
+	size_t								mFillLevelCapacity = 0;
 };
 
 // ----------------------------------------------------------------------------------------------------
@@ -342,7 +1660,7 @@ struct InputDeviceNodePortAudio::Impl {
 // ----------------------------------------------------------------------------------------------------
 
 InputDeviceNodePortAudio::InputDeviceNodePortAudio( const DeviceRef &device, const Format &format )
-	: InputDeviceNode( device, format ), mImpl( new Impl( this ) ), mFullDuplexIO( false ), mFullDuplexInputBuffer( nullptr )
+	: InputDeviceNode( device, format ), mImpl( new Impl( this ) ), mFullDuplexIO( false ), mFullDuplexNonInterleaved( false ), mFullDuplexSampleFormat( SampleFormatPortAudio::FLOAT_32 ), mFullDuplexInputBuffer( nullptr )
 {
 	LOG_CI_PORTAUDIO( "device key: " << device->getKey() );
 	LOG_CI_PORTAUDIO( "device channels: " << device->getNumInputChannels() << ", samplerate: " << device->getSampleRate() << ", framesPerBlock: " << device->getFramesPerBlock() );
@@ -420,14 +1738,128 @@ void InputDeviceNodePortAudio::disableProcessing()
 	}
 }
 
+void InputDeviceNodePortAudio::enableNonInterleavedStream( bool enable )
+{
+	mImpl->mNonInterleavedEnabled = enable;
+}
+
+bool InputDeviceNodePortAudio::isNonInterleavedStreamEnabled() const
+{
+	return mImpl->mNonInterleavedEnabled;
+}
+
+bool InputDeviceNodePortAudio::isStreamNonInterleaved() const
+{
+	return mFullDuplexIO ? mFullDuplexNonInterleaved : mImpl->mNonInterleaved;
+}
+
+void InputDeviceNodePortAudio::setSampleFormat( SampleFormatPortAudio format )
+{
+	mImpl->mSampleFormat = format;
+}
+
+SampleFormatPortAudio InputDeviceNodePortAudio::getSampleFormat() const
+{
+	return mImpl->mSampleFormat;
+}
+
+SampleFormatPortAudio InputDeviceNodePortAudio::getStreamSampleFormat() const
+{
+	return mFullDuplexIO ? mFullDuplexSampleFormat : mImpl->mStreamSampleFormat;
+}
+
+StreamTelemetryPortAudio InputDeviceNodePortAudio::getStreamTelemetry() const
+{
+	StreamTelemetryPortAudio result;
+	result.mNode = this;
+	result.mDeviceName = getDevice()->getName();
+	result.mIsInput = true;
+	result.mIsFullDuplex = mFullDuplexIO;
+	fillStreamTelemetry( mImpl->mStream, &result );
+	mImpl->mStreamStats.fill( &result );
+
+	if( ! mFullDuplexIO ) {
+		auto fillLevel = getFillLevel();
+		result.mHasFillLevel = true;
+		result.mFillLevelMin = fillLevel.mMin;
+		result.mFillLevelMax = fillLevel.mMax;
+		result.mFillLevelAverage = fillLevel.mAverage;
+		result.mFillLevelCapacity = fillLevel.mCapacity;
+	}
+
+	return result;
+}
+
+void InputDeviceNodePortAudio::resetStreamTelemetry()
+{
+	mImpl->mStreamStats.reset();
+	if( mImpl->mStream )
+		Pa_ResetStreamCpuLoadStats( mImpl->mStream );
+	resetFillLevel();
+}
+
+void InputDeviceNodePortAudio::enableCallbackCapture( bool enable )
+{
+	mImpl->mCallbackCaptureEnabled = enable;
+}
+
+bool InputDeviceNodePortAudio::isCallbackCaptureEnabled() const
+{
+	return mImpl->mCallbackCaptureEnabled;
+}
+
+InputDeviceNodePortAudio::FillLevel InputDeviceNodePortAudio::getFillLevel() const
+{
+	FillLevel result;
+	result.mCurrent = mImpl->mFillLevelCurrent;
+	result.mMin = mImpl->mFillLevelMin;
+	result.mMax = mImpl->mFillLevelMax;
+	result.mCapacity = mImpl->mFillLevelCapacity;
+
+	uint64_t count = mImpl->mFillLevelCount;
+	result.mAverage = count ? double( mImpl->mFillLevelSum ) / double( count ) : 0;
+
+	return result;
+}
+
+void InputDeviceNodePortAudio::resetFillLevel()
+{
+	mImpl->mFillLevelResetRequested = true;
+}
+
+void InputDeviceNodePortAudio::enableDriftCorrection( bool enable )
+{
+	mImpl->mDriftCorrectionEnabled = enable;
+}
+
+bool InputDeviceNodePortAudio::isDriftCorrectionEnabled() const
+{
+	return mImpl->mDriftCorrectionEnabled;
+}
+
+double InputDeviceNodePortAudio::getEstimatedDriftPpm() const
+{
+	return mImpl->mDriftPpm;
+}
+
+double InputDeviceNodePortAudio::getJitterBufferDepth() const
+{
+	return mImpl->mJitterBufferDepth;
+}
+
+double InputDeviceNodePortAudio::getJitterBufferTarget() const
+{
+	return mImpl->mJitterBufferTarget;
+}
+
 void InputDeviceNodePortAudio::process( Buffer *buffer )
 {
 	if( mFullDuplexIO ) {
 		// read from the buffer provided by OutputDeviceNodePortAudio
 		LOG_CAPTURE( "copying duplex buffer " );
 		CI_ASSERT( mFullDuplexInputBuffer );
-		
-		dsp::deinterleave( mFullDuplexInputBuffer, buffer->getData(), buffer->getNumFrames(), buffer->getNumChannels(), buffer->getNumFrames() );
+
+		readHostBuffer( mFullDuplexInputBuffer, 0, buffer->getData(), buffer->getNumFrames(), buffer->getNumChannels(), buffer->getNumFrames(), mFullDuplexSampleFormat, mFullDuplexNonInterleaved );
 	}
 	else {
 		// read from ring buffer
@@ -435,30 +1867,189 @@ void InputDeviceNodePortAudio::process( Buffer *buffer )
 
 		LOG_CAPTURE( "[" << getContext()->getNumProcessedFrames() << "] audio thread: " << getContext()->isAudioThread() << ",  frames buffered: " << mImpl->mNumFramesBuffered << ", frames needed: " << framesNeeded );
 
-		mImpl->captureAudio( buffer->getData(), framesNeeded, buffer->getNumChannels() );
+		if( mImpl->mCallbackCapture ) {
+			// the input stream's callback has already written to the ring buffers, mark any overruns that happened there
+			uint64_t numOverruns = mImpl->mNumPendingOverruns.exchange( 0 );
+			if( numOverruns ) {
+				mImpl->recordEvent( ContextPortAudio::DiagnosticEvent::Type::INPUT_OVERRUN, numOverruns, mImpl->mRingBuffer.getAvailableWrite() );
+				markOverrun();
+			}
+
+			mImpl->mNumFramesBuffered = mImpl->mRingBuffer.getAvailableRead();
+		}
+		else {
+			mImpl->captureAudio();
+		}
+
+		mImpl->updateFillLevel( mImpl->mNumFramesBuffered );
+		if( auto watchdog = DeadlineWatchdog::getCurrent() )
+			watchdog->addRingLevel( this, mImpl->mNumFramesBuffered, mImpl->mFillLevelCapacity );
+
+		// with drift correction, the number of frames read from the ring buffer varies slightly from framesNeeded
+		size_t framesToRead = framesNeeded;
+		auto &driftCompensator = mImpl->mDriftCompensator;
+		if( mImpl->mDriftCorrection ) {
+			framesToRead = driftCompensator.update( mImpl->mNumFramesBuffered, framesNeeded );
+			mImpl->mDriftPpm = driftCompensator.getDriftPpm();
+			mImpl->mJitterBufferDepth = driftCompensator.getDepth();
+			mImpl->mJitterBufferTarget = driftCompensator.getTarget();
+
+			if( driftCompensator.isPriming() ) {
+				// output silence until the jitter buffer has filled to its target
+				if( (double)mImpl->mNumFramesBuffered < driftCompensator.getTarget() ) {
+					buffer->zero();
+					return;
+				}
+
+				driftCompensator.setPriming( false );
+			}
+		}
 
-		if( mImpl->mNumFramesBuffered < framesNeeded ) {
+		if( mImpl->mNumFramesBuffered < framesToRead ) {
 			// only mark underrun once audio capture has begun
 			if( mImpl->mTotalFramesCaptured >= framesNeeded ) {
-				LOG_XRUN( "[" << getContext()->getNumProcessedFrames() << "] buffer underrun. total frames buffered: " << mImpl->mNumFramesBuffered << ", less than frames needed: " << framesNeeded << ", total captured: " << mImpl->mTotalFramesCaptured );
+				mImpl->recordEvent( ContextPortAudio::DiagnosticEvent::Type::INPUT_UNDERRUN, framesToRead, mImpl->mNumFramesBuffered );
 				markUnderrun();
 			}
+			if( mImpl->mDriftCorrection )
+				driftCompensator.setPriming( true );
+
 			return;
 		}
 
-		for( size_t ch = 0; ch < getNumChannels(); ch++ ) {
-			bool readSuccess = mImpl->mRingBuffers[ch].read( buffer->getChannel( ch ), framesNeeded );
-			//CI_VERIFY( readSuccess );
-			if( ! readSuccess ) {
-				LOG_XRUN( "[" << getContext()->getNumProcessedFrames() << "] buffer underrun. failed to read from ringbuffer, framesNeeded: " << framesNeeded << ", frames buffered: " << mImpl->mNumFramesBuffered << ", total captured: " << mImpl->mTotalFramesCaptured );
-				markUnderrun();
-			}
+		bool readSuccess = mImpl->mDriftCorrection ? driftCompensator.process( &mImpl->mRingBuffer, buffer, framesToRead ) : mImpl->mRingBuffer.read( buffer, framesToRead );
+		if( ! readSuccess ) {
+			mImpl->recordEvent( ContextPortAudio::DiagnosticEvent::Type::INPUT_UNDERRUN, framesToRead, mImpl->mNumFramesBuffered );
+			markUnderrun();
+			return;
 		}
 
-		mImpl->mNumFramesBuffered -= framesNeeded;
+		mImpl->mNumFramesBuffered -= framesToRead;
 	}
 }
 
+// ----------------------------------------------------------------------------------------------------
+// ContextPortAudio::Impl
+// ----------------------------------------------------------------------------------------------------
+
+struct ContextPortAudio::Impl {
+	const size_t	DIAGNOSTIC_QUEUE_SIZE = 1024;
+	const double	DIAGNOSTIC_DRAIN_INTERVAL_SECONDS = 0.1;
+
+	Impl( ContextPortAudio *parent )
+		: mParent( parent ), mDiagnosticEvents( DIAGNOSTIC_QUEUE_SIZE )
+	{}
+
+	~Impl()
+	{
+		stopDrainThread();
+	}
+
+	function<void( const DiagnosticEvent &event )> getListener()
+	{
+		lock_guard<mutex> lock( mListenerMutex );
+		return mListener;
+	}
+
+	// Moves the events in the realtime queue to mPendingEvents, counting and logging them, then passes them to the listener.
+	// mPendingEvents keeps only the most recent DIAGNOSTIC_QUEUE_SIZE events, older ones have already been counted and logged.
+	void collectDiagnosticEvents()
+	{
+		vector<DiagnosticEvent> collected;
+
+		{
+			lock_guard<mutex> lock( mCountersMutex );
+
+			DiagnosticEvent event;
+			while( mDiagnosticEvents.pop( &event ) ) {
+				mCounters.mCounts[(size_t)event.mType]++;
+				if( mDiagnosticLoggingEnabled )
+					CI_LOG_W( "[" << event.mFrame << "] " << getDiagnosticEventTypeName( event.mType ) << ", count: " << event.mCount << ", available: " << event.mAvailable );
+
+				mPendingEvents.push_back( event );
+				if( mPendingEvents.size() > DIAGNOSTIC_QUEUE_SIZE )
+					mPendingEvents.pop_front();
+
+				collected.push_back( event );
+			}
+
+			uint64_t numDropped = mNumDiagnosticEventsDropped.exchange( 0 );
+			if( numDropped ) {
+				mCounters.mNumDropped += numDropped;
+				if( mDiagnosticLoggingEnabled )
+					CI_LOG_W( "diagnostic queue full, " << numDropped << " events dropped" );
+			}
+		}
+
+		// called without holding mCountersMutex, so that the listener can query the counters
+		auto listener = getListener();
+		if( listener ) {
+			for( const auto &collectedEvent : collected )
+				listener( collectedEvent );
+		}
+	}
+
+	// the drain thread runs unless it is disabled without a listener, in which case events are only collected by drainDiagnosticEvents()
+	void updateDrainThread()
+	{
+		if( mDrainThreadEnabled || getListener() )
+			startDrainThread();
+		else
+			stopDrainThread();
+	}
+
+	void startDrainThread()
+	{
+		if( mDrainThread.joinable() )
+			return;
+
+		mDrainThreadShouldQuit = false;
+		mDrainThread = thread( [this] {
+			unique_lock<mutex> lock( mDrainThreadMutex );
+			while( ! mDrainThreadShouldQuit ) {
+				mDrainThreadCondition.wait_for( lock, chrono::duration<double>( DIAGNOSTIC_DRAIN_INTERVAL_SECONDS ) );
+				collectDiagnosticEvents();
+				if( auto profiler = mActiveNodeProfiler.load( memory_order_acquire ) )
+					profiler->releaseDestroyedNodes();
+			}
+		} );
+	}
+
+	void stopDrainThread()
+	{
+		if( ! mDrainThread.joinable() )
+			return;
+
+		{
+			lock_guard<mutex> lock( mDrainThreadMutex );
+			mDrainThreadShouldQuit = true;
+		}
+		mDrainThreadCondition.notify_one();
+		mDrainThread.join();
+	}
+
+	ContextPortAudio*					mParent;
+	EventQueue<DiagnosticEvent>			mDiagnosticEvents;
+	atomic<uint64_t>					mNumDiagnosticEventsDropped = { 0 };
+
+	mutable mutex						mCountersMutex; // also serializes consumers of mDiagnosticEvents and guards mPendingEvents
+	DiagnosticCounters					mCounters;
+	deque<DiagnosticEvent>				mPendingEvents; // collected but not yet returned by drainDiagnosticEvents()
+	atomic<bool>						mDiagnosticLoggingEnabled = { true };
+
+	unique_ptr<NodeProfilerPortAudio>	mNodeProfiler; // kept until the Context is destroyed, since the audio thread may still be using it after profiling is disabled
+	atomic<NodeProfilerPortAudio *>		mActiveNodeProfiler = { nullptr };
+
+	mutex								mListenerMutex;
+	function<void( const DiagnosticEvent &event )>	mListener;
+
+	thread								mDrainThread;
+	mutex								mDrainThreadMutex;
+	condition_variable					mDrainThreadCondition;
+	bool								mDrainThreadShouldQuit = false;
+	bool								mDrainThreadEnabled = true;
+};
+
 // ----------------------------------------------------------------------------------------------------
 // ContextPortAudio
 // ----------------------------------------------------------------------------------------------------
@@ -470,9 +2061,13 @@ void ContextPortAudio::setAsMaster()
 }
 
 ContextPortAudio::ContextPortAudio()
+	: mImpl( new Impl( this ) )
 {
-	PaError err = Pa_Initialize();
-	CI_ASSERT( err == paNoError );
+	// PortAudio is initialized lazily, the first time that devices are queried or device nodes are created
+	RuntimePortAudio::retain();
+	PaTrace_SetEventName( TRACE_EVENT_GRAPH_PULL, "graph pull" );
+	PaTrace_SetEventName( TRACE_EVENT_CAPTURE_READ, "capture read" );
+	mImpl->updateDrainThread();
 }
 
 ContextPortAudio::~ContextPortAudio()
@@ -486,12 +2081,16 @@ ContextPortAudio::~ContextPortAudio()
 		}
 	}
 
-	PaError err = Pa_Terminate();
-	CI_ASSERT( err == paNoError );
+	mImpl->stopDrainThread();
+	mImpl->collectDiagnosticEvents();
+
+	RuntimePortAudio::release();
 }
 
 OutputDeviceNodeRef	ContextPortAudio::createOutputDeviceNode( const DeviceRef &device, const Node::Format &format )
 {
+	RuntimePortAudio::ensureInitialized();
+
 	auto result = makeNode( new OutputDeviceNodePortAudio( device, format ) );
 	mDeviceNodes.push_back( result );
 	LOG_CI_PORTAUDIO( "created OutputDeviceNodePortAudio for device named '" << device->getName() << "'" );
@@ -500,12 +2099,145 @@ OutputDeviceNodeRef	ContextPortAudio::createOutputDeviceNode( const DeviceRef &d
 
 InputDeviceNodeRef ContextPortAudio::createInputDeviceNode( const DeviceRef &device, const Node::Format &format )
 {
+	RuntimePortAudio::ensureInitialized();
+
 	auto result = makeNode( new InputDeviceNodePortAudio( device, format ) );
 	mDeviceNodes.push_back( result );
 	LOG_CI_PORTAUDIO( "created InputDeviceNodePortAudio for device named '" << device->getName() << "'" );
 	return result;
 }
 
+// static
+const char* ContextPortAudio::getDiagnosticEventTypeName( DiagnosticEvent::Type type )
+{
+	switch( type ) {
+		case DiagnosticEvent::Type::INPUT_OVERRUN:		return "input overrun";
+		case DiagnosticEvent::Type::INPUT_UNDERRUN:		return "input underrun";
+		case DiagnosticEvent::Type::RENDER_SKIPPED:		return "render skipped";
+		case DiagnosticEvent::Type::DEADLINE_MISS:		return "deadline miss";
+		default: break;
+	}
+
+	return "unknown";
+}
+
+void ContextPortAudio::recordDiagnosticEvent( DiagnosticEvent::Type type, const Node *node, uint64_t frame, uint64_t count, uint64_t available )
+{
+	DiagnosticEvent event;
+	event.mType = type;
+	event.mFrame = frame;
+	event.mCount = count;
+	event.mAvailable = available;
+	event.mTimestampNanos = (uint64_t)chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now().time_since_epoch() ).count();
+	event.mNode = node;
+
+	if( ! mImpl->mDiagnosticEvents.push( event ) )
+		mImpl->mNumDiagnosticEventsDropped++;
+}
+
+std::vector<ContextPortAudio::DiagnosticEvent> ContextPortAudio::drainDiagnosticEvents()
+{
+	mImpl->collectDiagnosticEvents();
+
+	lock_guard<mutex> lock( mImpl->mCountersMutex );
+
+	vector<DiagnosticEvent> result( mImpl->mPendingEvents.begin(), mImpl->mPendingEvents.end() );
+	mImpl->mPendingEvents.clear();
+	return result;
+}
+
+ContextPortAudio::DiagnosticCounters ContextPortAudio::getDiagnosticCounters() const
+{
+	lock_guard<mutex> lock( mImpl->mCountersMutex );
+	return mImpl->mCounters;
+}
+
+void ContextPortAudio::enableDiagnosticLogging( bool enable )
+{
+	mImpl->mDiagnosticLoggingEnabled = enable;
+}
+
+bool ContextPortAudio::isDiagnosticLoggingEnabled() const
+{
+	return mImpl->mDiagnosticLoggingEnabled;
+}
+
+void ContextPortAudio::setDiagnosticEventListener( const std::function<void( const DiagnosticEvent &event )> &listener )
+{
+	{
+		lock_guard<mutex> lock( mImpl->mListenerMutex );
+		mImpl->mListener = listener;
+	}
+
+	mImpl->updateDrainThread();
+}
+
+void ContextPortAudio::enableDiagnosticDrainThread( bool enable )
+{
+	mImpl->mDrainThreadEnabled = enable;
+	mImpl->updateDrainThread();
+}
+
+bool ContextPortAudio::isDiagnosticDrainThreadEnabled() const
+{
+	return mImpl->mDrainThread.joinable();
+}
+
+std::vector<StreamTelemetryPortAudio> ContextPortAudio::getStreamTelemetry() const
+{
+	vector<StreamTelemetryPortAudio> result;
+	for( const auto &weakNode : mDeviceNodes ) {
+		auto node = weakNode.lock();
+		if( ! node || ! node->isInitialized() )
+			continue;
+
+		StreamTelemetryPortAudio telemetry;
+		if( auto outputDeviceNode = dynamic_pointer_cast<OutputDeviceNodePortAudio>( node ) )
+			telemetry = outputDeviceNode->getStreamTelemetry();
+		else if( auto inputDeviceNode = dynamic_pointer_cast<InputDeviceNodePortAudio>( node ) )
+			telemetry = inputDeviceNode->getStreamTelemetry();
+
+		if( telemetry.mIsOpen )
+			result.push_back( telemetry );
+	}
+
+	return result;
+}
+
+void ContextPortAudio::enableNodeProfiling( bool enable )
+{
+	if( enable && ! mImpl->mNodeProfiler )
+		mImpl->mNodeProfiler.reset( new NodeProfilerPortAudio( this ) );
+
+	mImpl->mActiveNodeProfiler.store( enable ? mImpl->mNodeProfiler.get() : nullptr, memory_order_release );
+}
+
+bool ContextPortAudio::isNodeProfilingEnabled() const
+{
+	return mImpl->mActiveNodeProfiler.load() != nullptr;
+}
+
+NodeProfilerPortAudio* ContextPortAudio::getNodeProfiler() const
+{
+	return mImpl->mNodeProfiler.get();
+}
+
+NodeProfilerPortAudio* ContextPortAudio::getActiveNodeProfiler() const
+{
+	return mImpl->mActiveNodeProfiler.load( memory_order_acquire );
+}
+
+void ContextPortAudio::resetStreamTelemetry()
+{
+	for( const auto &weakNode : mDeviceNodes ) {
+		auto node = weakNode.lock();
+		if( auto outputDeviceNode = dynamic_pointer_cast<OutputDeviceNodePortAudio>( node ) )
+			outputDeviceNode->resetStreamTelemetry();
+		else if( auto inputDeviceNode = dynamic_pointer_cast<InputDeviceNodePortAudio>( node ) )
+			inputDeviceNode->resetStreamTelemetry();
+	}
+}
+
 // ----------------------------------------------------------------------------------------------------
 // MARK: - ContextPortAudioExc
 // ----------------------------------------------------------------------------------------------------
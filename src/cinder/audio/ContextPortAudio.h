@@ -26,16 +26,160 @@
 #include "cinder/Cinder.h"
 
 #include "cinder/audio/Context.h"
+#include "cinder/audio/NodeProfilerPortAudio.h"
+#include "cinder/audio/SampleFormatPortAudio.h"
+#include "cinder/audio/Target.h"
+
+#include <functional>
 
 namespace cinder { namespace audio {
 
 class InputDeviceNodePortAudio;
 
+//! Snapshot of a PortAudio stream's health, gathered from lock-free counters that are updated on the stream's callback thread.
+struct StreamTelemetryPortAudio {
+	const Node*	mNode = nullptr;			//!< the device node that owns the stream
+	std::string	mDeviceName;
+	bool		mIsOpen = false;			//!< false if the node has no stream of its own, ex. an InputDeviceNodePortAudio using full duplex I/O
+	bool		mIsInput = false;
+	bool		mIsFullDuplex = false;
+	double		mSampleRate = 0;
+
+	uint64_t	mNumCallbacks = 0;			//!< stream callbacks since the stream was opened or the telemetry was reset. Always 0 for polled input streams.
+	uint64_t	mNumInputUnderflows = 0;	//!< callbacks with paInputUnderflow set
+	uint64_t	mNumInputOverflows = 0;		//!< callbacks with paInputOverflow set
+	uint64_t	mNumOutputUnderflows = 0;	//!< callbacks with paOutputUnderflow set
+	uint64_t	mNumOutputOverflows = 0;	//!< callbacks with paOutputOverflow set
+	uint64_t	mNumPrimingOutputs = 0;		//!< callbacks with paPrimingOutput set
+
+	double		mCpuLoad = 0;				//!< Pa_GetStreamCpuLoad(), 0 for polled streams
+	double		mCpuLoadPeak = 0;			//!< highest single buffer load since start or reset, from Pa_GetStreamCpuLoadStats()
+	uint64_t	mNumCpuOverloads = 0;		//!< host buffers that took longer to process than their duration
+	double		mInputLatency = 0;			//!< from Pa_GetStreamInfo(), in seconds
+	double		mOutputLatency = 0;			//!< from Pa_GetStreamInfo(), in seconds
+
+	bool		mHasFillLevel = false;		//!< true for input streams with a capture ring buffer
+	size_t		mFillLevelMin = 0, mFillLevelMax = 0, mFillLevelCapacity = 0;
+	double		mFillLevelAverage = 0;
+
+	// Callback durations in seconds. Percentiles are the upper bound of the histogram bucket that contains them (buckets are a quarter octave wide).
+	double		mCallbackDurationAverage = 0;
+	double		mCallbackDurationP50 = 0;
+	double		mCallbackDurationP95 = 0;
+	double		mCallbackDurationP99 = 0;
+	double		mCallbackDurationMax = 0;
+};
+
+//! Captured by OutputDeviceNodePortAudio's deadline watchdog when a stream callback runs over its budget, see OutputDeviceNodePortAudio::enableDeadlineWatchdog().
+struct DeadlineSnapshotPortAudio {
+	//! Time that a node spent in process() during the callback.
+	struct NodeTiming {
+		const Node*	mNode;
+		double		mSeconds;
+	};
+
+	//! Frames held in an InputDeviceNodePortAudio's ring buffer when it was processed during the callback.
+	struct RingLevel {
+		const Node*	mNode;
+		size_t		mFramesBuffered;
+		size_t		mCapacity;
+	};
+
+	uint64_t		mMissIndex = 0;				//!< 1-based count of the miss since the watchdog was enabled or cleared
+	uint64_t		mFrame = 0;					//!< Context::getNumProcessedFrames() at the start of the callback
+	uint64_t		mTimestampNanos = 0;		//!< std::chrono::steady_clock time at the start of the callback
+	size_t			mFramesPerBuffer = 0;
+	double			mBudget = 0;				//!< framesPerBuffer / sampleRate, in seconds
+	double			mThreshold = 0;				//!< mBudget times the deadline fraction, in seconds
+	double			mDuration = 0;				//!< time spent in the callback, in seconds
+	unsigned long	mStatusFlags = 0;			//!< PaStreamCallbackFlags passed to the callback
+
+	// From the callback's PaStreamCallbackTimeInfo, in seconds on the stream's clock (see Pa_GetStreamTime())
+	double			mInputBufferAdcTime = 0;
+	double			mCurrentTime = 0;
+	double			mOutputBufferDacTime = 0;
+
+	std::vector<NodeTiming>	mNodeTimings;		//!< nodes that ran during the callback, sorted most expensive first. Only captured while node profiling is enabled, see ContextPortAudio::enableNodeProfiling().
+	std::vector<RingLevel>	mRingLevels;
+};
+
 class OutputDeviceNodePortAudio : public OutputDeviceNode {
   public:
 	OutputDeviceNodePortAudio( const DeviceRef &device, const Format &format );
 	~OutputDeviceNodePortAudio();
 
+	//! Sets whether the render callback should skip a block (outputting silence) rather than wait when the Context's mutex is held by another thread, ex. while the graph is being edited. Disabled by default.
+	void		enableNonBlockingRender( bool enable = true );
+	//! Returns whether the render callback skips blocks instead of waiting on the Context's mutex.
+	bool		isNonBlockingRenderEnabled() const;
+	//! Returns the number of render callbacks that found the Context's mutex already locked.
+	uint64_t	getNumRenderContentions() const;
+	//! Returns the number of blocks that were skipped (filled with silence) because the Context's mutex was locked.
+	uint64_t	getNumSkippedBlocks() const;
+
+	//! Sets whether the stream should be opened with non-interleaved (per-channel) buffers, which avoids interleaving each block. Enabled by default, falls back to interleaved if the host API doesn't support it. Takes effect the next time the node is initialized.
+	void	enableNonInterleavedStream( bool enable = true );
+	//! Returns whether non-interleaved streams have been requested.
+	bool	isNonInterleavedStreamEnabled() const;
+	//! Returns whether the currently open stream is non-interleaved.
+	bool	isStreamNonInterleaved() const;
+
+	//! Sets whether the host may call back with any number of frames (paFramesPerBufferUnspecified), allowing the lowest latency the host API can offer. The graph is still rendered in fixed blocks, with remaining frames carried over between callbacks. Disabled by default and not used with full duplex I/O. Takes effect the next time the node is initialized.
+	void	enableVariableHostBufferSize( bool enable = true );
+	//! Returns whether variable host buffer sizes are enabled.
+	bool	isVariableHostBufferSizeEnabled() const;
+
+	//! Sets whether PortAudio uses noise shaped dither instead of plain triangular dither when it converts the stream's float samples for a 16 bit device, which moves the dither noise towards high frequencies where it is less audible. Has no effect with integer sample formats, which the node converts itself. Disabled by default. Takes effect the next time the node is initialized.
+	void	enableNoiseShapedDither( bool enable = true );
+	//! Returns whether noise shaped dither is enabled.
+	bool	isNoiseShapedDitherEnabled() const;
+
+	//! Sets the sample format that the stream should be opened with. Integer formats are converted while interleaving, which can avoid a conversion pass in the host API for devices that are natively integer. Default is SampleFormatPortAudio::FLOAT_32. Takes effect the next time the node is initialized.
+	void					setSampleFormat( SampleFormatPortAudio format );
+	//! Returns the requested sample format.
+	SampleFormatPortAudio	getSampleFormat() const;
+	//! Returns the sample format of the currently open stream, which is FLOAT_32 if the requested format wasn't supported by the host API.
+	SampleFormatPortAudio	getStreamSampleFormat() const;
+
+	//! Returns a snapshot of the output (or full duplex) stream's health. Safe to call from any thread while the node is initialized.
+	StreamTelemetryPortAudio	getStreamTelemetry() const;
+	//! Resets the stream's callback counters and duration histogram.
+	void						resetStreamTelemetry();
+
+	//! Sets whether each stream callback is timed against its budget (framesPerBuffer / sampleRate). A callback that uses more than the deadline fraction of its budget records a DiagnosticEvent::Type::DEADLINE_MISS and captures a DeadlineSnapshotPortAudio into a preallocated slot, without allocating on the audio thread. Disabled by default.
+	void		enableDeadlineWatchdog( bool enable = true );
+	//! Returns whether the deadline watchdog is enabled.
+	bool		isDeadlineWatchdogEnabled() const;
+	//! Sets the fraction of a callback's budget that it may use before it counts as a deadline miss, in the range (0, 1]. Values outside of it are clamped, with a minimum of 0.01. Default is 0.8.
+	void		setDeadlineFraction( double fraction );
+	//! Returns the fraction of a callback's budget that it may use before it counts as a deadline miss.
+	double		getDeadlineFraction() const;
+	//! Returns the number of deadline misses since the watchdog was enabled or cleared.
+	uint64_t	getNumDeadlineMisses() const;
+	//! Returns the snapshots of the most recent deadline misses (up to 16), oldest first. Call from a non-realtime thread.
+	std::vector<DeadlineSnapshotPortAudio>	getDeadlineSnapshots() const;
+	//! Removes all deadline snapshots and resets the miss count.
+	void		clearDeadlineSnapshots();
+
+	//! Returns true if this node's device is the virtual output (see DeviceManagePortAudio::getVirtualOutput()), which is rendered on its own thread instead of by a PortAudio stream.
+	bool		isVirtual() const;
+	//! Sets a callback that receives each block rendered for the virtual output, on the virtual output's render thread. Takes effect the next time processing is enabled.
+	void		setVirtualSink( const std::function<void( const Buffer &buffer )> &sink );
+	//! Sets a file that the virtual output is written to, with a format determined by the file's extension. An empty path disables writing. Takes effect the next time the node is initialized.
+	void		setVirtualOutputFile( const fs::path &filePath, SampleType sampleType = SampleType::INT_16 );
+	//! Sets the speed of the virtual output's clock relative to real time, ex. 1 paces rendering to real time and 2 renders at double speed. 0 renders as fast as possible. Default is 1.
+	void		setVirtualClockRate( double rate );
+	//! Returns the speed of the virtual output's clock relative to real time, or 0 if it renders as fast as possible.
+	double		getVirtualClockRate() const;
+	//! Sets the number of frames that the virtual output renders before it stops, rounded up to a whole block. 0 (the default) renders until processing is disabled.
+	void		setVirtualFrameLimit( uint64_t numFrames );
+	//! Returns the number of frames that the virtual output renders before it stops, or 0 if there is no limit.
+	uint64_t	getVirtualFrameLimit() const;
+	//! Returns the number of frames rendered by the virtual output since the node was initialized.
+	uint64_t	getNumVirtualFramesRendered() const;
+	//! Returns true once the virtual output has rendered its frame limit.
+	bool		isVirtualRenderComplete() const;
+
   protected:
 	void initialize()				override;
 	void uninitialize()				override;
@@ -44,7 +188,8 @@ class OutputDeviceNodePortAudio : public OutputDeviceNode {
 	bool supportsProcessInPlace() const	override	{ return false; }
 
   private:
-	  void renderAudio( const float *inputBuffer, float *outputBuffer, size_t framesPerBuffer );
+	  void renderAudio( const void *inputBuffer, void *outputBuffer, size_t framesPerBuffer );
+	  void renderBlock( Context *ctx, const void *inputBuffer );
 
 	  struct Impl;
 	  std::unique_ptr<Impl>		mImpl;
@@ -62,6 +207,55 @@ public:
 	void enableProcessing()		override;
 	void disableProcessing()	override;
 
+	//! Sets whether the stream should be opened with non-interleaved (per-channel) buffers, which avoids de-interleaving each block. Enabled by default, falls back to interleaved if the host API doesn't support it. Takes effect the next time the node is initialized.
+	void	enableNonInterleavedStream( bool enable = true );
+	//! Returns whether non-interleaved streams have been requested.
+	bool	isNonInterleavedStreamEnabled() const;
+	//! Returns whether the currently open stream (or the full duplex stream, owned by OutputDeviceNodePortAudio) is non-interleaved.
+	bool	isStreamNonInterleaved() const;
+
+	//! Sets whether the input stream should capture from its own PortAudio callback into the ring buffer, so that process() doesn't need to poll the stream. Disabled by default. Takes effect the next time the node is initialized.
+	void	enableCallbackCapture( bool enable = true );
+	//! Returns whether callback capture is enabled.
+	bool	isCallbackCaptureEnabled() const;
+
+	//! Sets the sample format that the stream should be opened with. Integer formats are converted while de-interleaving, which can avoid a conversion pass in the host API for devices that are natively integer. Default is SampleFormatPortAudio::FLOAT_32. Takes effect the next time the node is initialized.
+	void					setSampleFormat( SampleFormatPortAudio format );
+	//! Returns the requested sample format.
+	SampleFormatPortAudio	getSampleFormat() const;
+	//! Returns the sample format of the currently open stream (or the input side of the full duplex stream), which is FLOAT_32 if the requested format wasn't supported by the host API.
+	SampleFormatPortAudio	getStreamSampleFormat() const;
+
+	//! Returns a snapshot of the input stream's health, including the capture ring buffer's fill level. With full duplex I/O the stream is owned by OutputDeviceNodePortAudio and mIsOpen is false.
+	StreamTelemetryPortAudio	getStreamTelemetry() const;
+	//! Resets the stream's callback counters, duration histogram and fill level statistics.
+	void						resetStreamTelemetry();
+
+	//! Statistics of the number of frames waiting in the capture ring buffer, sampled each time the node is processed. Not used with full duplex I/O.
+	struct FillLevel {
+		size_t	mCurrent = 0;
+		size_t	mMin = 0;
+		size_t	mMax = 0;
+		double	mAverage = 0;
+		size_t	mCapacity = 0;
+	};
+
+	//! Returns the capture ring buffer's fill level statistics since the node was initialized or resetFillLevel() was called.
+	FillLevel	getFillLevel() const;
+	//! Resets the min, max and average fill level statistics.
+	void		resetFillLevel();
+
+	//! Sets whether captured audio should be resampled by a small, varying ratio to compensate for clock drift between this input device and the output device, using an adaptive jitter buffer to hold latency steady. Disabled by default and not used with full duplex I/O. Takes effect the next time the node is initialized.
+	void	enableDriftCorrection( bool enable = true );
+	//! Returns whether drift correction is enabled.
+	bool	isDriftCorrectionEnabled() const;
+	//! Returns the estimated clock drift between the input and output devices in parts per million, positive when the input device runs fast. Only updated while drift correction is enabled.
+	double	getEstimatedDriftPpm() const;
+	//! Returns the smoothed number of frames held in the jitter buffer. Only updated while drift correction is enabled.
+	double	getJitterBufferDepth() const;
+	//! Returns the number of frames that the jitter buffer is targeting, which adapts to the observed capture jitter. Only updated while drift correction is enabled.
+	double	getJitterBufferTarget() const;
+
 protected:
 	void initialize()				override;
 	void uninitialize()				override;
@@ -71,7 +265,9 @@ private:
 	struct Impl;
 	std::unique_ptr<Impl>		mImpl;
 	bool						mFullDuplexIO;
-	const float*				mFullDuplexInputBuffer;
+	bool						mFullDuplexNonInterleaved;
+	SampleFormatPortAudio		mFullDuplexSampleFormat;
+	const void*					mFullDuplexInputBuffer;
 
 	friend class OutputDeviceNodePortAudio;
 };
@@ -85,11 +281,74 @@ class ContextPortAudio : public Context {
 	OutputDeviceNodeRef	createOutputDeviceNode( const DeviceRef &device, const Node::Format &format = Node::Format() )	override;
 	InputDeviceNodeRef	createInputDeviceNode( const DeviceRef &device, const Node::Format &format = Node::Format() )	override;
 
+	//! A structured event recorded by the PortAudio device nodes on the audio thread, without allocating or locking.
+	struct DiagnosticEvent {
+		enum class Type : uint8_t {
+			INPUT_OVERRUN,		//!< captured frames didn't fit in the input ring buffer. mCount is the frames (or blocks, with callback capture) dropped, mAvailable the frames that could be written.
+			INPUT_UNDERRUN,		//!< not enough captured frames for a block. mCount is the frames needed, mAvailable the frames buffered.
+			RENDER_SKIPPED,		//!< a block was skipped because the Context's mutex was locked. mCount is the frames of silence output.
+			DEADLINE_MISS,		//!< an output stream callback ran over its deadline. mCount is the callback's duration and mAvailable the deadline, both in microseconds.
+			NUM_TYPES
+		};
+
+		Type		mType;
+		uint64_t	mFrame;				//!< Context::getNumProcessedFrames() when the event was recorded
+		uint64_t	mCount;				//!< event specific, see Type
+		uint64_t	mAvailable;			//!< event specific, see Type
+		uint64_t	mTimestampNanos;	//!< std::chrono::steady_clock time that the event was recorded
+		const Node*	mNode;				//!< the node that recorded the event. Only for identification, it may have since been destroyed.
+	};
+
+	//! Totals of the diagnostic events taken from the realtime queue.
+	struct DiagnosticCounters {
+		uint64_t	mCounts[(size_t)DiagnosticEvent::Type::NUM_TYPES] = {};
+		uint64_t	mNumDropped = 0;	//!< events that were lost because the queue was full
+
+		uint64_t	getCount( DiagnosticEvent::Type type ) const	{ return mCounts[(size_t)type]; }
+	};
+
+	//! Returns a printable name for \a type.
+	static const char*	getDiagnosticEventTypeName( DiagnosticEvent::Type type );
+
+	//! Returns the diagnostic events recorded since the last call, up to the 1024 most recent. Events still in the realtime queue are first counted, logged and passed to the listener, as the drain thread does. Call from a non-realtime thread.
+	std::vector<DiagnosticEvent>	drainDiagnosticEvents();
+	//! Returns the totals of all diagnostic events taken from the realtime queue so far.
+	DiagnosticCounters				getDiagnosticCounters() const;
+	//! Sets whether diagnostic events are written to the log as warnings when they are taken from the realtime queue. Enabled by default.
+	void	enableDiagnosticLogging( bool enable = true );
+	//! Returns whether diagnostic events are written to the log.
+	bool	isDiagnosticLoggingEnabled() const;
+	//! Sets a listener that is called with each diagnostic event as it is taken from the realtime queue, from the drain thread or the thread calling drainDiagnosticEvents(). Setting a listener starts the drain thread if it was disabled. Pass an empty function to remove the listener.
+	void	setDiagnosticEventListener( const std::function<void( const DiagnosticEvent &event )> &listener );
+	//! Sets whether a background thread takes events from the realtime diagnostic queue every 100 ms, counting and logging them and passing them to the listener, so that the queue doesn't fill up. Taken events are still returned by drainDiagnosticEvents(). Enabled by default. While disabled, and without a listener, events are only taken when drainDiagnosticEvents() is called, and any that don't fit in the queue (1024 events) are dropped and counted in DiagnosticCounters::mNumDropped.
+	void	enableDiagnosticDrainThread( bool enable = true );
+	//! Returns whether the diagnostic drain thread is running, because it was enabled or a listener is set.
+	bool	isDiagnosticDrainThreadEnabled() const;
+
+	//! Returns a telemetry snapshot for each open PortAudio stream owned by this Context's device nodes. Call from a non-realtime thread.
+	std::vector<StreamTelemetryPortAudio>	getStreamTelemetry() const;
+	//! Resets the telemetry counters of all device nodes.
+	void									resetStreamTelemetry();
+
+	//! Sets whether the time spent processing each node pulled by an OutputDeviceNodePortAudio is profiled (see NodeProfilerPortAudio). Disabled by default. Statistics are kept while disabled, until NodeProfilerPortAudio::reset() is called.
+	void					enableNodeProfiling( bool enable = true );
+	//! Returns whether node profiling is enabled.
+	bool					isNodeProfilingEnabled() const;
+	//! Returns the node profiler, or nullptr if node profiling has never been enabled.
+	NodeProfilerPortAudio*	getNodeProfiler() const;
+
   private:
+	//! Records \a event without blocking, safe to call from the audio thread. If the queue is full the event is dropped and counted.
+	void recordDiagnosticEvent( DiagnosticEvent::Type type, const Node *node, uint64_t frame, uint64_t count, uint64_t available );
+	//! Returns the node profiler if profiling is enabled, otherwise nullptr. Safe to call from the audio thread.
+	NodeProfilerPortAudio* getActiveNodeProfiler() const;
 
+	struct Impl;
+	std::unique_ptr<Impl>				mImpl;
 	std::vector<std::weak_ptr<Node>>	mDeviceNodes;
 
 	friend class OutputDeviceNodePortAudio;
+	friend class InputDeviceNodePortAudio;
 };
 
 class ContextPortAudioExc : public AudioExc {
@@ -22,40 +22,101 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "cinder/audio/DeviceManagerPortAudio.h"
+#include "cinder/audio/RuntimePortAudio.h"
 #include "cinder/Log.h"
 
+#define LOG_CI_PORTAUDIO( stream )	CI_LOG_I( stream )
+//#define LOG_CI_PORTAUDIO( stream )	    ( (void)( 0 ) )
+
 #include "portaudio.h"
 
 #include <math.h>
+#include <algorithm>
 
 using namespace std;
 
 namespace cinder { namespace audio {
 
+namespace {
+
+const char *VIRTUAL_OUTPUT_NAME = "Virtual Output";
+const size_t VIRTUAL_OUTPUT_MAX_CHANNELS = 32;
+const size_t VIRTUAL_OUTPUT_SAMPLE_RATE = 44100;
+const size_t VIRTUAL_OUTPUT_FRAMES_PER_BLOCK = 512;
+
+const SampleFormatPortAudio PROBED_SAMPLE_FORMATS[] = { SampleFormatPortAudio::FLOAT_32, SampleFormatPortAudio::INT_32, SampleFormatPortAudio::INT_24, SampleFormatPortAudio::INT_16 };
+
+// Returns 1, 2 and the maximum channel count, limited to maxChannels
+vector<size_t> getProbedChannelCounts( size_t maxChannels )
+{
+	vector<size_t> result;
+	for( size_t numChannels : { size_t( 1 ), size_t( 2 ), maxChannels } ) {
+		if( numChannels > 0 && numChannels <= maxChannels && find( result.begin(), result.end(), numChannels ) == result.end() )
+			result.push_back( numChannels );
+	}
+
+	return result;
+}
+
+// Returns true if err from Pa_IsFormatSupported() means that the configuration isn't supported. Other errors, ex. a busy or unplugged device, say nothing about the configuration.
+bool isUnsupportedFormatError( PaError err )
+{
+	return err == paInvalidSampleRate || err == paInvalidChannelCount || err == paSampleFormatNotSupported;
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------------------------------
+// DeviceManagePortAudio::Capabilities
+// ----------------------------------------------------------------------------------------------------
+
+bool DeviceManagePortAudio::Capabilities::isSupported( size_t sampleRate, size_t numChannels, SampleFormatPortAudio format, bool isInput ) const
+{
+	const Entry *entry = findEntry( sampleRate, numChannels, isInput );
+	return entry && ( entry->mFormatMask & ( 1 << (int)format ) ) != 0;
+}
+
+bool DeviceManagePortAudio::Capabilities::isSampleRateSupported( size_t sampleRate ) const
+{
+	return find( mSampleRates.begin(), mSampleRates.end(), sampleRate ) != mSampleRates.end();
+}
+
+const DeviceManagePortAudio::Capabilities::Entry* DeviceManagePortAudio::Capabilities::findEntry( size_t sampleRate, size_t numChannels, bool isInput ) const
+{
+	// entries for each sample rate are stored in increasing channel count
+	for( const auto &entry : mEntries ) {
+		if( entry.mSampleRate == sampleRate && entry.mIsInput == isInput && entry.mNumChannels >= numChannels )
+			return &entry;
+	}
+
+	return nullptr;
+}
+
 // ----------------------------------------------------------------------------------------------------
 // DeviceManagePortAudio - virtual
 // ----------------------------------------------------------------------------------------------------
 
 DeviceManagePortAudio::DeviceManagePortAudio()
 {
-	PaError err = Pa_Initialize();
-	CI_ASSERT( err == paNoError );
+	// PortAudio is initialized lazily, the first time that devices are queried
+	RuntimePortAudio::retain();
 }
 
 DeviceManagePortAudio::~DeviceManagePortAudio()
 {
-	PaError err = Pa_Terminate();
-	CI_ASSERT( err == paNoError );
+	RuntimePortAudio::release();
 }
 
 DeviceRef DeviceManagePortAudio::getDefaultOutput()
 {
+	RuntimePortAudio::ensureInitialized();
 	PaDeviceIndex devIndex = Pa_GetDefaultOutputDevice();
 	return findDeviceByPaIndex( devIndex );
 }
 
 DeviceRef DeviceManagePortAudio::getDefaultInput()
 {
+	RuntimePortAudio::ensureInitialized();
 	PaDeviceIndex devIndex = Pa_GetDefaultInputDevice();
 	return findDeviceByPaIndex( devIndex );
 }
@@ -68,6 +129,30 @@ const std::vector<DeviceRef>& DeviceManagePortAudio::getDevices()
 	return mDevices;
 }
 
+DeviceRef DeviceManagePortAudio::findDeviceByName( const std::string &name, bool supportsInput, bool supportsOutput )
+{
+	if( mDeviceInfos.empty() )
+		rebuildDevices();
+
+	auto range = mDeviceIndicesByName.equal_range( name );
+	for( auto it = range.first; it != range.second; ++it ) {
+		const auto &devInfo = mDeviceInfos[it->second];
+		if( ( ! supportsInput || devInfo.mNumInputChannels > 0 ) && ( ! supportsOutput || devInfo.mNumOutputChannels > 0 ) )
+			return devInfo.mDevice;
+	}
+
+	return {};
+}
+
+DeviceRef DeviceManagePortAudio::findDeviceByKey( const std::string &key )
+{
+	if( mDeviceInfos.empty() )
+		rebuildDevices();
+
+	auto it = mDeviceIndicesByKey.find( key );
+	return it != mDeviceIndicesByKey.end() ? mDeviceInfos[it->second].mDevice : DeviceRef();
+}
+
 std::string DeviceManagePortAudio::getName( const DeviceRef &device )
 {
 	return getDeviceInfo( device ).mName;
@@ -95,13 +180,27 @@ size_t DeviceManagePortAudio::getFramesPerBlock( const DeviceRef &device )
 
 void DeviceManagePortAudio::setSampleRate( const DeviceRef &device, size_t sampleRate )
 {
-	// TODO: use Pa_IsFormatSupported to check if valid first
-	getDeviceInfo( device ).mSampleRate = sampleRate;
+	auto &devInfo = getDeviceInfo( device );
+
+	// if PortAudio can't answer, the rate is left for opening the stream to check
+	if( ! ensureSampleRateProbed( devInfo, sampleRate ) )
+		LOG_CI_PORTAUDIO( "couldn't probe sample rate " << sampleRate << " for device named '" << devInfo.mName << "', setting it unchecked" );
+	else if( ! devInfo.mCapabilities.isSampleRateSupported( sampleRate ) )
+		throw AudioDeviceExc( "Sample rate " + to_string( sampleRate ) + " is not supported by device named '" + devInfo.mName + "'" );
+
+	devInfo.mSampleRate = sampleRate;
 }
 
 void DeviceManagePortAudio::setFramesPerBlock( const DeviceRef &device, size_t framesPerBlock )
 {
-	getDeviceInfo( device ).mFramesPerBlock = framesPerBlock;
+	auto &devInfo = getDeviceInfo( device );
+	if( framesPerBlock == 0 )
+		throw AudioDeviceExc( "Invalid frames per block (0) for device named '" + devInfo.mName + "'" );
+
+	// an explicit block size also becomes the latency that streams request
+	devInfo.mFramesPerBlock = framesPerBlock;
+	devInfo.mLatencyProfile = LatencyProfile::CUSTOM;
+	devInfo.mLatencySeconds = (double)framesPerBlock / (double)devInfo.mSampleRate;
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -114,39 +213,224 @@ int DeviceManagePortAudio::getPaDeviceIndex( const DeviceRef &device ) const
 	return devInfo.mPaDeviceIndex;
 }
 
-// ----------------------------------------------------------------------------------------------------
-// DeviceManagePortAudio Private
-// ----------------------------------------------------------------------------------------------------
-
 DeviceRef DeviceManagePortAudio::findDeviceByPaIndex( int index )
 {
-	if( mDeviceInfoSet.empty() )
+	if( mDeviceInfos.empty() )
+		rebuildDevices();
+
+	if( index < 0 || index >= (int)mDeviceInfos.size() || mDeviceInfos[index].mIsVirtual )
+		return {};
+
+	return mDeviceInfos[index].mDevice;
+}
+
+DeviceRef DeviceManagePortAudio::getVirtualOutput()
+{
+	if( mDeviceInfos.empty() )
 		rebuildDevices();
 
-	for( const auto &mp : mDeviceInfoSet ) {
-		if( mp.second.mPaDeviceIndex == index )
-			return mp.first;
+	// the virtual output is only listed once an app asks for it, so that it isn't mistaken for a sound card
+	if( ! mVirtualOutputEnabled ) {
+		mVirtualOutputEnabled = true;
+		addVirtualOutput();
 	}
 
-	CI_ASSERT_NOT_REACHABLE();
-	return {};
+	return mDeviceInfos.back().mDevice;
+}
+
+bool DeviceManagePortAudio::isVirtual( const DeviceRef &device ) const
+{
+	return getDeviceInfo( device ).mIsVirtual;
+}
+
+const DeviceManagePortAudio::Capabilities& DeviceManagePortAudio::getCapabilities( const DeviceRef &device )
+{
+	auto &devInfo = getDeviceInfo( device );
+	if( ! devInfo.mCapabilitiesProbed )
+		probeCapabilities( devInfo );
+
+	return devInfo.mCapabilities;
+}
+
+bool DeviceManagePortAudio::isSampleRateSupported( const DeviceRef &device, size_t sampleRate )
+{
+	auto &devInfo = getDeviceInfo( device );
+	return ensureSampleRateProbed( devInfo, sampleRate ) && devInfo.mCapabilities.isSampleRateSupported( sampleRate );
+}
+
+void DeviceManagePortAudio::setLatencyProfile( const DeviceRef &device, LatencyProfile profile )
+{
+	auto &devInfo = getDeviceInfo( device );
+	if( profile == LatencyProfile::CUSTOM && devInfo.mLatencySeconds <= 0 )
+		devInfo.mLatencySeconds = (double)devInfo.mFramesPerBlock / (double)devInfo.mSampleRate;
+
+	devInfo.mLatencyProfile = profile;
+	double latencySeconds = getProfileLatency( devInfo, devInfo.mNumOutputChannels == 0 );
+	size_t framesPerBlock = max<size_t>( 1, size_t( lround( latencySeconds * devInfo.mSampleRate ) ) );
+
+	// updateFormat() notifies the Device's listeners and calls back into setFramesPerBlock(), which marks the profile as custom, so restore it afterwards
+	double customLatencySeconds = devInfo.mLatencySeconds;
+	device->updateFormat( Device::Format().framesPerBlock( framesPerBlock ) );
+	devInfo.mLatencyProfile = profile;
+	devInfo.mLatencySeconds = customLatencySeconds;
+}
+
+DeviceManagePortAudio::LatencyProfile DeviceManagePortAudio::getLatencyProfile( const DeviceRef &device ) const
+{
+	return getDeviceInfo( device ).mLatencyProfile;
+}
+
+void DeviceManagePortAudio::setLatencySeconds( const DeviceRef &device, double seconds )
+{
+	CI_ASSERT( seconds > 0 );
+
+	getDeviceInfo( device ).mLatencySeconds = seconds;
+	setLatencyProfile( device, LatencyProfile::CUSTOM );
 }
 
+double DeviceManagePortAudio::getSuggestedInputLatency( const DeviceRef &device ) const
+{
+	return getProfileLatency( getDeviceInfo( device ), true );
+}
+
+double DeviceManagePortAudio::getSuggestedOutputLatency( const DeviceRef &device ) const
+{
+	return getProfileLatency( getDeviceInfo( device ), false );
+}
+
+double DeviceManagePortAudio::getGrantedInputLatency( const DeviceRef &device ) const
+{
+	return getDeviceInfo( device ).mGrantedInputLatency;
+}
+
+double DeviceManagePortAudio::getGrantedOutputLatency( const DeviceRef &device ) const
+{
+	return getDeviceInfo( device ).mGrantedOutputLatency;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// DeviceManagePortAudio Private
+// ----------------------------------------------------------------------------------------------------
+
 DeviceManagePortAudio::DeviceInfo& DeviceManagePortAudio::getDeviceInfo( const DeviceRef &device )
 {
-	return mDeviceInfoSet.at( device );
+	return mDeviceInfos.at( mDeviceIndices.at( device.get() ) );
 }
 
 const DeviceManagePortAudio::DeviceInfo& DeviceManagePortAudio::getDeviceInfo( const DeviceRef &device ) const
 {
-	return mDeviceInfoSet.at( device );
+	return mDeviceInfos.at( mDeviceIndices.at( device.get() ) );
+}
+
+double DeviceManagePortAudio::getProfileLatency( const DeviceInfo &devInfo, bool isInput ) const
+{
+	if( devInfo.mLatencyProfile == LatencyProfile::CUSTOM )
+		return devInfo.mLatencySeconds;
+
+	// the virtual output has no device latency, a block is all that it buffers
+	if( devInfo.mIsVirtual )
+		return (double)devInfo.mFramesPerBlock / (double)devInfo.mSampleRate;
+
+	auto devInfoPa = Pa_GetDeviceInfo( devInfo.mPaDeviceIndex );
+	if( devInfo.mLatencyProfile == LatencyProfile::LOW )
+		return isInput ? devInfoPa->defaultLowInputLatency : devInfoPa->defaultLowOutputLatency;
+	else
+		return isInput ? devInfoPa->defaultHighInputLatency : devInfoPa->defaultHighOutputLatency;
+}
+
+void DeviceManagePortAudio::setGrantedLatency( const DeviceRef &device, double inputLatency, double outputLatency )
+{
+	auto &devInfo = getDeviceInfo( device );
+	if( inputLatency > 0 )
+		devInfo.mGrantedInputLatency = inputLatency;
+	if( outputLatency > 0 )
+		devInfo.mGrantedOutputLatency = outputLatency;
+}
+
+void DeviceManagePortAudio::probeCapabilities( DeviceInfo &devInfo )
+{
+	devInfo.mCapabilities = {};
+	devInfo.mCapabilities.mInputChannelCounts = getProbedChannelCounts( devInfo.mNumInputChannels );
+	devInfo.mCapabilities.mOutputChannelCounts = getProbedChannelCounts( devInfo.mNumOutputChannels );
+	devInfo.mCapabilitiesProbed = true;
+
+	// other rates are probed when they are requested, as each costs a Pa_IsFormatSupported() per channel count, format and direction
+	auto defaultSampleRate = devInfo.mIsVirtual ? VIRTUAL_OUTPUT_SAMPLE_RATE : (size_t)Pa_GetDeviceInfo( devInfo.mPaDeviceIndex )->defaultSampleRate;
+	probeSampleRate( devInfo, defaultSampleRate );
+
+	LOG_CI_PORTAUDIO( "probed device '" << devInfo.mName << "' at its default sample rate " << defaultSampleRate << ", configurations: " << devInfo.mCapabilities.mEntries.size() );
+}
+
+bool DeviceManagePortAudio::ensureSampleRateProbed( DeviceInfo &devInfo, size_t sampleRate )
+{
+	if( ! devInfo.mCapabilitiesProbed )
+		probeCapabilities( devInfo );
+
+	const auto &probedRates = devInfo.mCapabilities.mProbedSampleRates;
+	if( find( probedRates.begin(), probedRates.end(), sampleRate ) != probedRates.end() )
+		return true;
+
+	return probeSampleRate( devInfo, sampleRate );
+}
+
+bool DeviceManagePortAudio::probeSampleRate( DeviceInfo &devInfo, size_t sampleRate )
+{
+	auto &caps = devInfo.mCapabilities;
+
+	vector<Capabilities::Entry> entries;
+	bool supported = false;
+	for( bool isInput : { true, false } ) {
+		PaStreamParameters params;
+		params.device = devInfo.mPaDeviceIndex;
+		params.hostApiSpecificStreamInfo = NULL;
+		params.suggestedLatency = getProfileLatency( devInfo, isInput );
+
+		for( size_t numChannels : isInput ? caps.mInputChannelCounts : caps.mOutputChannelCounts ) {
+			params.channelCount = (int)numChannels;
+
+			Capabilities::Entry entry = { sampleRate, numChannels, isInput, 0 };
+			for( auto format : PROBED_SAMPLE_FORMATS ) {
+				if( devInfo.mIsVirtual ) {
+					// the virtual output renders to memory, so supports any configuration
+					entry.mFormatMask |= uint8_t( 1 << (int)format );
+					continue;
+				}
+
+				params.sampleFormat = toPaSampleFormat( format );
+				PaError err = isInput ? Pa_IsFormatSupported( &params, nullptr, (double)sampleRate ) : Pa_IsFormatSupported( nullptr, &params, (double)sampleRate );
+				if( err == paFormatIsSupported )
+					entry.mFormatMask |= uint8_t( 1 << (int)format );
+				else if( ! isUnsupportedFormatError( err ) ) {
+					// nothing is cached, so that the rate is probed again the next time it's requested
+					LOG_CI_PORTAUDIO( "probing device '" << devInfo.mName << "' at sample rate " << sampleRate << " failed: " << Pa_GetErrorText( err ) );
+					return false;
+				}
+			}
+
+			entries.push_back( entry );
+			supported |= entry.mFormatMask != 0;
+		}
+	}
+
+	caps.mEntries.insert( caps.mEntries.end(), entries.begin(), entries.end() );
+	caps.mProbedSampleRates.push_back( sampleRate );
+	if( supported )
+		caps.mSampleRates.push_back( sampleRate );
+
+	return true;
 }
 
 void DeviceManagePortAudio::rebuildDevices()
 {
-	mDeviceInfoSet.clear();
+	RuntimePortAudio::ensureInitialized();
+
+	mDeviceInfos.clear();
+	mDeviceIndices.clear();
+	mDeviceIndicesByKey.clear();
+	mDeviceIndicesByName.clear();
 
 	PaDeviceIndex numDevices = Pa_GetDeviceCount();
+	mDeviceInfos.reserve( numDevices + 1 );
 	for( PaDeviceIndex i = 0; i < numDevices; i++ ) {
 		DeviceInfo devInfo;
 		auto devInfoPa = Pa_GetDeviceInfo( i );
@@ -160,15 +444,42 @@ void DeviceManagePortAudio::rebuildDevices()
 		devInfo.mNumOutputChannels = devInfoPa->maxOutputChannels;
 		devInfo.mSampleRate = (size_t)devInfoPa->defaultSampleRate;
 
-		// TODO: need to decide if this should be high, low, input or output
-		// - maybe should have DeviceManagerPortAudio-specific method for getting the range based on the DeviceRef
-		PaTime latencySeconds = devInfo.mNumOutputChannels > 0 ? devInfoPa->defaultHighOutputLatency : devInfoPa->defaultHighInputLatency;
-		//PaTime latencySeconds = devInfo.mNumOutputChannels > 0 ? devInfoPa->defaultLowOutputLatency : devInfoPa->defaultLowInputLatency;
+		// Devices start with the high latency profile, use setLatencyProfile() or setLatencySeconds() to change it.
+		// Output latency is used for the frames per block unless the device is input only.
+		PaTime latencySeconds = getProfileLatency( devInfo, devInfo.mNumOutputChannels == 0 );
 		devInfo.mFramesPerBlock = size_t( lround( latencySeconds * devInfoPa->defaultSampleRate ) );
 
-		DeviceRef addedDevice = addDevice( devInfo.mKey );
-		mDeviceInfoSet.insert( make_pair( addedDevice, devInfo ) );
+		devInfo.mDevice = addDevice( devInfo.mKey );
+		mDeviceIndices[devInfo.mDevice.get()] = i;
+		mDeviceIndicesByKey[devInfo.mKey] = i;
+		mDeviceIndicesByName.insert( make_pair( devInfo.mName, (size_t)i ) );
+		mDeviceInfos.push_back( move( devInfo ) );
 	}
+
+	if( mVirtualOutputEnabled )
+		addVirtualOutput();
+}
+
+void DeviceManagePortAudio::addVirtualOutput()
+{
+	// the virtual output always follows the PortAudio devices
+	DeviceInfo devInfo;
+	devInfo.mPaDeviceIndex = paNoDevice;
+	devInfo.mPaHostindex = paNoDevice;
+	devInfo.mIsVirtual = true;
+	devInfo.mName = VIRTUAL_OUTPUT_NAME;
+	devInfo.mKey = string( "virtual - " ) + VIRTUAL_OUTPUT_NAME;
+	devInfo.mNumInputChannels = 0;
+	devInfo.mNumOutputChannels = VIRTUAL_OUTPUT_MAX_CHANNELS;
+	devInfo.mSampleRate = VIRTUAL_OUTPUT_SAMPLE_RATE;
+	devInfo.mFramesPerBlock = VIRTUAL_OUTPUT_FRAMES_PER_BLOCK;
+
+	size_t index = mDeviceInfos.size();
+	devInfo.mDevice = addDevice( devInfo.mKey );
+	mDeviceIndices[devInfo.mDevice.get()] = index;
+	mDeviceIndicesByKey[devInfo.mKey] = index;
+	mDeviceIndicesByName.insert( make_pair( devInfo.mName, index ) );
+	mDeviceInfos.push_back( move( devInfo ) );
 }
 
 } } // namespace cinder::audio
@@ -26,8 +26,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "cinder/Cinder.h"
 
 #include "cinder/audio/Device.h"
+#include "cinder/audio/SampleFormatPortAudio.h"
 
-#include <map>
+#include <unordered_map>
 
 namespace cinder { namespace audio {
 
@@ -40,6 +41,8 @@ class DeviceManagePortAudio : public DeviceManager {
 	DeviceRef getDefaultInput() override;
 
 	const std::vector<DeviceRef>& getDevices() override;
+	DeviceRef findDeviceByName( const std::string &name, bool supportsInput = false, bool supportsOutput = false ) override;
+	DeviceRef findDeviceByKey( const std::string &key ) override;
 
 	std::string getName( const DeviceRef &device ) override;
 	size_t getNumInputChannels( const DeviceRef &device ) override;
@@ -51,12 +54,79 @@ class DeviceManagePortAudio : public DeviceManager {
 	void setFramesPerBlock( const DeviceRef &device, size_t framesPerBlock ) override;
 
 	// PortAudio specific methods
+	//! Returns the PortAudio device index for \a device, which is paNoDevice for the virtual output.
 	int getPaDeviceIndex( const DeviceRef &device ) const;
+	//! Returns the Device for PortAudio device \a index, or a null DeviceRef if there isn't one.
+	DeviceRef findDeviceByPaIndex( int index );
+
+	//! Returns the virtual output device, which isn't backed by PortAudio. An OutputDeviceNodePortAudio created for it renders the graph on its own thread, either as fast as possible or paced to a virtual clock,
+	//! and delivers the output to a sink callback or file (see OutputDeviceNodePortAudio::setVirtualSink()). The device is created by the first call, and only from then on listed by getDevices().
+	//! It is never returned by getDefaultOutput(), which returns a null DeviceRef when PortAudio has no default output, ex. on a headless server.
+	DeviceRef getVirtualOutput();
+	//! Returns true if \a device is the virtual output device.
+	bool isVirtual( const DeviceRef &device ) const;
+
+	//! Stream configurations that a device accepted when probed with Pa_IsFormatSupported().
+	class Capabilities {
+	  public:
+		//! Returns true if a stream with \a numChannels and \a format can be opened at \a sampleRate. Channel counts that weren't probed are checked against the next higher probed count.
+		bool isSupported( size_t sampleRate, size_t numChannels, SampleFormatPortAudio format, bool isInput ) const;
+		//! Returns true if any probed input or output configuration supports \a sampleRate. Returns false for rates that haven't been probed.
+		bool isSampleRateSupported( size_t sampleRate ) const;
+		//! Returns the sample rates that have been probed so far and are supported by at least one configuration.
+		const std::vector<size_t>&	getSampleRates() const		{ return mSampleRates; }
+		//! Returns the input channel counts that were probed.
+		const std::vector<size_t>&	getInputChannelCounts() const	{ return mInputChannelCounts; }
+		//! Returns the output channel counts that were probed.
+		const std::vector<size_t>&	getOutputChannelCounts() const	{ return mOutputChannelCounts; }
+
+	  private:
+		struct Entry {
+			size_t	mSampleRate;
+			size_t	mNumChannels;
+			bool	mIsInput;
+			uint8_t	mFormatMask;	// bit per SampleFormatPortAudio value
+		};
+
+		const Entry* findEntry( size_t sampleRate, size_t numChannels, bool isInput ) const;
+
+		std::vector<Entry>	mEntries;
+		std::vector<size_t>	mSampleRates, mProbedSampleRates, mInputChannelCounts, mOutputChannelCounts;
+
+		friend class DeviceManagePortAudio;
+	};
+
+	//! Returns the probed capabilities of \a device. The device's default sample rate is probed on the first call, other rates when they are passed to setSampleRate() or isSampleRateSupported(). The results are cached until the devices are rebuilt.
+	const Capabilities&	getCapabilities( const DeviceRef &device );
+	//! Returns true if \a device supports \a sampleRate in any configuration, probing the rate on first use. Returns false if PortAudio couldn't answer, ex. because the device is busy, in which case the rate is probed again on the next call.
+	bool				isSampleRateSupported( const DeviceRef &device, size_t sampleRate );
+
+	//! Determines the latency that streams are opened with and the Device's default frames per block.
+	enum class LatencyProfile {
+		LOW,		//!< uses the device's default low input / output latency, suitable for interactive and live use
+		HIGH,		//!< uses the device's default high input / output latency, suitable for playback. This is the default.
+		CUSTOM		//!< uses an explicit latency in seconds, set with setLatencySeconds() or derived from the frames per block
+	};
+
+	//! Sets the latency profile for \a device, updating its frames per block to match. Takes effect the next time the device's nodes are initialized.
+	void			setLatencyProfile( const DeviceRef &device, LatencyProfile profile );
+	//! Returns the latency profile for \a device.
+	LatencyProfile	getLatencyProfile( const DeviceRef &device ) const;
+	//! Sets an explicit latency target of \a seconds for \a device, updating its frames per block to match. The profile becomes LatencyProfile::CUSTOM.
+	void			setLatencySeconds( const DeviceRef &device, double seconds );
+	//! Returns the latency in seconds that input streams for \a device request from PortAudio.
+	double			getSuggestedInputLatency( const DeviceRef &device ) const;
+	//! Returns the latency in seconds that output streams for \a device request from PortAudio.
+	double			getSuggestedOutputLatency( const DeviceRef &device ) const;
+	//! Returns the input latency in seconds that PortAudio granted the most recently opened stream for \a device, or 0 if none has been opened.
+	double			getGrantedInputLatency( const DeviceRef &device ) const;
+	//! Returns the output latency in seconds that PortAudio granted the most recently opened stream for \a device, or 0 if none has been opened.
+	double			getGrantedOutputLatency( const DeviceRef &device ) const;
 
   private:
 
-	// TODO: cleanup
 	struct DeviceInfo {
+		DeviceRef	mDevice;
 		int		mPaDeviceIndex;
 		int		mPaHostindex;
 		std::string mName;						//! friendly mName
@@ -64,14 +134,40 @@ class DeviceManagePortAudio : public DeviceManager {
 		//enum Usage { INPUT, OUTPUT } mUsage; // TODO: I think this could be input, output, or duplex
 
 		size_t mNumInputChannels, mNumOutputChannels, mSampleRate, mFramesPerBlock;
+
+		LatencyProfile	mLatencyProfile = LatencyProfile::HIGH;
+		double			mLatencySeconds = 0;	//! used when mLatencyProfile is CUSTOM
+		double			mGrantedInputLatency = 0, mGrantedOutputLatency = 0;
+
+		bool			mCapabilitiesProbed = false;
+		Capabilities	mCapabilities;
+
+		bool			mIsVirtual = false;
 	};
 
-	DeviceRef findDeviceByPaIndex( int index );
 	DeviceInfo& getDeviceInfo( const DeviceRef &device );
 	const DeviceInfo& getDeviceInfo( const DeviceRef &device ) const;
 	void rebuildDevices();
-
-	std::map<DeviceRef, DeviceInfo> mDeviceInfoSet;
+	void addVirtualOutput();
+	void probeCapabilities( DeviceInfo &devInfo );
+	//! Probes \a sampleRate unless it has already been probed. Returns false if PortAudio couldn't answer.
+	bool ensureSampleRateProbed( DeviceInfo &devInfo, size_t sampleRate );
+	//! Probes every configuration at \a sampleRate, caching the results in the device's capabilities. Returns false without caching anything if a probe failed with an error other than the configuration being unsupported.
+	bool probeSampleRate( DeviceInfo &devInfo, size_t sampleRate );
+
+	//! Returns the latency in seconds for the device's profile, \a isInput selects between the input and output default latencies
+	double getProfileLatency( const DeviceInfo &devInfo, bool isInput ) const;
+	//! Called by the device nodes after opening a stream, with the values from Pa_GetStreamInfo(). A latency of 0 leaves that direction unchanged.
+	void setGrantedLatency( const DeviceRef &device, double inputLatency, double outputLatency );
+
+	std::vector<DeviceInfo>							mDeviceInfos;			// indexed by PortAudio device index, followed by the virtual output once it has been requested
+	std::unordered_map<const Device *, size_t>		mDeviceIndices;			// Device to index in mDeviceInfos
+	std::unordered_map<std::string, size_t>			mDeviceIndicesByKey;
+	std::unordered_multimap<std::string, size_t>	mDeviceIndicesByName;	// names aren't unique across host APIs
+	bool											mVirtualOutputEnabled = false;
+
+	friend class OutputDeviceNodePortAudio;
+	friend class InputDeviceNodePortAudio;
 };
 
 } } // namespace cinder::audio
@@ -0,0 +1,449 @@
+/*
+ Copyright (c) 2018, The Cinder Project
+
+ This code is intended to be used with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "cinder/audio/NodeProfilerPortAudio.h"
+#include "cinder/audio/Context.h"
+#include "cinder/audio/Node.h"
+#include "cinder/CinderAssert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+	#include <intrin.h>
+	#define CI_PORTAUDIO_HAS_RDTSC 1
+#elif defined( __x86_64__ ) || defined( __i386__ )
+	#include <x86intrin.h>
+	#define CI_PORTAUDIO_HAS_RDTSC 1
+#endif
+
+using namespace std;
+
+namespace cinder { namespace audio {
+
+namespace {
+
+// markers for a slot's node while it is being claimed and after it has been released, only compared against
+char sClaimingMarker, sReleasedMarker;
+const Node *const CLAIMING_NODE = reinterpret_cast<const Node *>( &sClaimingMarker );
+const Node *const RELEASED_NODE = reinterpret_cast<const Node *>( &sReleasedMarker );
+
+bool isNode( const Node *node )
+{
+	return node && node != CLAIMING_NODE && node != RELEASED_NODE;
+}
+
+// Node::process() and Node::pullInputs() are protected, a Node subclass can name them to call them on other nodes
+struct NodeAccess : public Node {
+	static void callProcess( Node *node, Buffer *buffer )		{ ( node->*&NodeAccess::process )( buffer ); }
+	static void callPullInputs( Node *node, Buffer *buffer )	{ ( node->*&NodeAccess::pullInputs )( buffer ); }
+};
+
+double getSteadySeconds()
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------------------------------
+// NodeProfilerPortAudio
+// ----------------------------------------------------------------------------------------------------
+
+const size_t NodeProfilerPortAudio::MAX_NODES; // bound by reference in std::min()
+
+NodeProfilerPortAudio::NodeProfilerPortAudio( Context *context )
+	: mContext( context ), mSlots( new Slot[MAX_NODES] )
+{
+	mResetRequested = true;
+	for( size_t i = 0; i < MAX_NODES; i++ )
+		mSlots[i].mNode = nullptr;
+
+	mCalibrationTicks = getTicks();
+	mCalibrationSeconds = getSteadySeconds();
+}
+
+void NodeProfilerPortAudio::beginBlock( uint64_t frame )
+{
+	if( mResetRequested.exchange( false ) ) {
+		// slots stay claimed by their nodes, so that their owners are only released by releaseDestroyedNodes()
+		for( size_t i = 0; i < MAX_NODES; i++ )
+			clearSlotStats( &mSlots[i] );
+
+		mNumBlocks = 0;
+		mTotalBlockTicks = 0;
+
+		mWorstSequence.fetch_add( 1, memory_order_relaxed );
+		atomic_thread_fence( memory_order_release );
+		mWorstFrame.store( 0, memory_order_relaxed );
+		mWorstTotalTicks.store( 0, memory_order_relaxed );
+		mNumWorstSlots.store( 0, memory_order_relaxed );
+		mWorstSequence.fetch_add( 1, memory_order_release );
+	}
+
+	mNumBlockSlots = 0;
+	mBlockFrame = frame;
+	mBlockStartTicks = getTicks();
+}
+
+void NodeProfilerPortAudio::endBlock()
+{
+	uint64_t blockTicks = getTicks() - mBlockStartTicks;
+
+	for( size_t i = 0; i < mNumBlockSlots; i++ ) {
+		Slot &slot = mSlots[mBlockSlots[i]];
+		uint64_t ticks = mBlockTicks[i];
+		slot.mNumBlocks.fetch_add( 1, memory_order_relaxed );
+		slot.mTotalTicks.fetch_add( ticks, memory_order_relaxed );
+		slot.mBuckets[getBucket( ticks )].fetch_add( 1, memory_order_relaxed );
+		if( ticks > slot.mMaxTicks.load( memory_order_relaxed ) )
+			slot.mMaxTicks.store( ticks, memory_order_relaxed ); // only written from the audio thread
+	}
+
+	mNumBlocks.fetch_add( 1, memory_order_relaxed );
+	mTotalBlockTicks.fetch_add( blockTicks, memory_order_relaxed );
+
+	if( blockTicks > mWorstTotalTicks.load( memory_order_relaxed ) ) {
+		mWorstSequence.fetch_add( 1, memory_order_relaxed ); // odd while writing
+		atomic_thread_fence( memory_order_release );
+
+		mWorstFrame.store( mBlockFrame, memory_order_relaxed );
+		mWorstTotalTicks.store( blockTicks, memory_order_relaxed );
+		for( size_t i = 0; i < mNumBlockSlots; i++ ) {
+			mWorstNodes[i].store( mBlockNodes[i], memory_order_relaxed );
+			mWorstTicks[i].store( mBlockTicks[i], memory_order_relaxed );
+		}
+		mNumWorstSlots.store( mNumBlockSlots, memory_order_relaxed );
+
+		mWorstSequence.fetch_add( 1, memory_order_release );
+	}
+}
+
+size_t NodeProfilerPortAudio::copyLastBlock( const Node **nodes, double *seconds, size_t maxNodes ) const
+{
+	const double secondsPerTick = getSecondsPerTick();
+	size_t numNodes = min( mNumBlockSlots, maxNodes );
+	for( size_t i = 0; i < numNodes; i++ ) {
+		nodes[i] = mBlockNodes[i];
+		seconds[i] = (double)mBlockTicks[i] * secondsPerTick;
+	}
+
+	return numNodes;
+}
+
+void NodeProfilerPortAudio::pullInputs( const shared_ptr<Node> &node, Buffer *buffer )
+{
+	const auto &inputs = node->getInputs();
+	if( node->getProcessesInPlace() && inputs.size() == 1 && (*inputs.begin())->getProcessesInPlace() ) {
+		// an in-place chain, pulled with the same steps as Node::pullInputs() so that each node's process() is timed on its own
+		pullInputs( *inputs.begin(), buffer );
+		if( node->isEnabled() ) {
+			uint64_t startTicks = getTicks();
+			NodeAccess::callProcess( node.get(), buffer );
+			record( node, getTicks() - startTicks );
+		}
+		return;
+	}
+
+	// Inputs that sum their own inputs are only processed once per block, so pulling them first leaves the node's
+	// Node::pullInputs() with just its own work. Inputs that process in place can only be pulled by it.
+	for( const auto &input : inputs ) {
+		if( ! input->getProcessesInPlace() )
+			pullInputs( input, buffer );
+	}
+
+	uint64_t startTicks = getTicks();
+	NodeAccess::callPullInputs( node.get(), buffer );
+	record( node, getTicks() - startTicks );
+}
+
+void NodeProfilerPortAudio::record( const shared_ptr<Node> &node, uint64_t ticks )
+{
+	// a node may be recorded more than once per block, ex. if it is pulled by more than one output
+	for( size_t i = 0; i < mNumBlockSlots; i++ ) {
+		if( mBlockNodes[i] == node.get() ) {
+			mBlockTicks[i] += ticks;
+			return;
+		}
+	}
+
+	Slot *slot = findSlot( node );
+	if( ! slot )
+		return; // out of slots, counted as unattributed
+
+	mBlockSlots[mNumBlockSlots] = slot - mSlots.get();
+	mBlockNodes[mNumBlockSlots] = node.get();
+	mBlockTicks[mNumBlockSlots] = ticks;
+	mNumBlockSlots++;
+}
+
+NodeProfilerPortAudio::Slot* NodeProfilerPortAudio::findSlot( const shared_ptr<Node> &node )
+{
+	// open addressing on the node's address, released slots keep the probe sequence going and are reused for new nodes
+	size_t hash = ( (uintptr_t)node.get() >> 4 ) * 2654435761u;
+	Slot *freeSlot = nullptr;
+	for( size_t i = 0; i < MAX_NODES; i++ ) {
+		Slot &slot = mSlots[( hash + i ) % MAX_NODES];
+		const Node *current = slot.mNode.load( memory_order_acquire );
+		if( current == node.get() )
+			return &slot;
+
+		if( current == RELEASED_NODE && ! freeSlot )
+			freeSlot = &slot;
+		else if( ! current ) {
+			if( ! freeSlot )
+				freeSlot = &slot;
+			break;
+		}
+	}
+
+	if( ! freeSlot )
+		return nullptr;
+
+	const Node *expected = freeSlot->mNode.load( memory_order_relaxed );
+	if( isNode( expected ) || expected == CLAIMING_NODE || ! freeSlot->mNode.compare_exchange_strong( expected, CLAIMING_NODE, memory_order_acquire ) )
+		return nullptr; // claimed by another thread, the node gets a slot in a later block
+
+	// the stats may have been added to by a block that ended after the slot was released
+	clearSlotStats( freeSlot );
+	// copying the weak_ptr doesn't allocate, and it is only reset off of the audio thread
+	freeSlot->mOwner = node;
+	freeSlot->mNode.store( node.get(), memory_order_release );
+	return freeSlot;
+}
+
+void NodeProfilerPortAudio::releaseDestroyedNodes()
+{
+	for( size_t i = 0; i < MAX_NODES; i++ ) {
+		Slot &slot = mSlots[i];
+		const Node *current = slot.mNode.load( memory_order_acquire );
+		if( ! isNode( current ) || ! slot.mOwner.expired() )
+			continue;
+
+		// a new node at the same address would otherwise inherit the destroyed node's statistics
+		if( ! slot.mNode.compare_exchange_strong( current, CLAIMING_NODE, memory_order_acquire ) )
+			continue;
+
+		slot.mOwner.reset();
+		clearSlotStats( &slot );
+		slot.mNode.store( RELEASED_NODE, memory_order_release );
+	}
+}
+
+// static
+void NodeProfilerPortAudio::clearSlotStats( Slot *slot )
+{
+	slot->mNumBlocks.store( 0, memory_order_relaxed );
+	slot->mTotalTicks.store( 0, memory_order_relaxed );
+	slot->mMaxTicks.store( 0, memory_order_relaxed );
+	for( auto &bucket : slot->mBuckets )
+		bucket.store( 0, memory_order_relaxed );
+}
+
+std::vector<NodeProfilerPortAudio::NodeStats> NodeProfilerPortAudio::getTopNodes( size_t count ) const
+{
+	const double secondsPerTick = getSecondsPerTick();
+	const double totalBlockSeconds = (double)mTotalBlockTicks.load( memory_order_relaxed ) * secondsPerTick;
+
+	vector<NodeStats> result;
+	for( size_t i = 0; i < MAX_NODES; i++ ) {
+		const Slot &slot = mSlots[i];
+		const Node *node = slot.mNode.load( memory_order_acquire );
+		uint64_t numBlocks = slot.mNumBlocks.load( memory_order_relaxed );
+		if( ! isNode( node ) || numBlocks == 0 )
+			continue;
+
+		NodeStats stats;
+		stats.mNode = node;
+		stats.mNumBlocks = numBlocks;
+		stats.mTotal = (double)slot.mTotalTicks.load( memory_order_relaxed ) * secondsPerTick;
+		stats.mAverage = stats.mTotal / (double)numBlocks;
+		stats.mMax = (double)slot.mMaxTicks.load( memory_order_relaxed ) * secondsPerTick;
+		stats.mFraction = totalBlockSeconds > 0 ? stats.mTotal / totalBlockSeconds : 0;
+
+		// the p99 bucket's upper bound, in ticks
+		uint64_t threshold = (uint64_t)ceil( 0.99 * (double)numBlocks );
+		uint64_t accumulated = 0;
+		for( size_t b = 0; b < NUM_BUCKETS; b++ ) {
+			accumulated += slot.mBuckets[b].load( memory_order_relaxed );
+			if( accumulated >= threshold ) {
+				stats.mP99 = exp2( (double)b / 2.0 ) * secondsPerTick;
+				break;
+			}
+		}
+
+		result.push_back( stats );
+	}
+
+	sort( result.begin(), result.end(), []( const NodeStats &a, const NodeStats &b ) { return a.mTotal > b.mTotal; } );
+	if( result.size() > count )
+		result.resize( count );
+
+	resolveNames( &result );
+	return result;
+}
+
+NodeProfilerPortAudio::BlockBreakdown NodeProfilerPortAudio::getWorstBlock() const
+{
+	const double secondsPerTick = getSecondsPerTick();
+
+	BlockBreakdown result;
+	vector<pair<const Node *, uint64_t>> nodeTicks;
+	uint64_t frame, totalTicks;
+	while( true ) {
+		uint64_t sequence = mWorstSequence.load( memory_order_acquire );
+		if( sequence & 1 )
+			continue;
+
+		frame = mWorstFrame.load( memory_order_relaxed );
+		totalTicks = mWorstTotalTicks.load( memory_order_relaxed );
+		size_t numSlots = min( mNumWorstSlots.load( memory_order_relaxed ), MAX_NODES );
+		nodeTicks.resize( numSlots );
+		for( size_t i = 0; i < numSlots; i++ )
+			nodeTicks[i] = make_pair( mWorstNodes[i].load( memory_order_relaxed ), mWorstTicks[i].load( memory_order_relaxed ) );
+
+		atomic_thread_fence( memory_order_acquire );
+		if( mWorstSequence.load( memory_order_relaxed ) == sequence )
+			break;
+	}
+
+	result.mFrame = frame;
+	result.mTotal = (double)totalTicks * secondsPerTick;
+	result.mUnattributed = result.mTotal;
+	for( const auto &nt : nodeTicks ) {
+		NodeStats stats;
+		stats.mNode = nt.first;
+		stats.mNumBlocks = 1;
+		stats.mTotal = stats.mAverage = stats.mMax = (double)nt.second * secondsPerTick;
+		stats.mFraction = result.mTotal > 0 ? stats.mTotal / result.mTotal : 0;
+		result.mUnattributed -= stats.mTotal;
+		result.mNodes.push_back( stats );
+	}
+
+	result.mUnattributed = max( 0.0, result.mUnattributed );
+	sort( result.mNodes.begin(), result.mNodes.end(), []( const NodeStats &a, const NodeStats &b ) { return a.mTotal > b.mTotal; } );
+	resolveNames( &result.mNodes );
+	return result;
+}
+
+std::string NodeProfilerPortAudio::getReport( size_t count ) const
+{
+	auto topNodes = getTopNodes( count );
+	auto worstBlock = getWorstBlock();
+
+	stringstream ss;
+	ss << fixed << setprecision( 2 );
+	ss << "node profile, blocks: " << getNumBlocks() << endl;
+	for( size_t i = 0; i < topNodes.size(); i++ ) {
+		const auto &stats = topNodes[i];
+		ss << "  " << i + 1 << ". " << stats.mName << " - avg: " << stats.mAverage * 1e6 << "us, p99: " << stats.mP99 * 1e6 << "us, max: " << stats.mMax * 1e6
+			<< "us, share: " << stats.mFraction * 100 << "%" << endl;
+	}
+
+	ss << "worst block at frame " << worstBlock.mFrame << ", total: " << worstBlock.mTotal * 1e6 << "us" << endl;
+	for( const auto &stats : worstBlock.mNodes )
+		ss << "  " << stats.mName << ": " << stats.mTotal * 1e6 << "us" << endl;
+	ss << "  (unattributed): " << worstBlock.mUnattributed * 1e6 << "us" << endl;
+
+	return ss.str();
+}
+
+void NodeProfilerPortAudio::reset()
+{
+	mResetRequested = true;
+}
+
+double NodeProfilerPortAudio::getSecondsPerTick() const
+{
+#if defined( CI_PORTAUDIO_HAS_RDTSC )
+	// calibrate the timestamp counter against steady_clock over the time since the profiler was created
+	double elapsedSeconds = getSteadySeconds() - mCalibrationSeconds;
+	uint64_t elapsedTicks = getTicks() - mCalibrationTicks;
+	if( elapsedSeconds > 0 && elapsedTicks > 0 )
+		return elapsedSeconds / (double)elapsedTicks;
+#endif
+
+	return 1e-9;
+}
+
+void NodeProfilerPortAudio::resolveNames( std::vector<NodeStats> *stats ) const
+{
+	// walk the graph from the output and the auto-pulled nodes, so that names are only read from nodes that are still alive
+	unordered_map<const Node *, string> names;
+	vector<NodeRef> stack;
+	if( mContext->getOutput() )
+		stack.push_back( mContext->getOutput() );
+	for( const auto &node : mContext->getAutoPulledNodes() )
+		stack.push_back( node );
+
+	while( ! stack.empty() ) {
+		NodeRef node = stack.back();
+		stack.pop_back();
+		if( ! node || names.count( node.get() ) )
+			continue;
+
+		names[node.get()] = node->getName();
+		for( const auto &input : node->getInputs() )
+			stack.push_back( input );
+	}
+
+	for( auto &s : *stats ) {
+		auto it = names.find( s.mNode );
+		if( it != names.end() ) {
+			s.mName = it->second;
+		}
+		else {
+			stringstream ss;
+			ss << "(disconnected node " << s.mNode << ")";
+			s.mName = ss.str();
+		}
+	}
+}
+
+// static
+uint64_t NodeProfilerPortAudio::getTicks()
+{
+#if defined( CI_PORTAUDIO_HAS_RDTSC )
+	return (uint64_t)__rdtsc();
+#else
+	return (uint64_t)chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+}
+
+// static
+size_t NodeProfilerPortAudio::getBucket( uint64_t ticks )
+{
+	// half octaves, from 1 tick
+	if( ticks <= 1 )
+		return 0;
+
+	size_t bucket = 1 + (size_t)( log2( (double)ticks ) * 2.0 );
+	return min( bucket, NUM_BUCKETS - 1 );
+}
+
+} } // namespace cinder::audio
@@ -0,0 +1,138 @@
+/*
+ Copyright (c) 2018, The Cinder Project
+
+ This code is intended to be used with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/audio/Buffer.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cinder { namespace audio {
+
+class Context;
+class Node;
+
+//! Opt-in profiler for the time each Node spends processing, for graphs driven by OutputDeviceNodePortAudio. Enable it with ContextPortAudio::enableNodeProfiling().
+//!
+//! While profiling is enabled, OutputDeviceNodePortAudio pulls its graph through pullInputs() in place of Node::pullInputs(), which performs the same steps while timing
+//! each node, so no node needs to be changed to be profiled. The only exception are the inputs of a node that sums more than one input and process in place,
+//! since Node::sumInputs() pulls them into the summing node's own buffers: their time is counted as the summing node's. Nodes pulled by Context::addAutoPulledNode() are not profiled.
+//! Timing uses the CPU's timestamp counter where available (x86), otherwise std::chrono::steady_clock. All storage is preallocated and updated lock-free from the audio thread.
+//! A node's statistics are kept until it is destroyed, see releaseDestroyedNodes().
+class NodeProfilerPortAudio {
+  public:
+	//! The maximum number of distinct nodes that can be profiled, further nodes are counted as unattributed time.
+	static const size_t MAX_NODES = 256;
+
+	//! Timing statistics for one node. Times are in seconds per block.
+	struct NodeStats {
+		const Node*	mNode = nullptr;
+		std::string	mName;			//!< resolved by walking the Context's graph, or a placeholder if the node is no longer connected
+		uint64_t	mNumBlocks = 0;
+		double		mTotal = 0;
+		double		mAverage = 0;
+		double		mP99 = 0;		//!< upper bound of the histogram bucket (half an octave wide) that contains the 99th percentile
+		double		mMax = 0;
+		double		mFraction = 0;	//!< fraction of all profiled block time
+	};
+
+	//! Breakdown of the most expensive block since profiling was enabled or reset.
+	struct BlockBreakdown {
+		uint64_t				mFrame = 0;		//!< Context::getNumProcessedFrames() at the start of the block
+		double					mTotal = 0;		//!< time of the whole pull, in seconds
+		double					mUnattributed = 0;	//!< time not covered by any probe
+		std::vector<NodeStats>	mNodes;			//!< mTotal holds the node's time in this block, sorted most expensive first
+	};
+
+	NodeProfilerPortAudio( Context *context );
+
+	//! Returns up to \a count nodes, sorted by their total time. Call from a non-realtime thread.
+	std::vector<NodeStats>	getTopNodes( size_t count ) const;
+	//! Returns the breakdown of the most expensive block. Call from a non-realtime thread.
+	BlockBreakdown			getWorstBlock() const;
+	//! Returns a printable report of the top \a count nodes and the worst block.
+	std::string				getReport( size_t count = 10 ) const;
+	//! Clears all statistics. Takes effect at the start of the next profiled block.
+	void					reset();
+	//! Drops the statistics of nodes that have been destroyed, freeing their slots for new nodes. Called periodically by ContextPortAudio's diagnostic drain thread, and safe to call from any non-realtime thread.
+	void					releaseDestroyedNodes();
+	//! Returns the number of blocks profiled.
+	uint64_t				getNumBlocks() const	{ return mNumBlocks; }
+
+	//! Called by OutputDeviceNodePortAudio around each pull of the graph, on the audio thread.
+	void beginBlock( uint64_t frame );
+	void endBlock();
+	//! Pulls \a node and its inputs into \a buffer like Node::pullInputs(), timing each node. Called by OutputDeviceNodePortAudio between beginBlock() and endBlock(), on the audio thread.
+	void pullInputs( const std::shared_ptr<Node> &node, Buffer *buffer );
+	//! Copies the time each node spent in the most recently completed block, in seconds, returning the number of nodes copied (at most \a maxNodes). Only call from the audio thread, between blocks.
+	size_t copyLastBlock( const Node **nodes, double *seconds, size_t maxNodes ) const;
+
+  private:
+	static const size_t NUM_BUCKETS = 64;
+
+	struct Slot {
+		std::atomic<const Node *>	mNode;		// nullptr if never used, or one of the markers while being claimed or after being released
+		std::weak_ptr<Node>			mOwner;		// written by the audio thread while claiming the slot, reset by releaseDestroyedNodes()
+		std::atomic<uint64_t>		mNumBlocks, mTotalTicks, mMaxTicks;
+		std::atomic<uint64_t>		mBuckets[NUM_BUCKETS];
+	};
+
+	void		record( const std::shared_ptr<Node> &node, uint64_t ticks );
+	Slot*		findSlot( const std::shared_ptr<Node> &node );
+	static void	clearSlotStats( Slot *slot );
+	double		getSecondsPerTick() const;
+	void		resolveNames( std::vector<NodeStats> *stats ) const;
+
+	static uint64_t	getTicks();
+	static size_t	getBucket( uint64_t ticks );
+
+	Context*					mContext;
+	std::unique_ptr<Slot[]>		mSlots;
+	std::atomic<bool>			mResetRequested = { false };
+	std::atomic<uint64_t>		mNumBlocks = { 0 }, mTotalBlockTicks = { 0 };
+
+	// current block, only touched on the audio thread
+	uint64_t					mBlockFrame = 0, mBlockStartTicks = 0;
+	uint64_t					mBlockTicks[MAX_NODES];
+	size_t						mBlockSlots[MAX_NODES];
+	const Node*					mBlockNodes[MAX_NODES];
+	size_t						mNumBlockSlots = 0;
+
+	// worst block, written with a sequence lock so the reader can retry instead of blocking the audio thread
+	std::atomic<uint64_t>		mWorstSequence = { 0 };
+	std::atomic<uint64_t>		mWorstFrame = { 0 }, mWorstTotalTicks = { 0 };
+	std::atomic<uint64_t>		mWorstTicks[MAX_NODES];
+	std::atomic<const Node *>	mWorstNodes[MAX_NODES];	// nodes rather than slots, since a slot may be released and reused
+	std::atomic<size_t>			mNumWorstSlots = { 0 };
+
+	// for converting timestamp counter ticks to seconds
+	uint64_t					mCalibrationTicks;
+	double						mCalibrationSeconds;
+};
+
+} } // namespace cinder::audio
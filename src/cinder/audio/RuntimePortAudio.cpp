@@ -0,0 +1,137 @@
+/*
+ Copyright (c) 2018, The Cinder Project
+
+ This code is intended to be used with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "cinder/audio/RuntimePortAudio.h"
+#include "cinder/audio/Exception.h"
+#include "cinder/CinderAssert.h"
+#include "cinder/Log.h"
+
+#include "portaudio.h"
+
+#include <mutex>
+
+#define LOG_CI_PORTAUDIO( stream )	CI_LOG_I( stream )
+//#define LOG_CI_PORTAUDIO( stream )	    ( (void)( 0 ) )
+
+using namespace std;
+
+namespace cinder { namespace audio {
+
+namespace {
+
+struct RuntimeState {
+	mutex			mMutex;
+	size_t			mRefCount = 0;
+	bool			mInitialized = false;
+	bool			mHostApiFilterApplied = false;
+	vector<int>		mHostApis;
+};
+
+RuntimeState& getState()
+{
+	static RuntimeState sState;
+	return sState;
+}
+
+} // anonymous namespace
+
+void RuntimePortAudio::setHostApis( const std::vector<int> &hostApiTypes )
+{
+	auto &state = getState();
+	lock_guard<mutex> lock( state.mMutex );
+
+	if( state.mInitialized )
+		throw AudioExc( "RuntimePortAudio::setHostApis() must be called before PortAudio is initialized" );
+
+	state.mHostApis = hostApiTypes;
+}
+
+std::vector<int> RuntimePortAudio::getHostApis()
+{
+	auto &state = getState();
+	lock_guard<mutex> lock( state.mMutex );
+
+	return state.mHostApis;
+}
+
+void RuntimePortAudio::retain()
+{
+	auto &state = getState();
+	lock_guard<mutex> lock( state.mMutex );
+
+	state.mRefCount++;
+}
+
+void RuntimePortAudio::release()
+{
+	auto &state = getState();
+	lock_guard<mutex> lock( state.mMutex );
+
+	CI_ASSERT( state.mRefCount > 0 );
+	if( --state.mRefCount == 0 && state.mInitialized ) {
+		PaError err = Pa_Terminate();
+		CI_VERIFY( err == paNoError );
+		state.mInitialized = false;
+		LOG_CI_PORTAUDIO( "PortAudio terminated" );
+	}
+}
+
+void RuntimePortAudio::ensureInitialized()
+{
+	auto &state = getState();
+	lock_guard<mutex> lock( state.mMutex );
+
+	if( state.mInitialized )
+		return;
+
+	// only touch the filter if one is or was requested, since it can't be changed if PortAudio was already initialized elsewhere in the app
+	if( ! state.mHostApis.empty() || state.mHostApiFilterApplied ) {
+		vector<PaHostApiTypeId> hostApis;
+		for( int type : state.mHostApis )
+			hostApis.push_back( (PaHostApiTypeId)type );
+
+		PaError err = Pa_SetHostApiFilter( hostApis.empty() ? nullptr : hostApis.data(), (int)hostApis.size() );
+		if( err == paNoError )
+			state.mHostApiFilterApplied = ! hostApis.empty();
+		else
+			CI_LOG_W( "failed to restrict PortAudio host APIs (" << Pa_GetErrorText( err ) << "), it may already be initialized elsewhere" );
+	}
+
+	PaError err = Pa_Initialize();
+	if( err != paNoError )
+		throw AudioExc( string( "Failed to initialize PortAudio: " ) + Pa_GetErrorText( err ), (int32_t)err );
+
+	state.mInitialized = true;
+	LOG_CI_PORTAUDIO( "PortAudio initialized, host APIs: " << Pa_GetHostApiCount() << ", devices: " << Pa_GetDeviceCount() );
+}
+
+bool RuntimePortAudio::isInitialized()
+{
+	auto &state = getState();
+	lock_guard<mutex> lock( state.mMutex );
+
+	return state.mInitialized;
+}
+
+} } // namespace cinder::audio
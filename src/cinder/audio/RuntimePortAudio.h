@@ -0,0 +1,51 @@
+/*
+ Copyright (c) 2018, The Cinder Project
+
+ This code is intended to be used with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include "cinder/Cinder.h"
+
+#include <vector>
+
+namespace cinder { namespace audio {
+
+//! Reference counted PortAudio library state, shared by ContextPortAudio and DeviceManagePortAudio. Pa_Initialize() is deferred until the first device query or node creation, and Pa_Terminate() is called once the last reference is released.
+class RuntimePortAudio {
+  public:
+	//! Restricts the host APIs that PortAudio initializes to \a hostApiTypes (PaHostApiTypeId values, ex. { paALSA } or { paJACK }), so unused backends are never probed. An empty vector (the default) initializes all host APIs compiled into PortAudio. Must be called before PortAudio is initialized, throws AudioExc otherwise.
+	static void						setHostApis( const std::vector<int> &hostApiTypes );
+	//! Returns the host APIs that PortAudio is restricted to, or an empty vector if there is no restriction.
+	static std::vector<int>			getHostApis();
+
+	//! Adds a reference to the runtime, without initializing PortAudio.
+	static void		retain();
+	//! Removes a reference to the runtime. Terminates PortAudio if this was the last reference and it was initialized.
+	static void		release();
+	//! Initializes PortAudio if it hasn't been already. Throws AudioExc on failure.
+	static void		ensureInitialized();
+	//! Returns whether PortAudio is currently initialized.
+	static bool		isInitialized();
+};
+
+} } // namespace cinder::audio
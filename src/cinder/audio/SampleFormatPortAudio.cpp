@@ -0,0 +1,410 @@
+/*
+ Copyright (c) 2018, The Cinder Project
+
+ This code is intended to be used with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "cinder/audio/SampleFormatPortAudio.h"
+#include "cinder/CinderAssert.h"
+
+#include "portaudio.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define CI_PORTAUDIO_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace cinder { namespace audio {
+
+size_t getBytesPerSample( SampleFormatPortAudio format )
+{
+	switch( format ) {
+		case SampleFormatPortAudio::FLOAT_32:	return 4;
+		case SampleFormatPortAudio::INT_32:		return 4;
+		case SampleFormatPortAudio::INT_24:		return 3;
+		case SampleFormatPortAudio::INT_16:		return 2;
+		default: CI_ASSERT_NOT_REACHABLE();
+	}
+
+	return 0;
+}
+
+unsigned long toPaSampleFormat( SampleFormatPortAudio format )
+{
+	static_assert( std::is_same<PaSampleFormat, unsigned long>::value, "PaSampleFormat is expected to be an unsigned long" );
+
+	switch( format ) {
+		case SampleFormatPortAudio::FLOAT_32:	return paFloat32;
+		case SampleFormatPortAudio::INT_32:		return paInt32;
+		case SampleFormatPortAudio::INT_24:		return paInt24;
+		case SampleFormatPortAudio::INT_16:		return paInt16;
+		default: CI_ASSERT_NOT_REACHABLE();
+	}
+
+	return paFloat32;
+}
+
+namespace dsp {
+
+namespace {
+
+const float INT16_SCALE = 32767.0f;
+const float INT24_SCALE = 8388607.0f;
+const float INT32_SCALE = 2147483648.0f;
+const float INT32_MAX_FLOAT = 2147483520.0f; // largest float below 2^31
+
+const float INT16_SCALE_INV = 1.0f / 32768.0f;
+const float INT24_SCALE_INV = 1.0f / 8388608.0f;
+const float INT32_SCALE_INV = 1.0f / 2147483648.0f;
+
+inline float clip( float s )
+{
+	return s > 1.0f ? 1.0f : ( s < -1.0f ? -1.0f : s );
+}
+
+inline int16_t floatToInt16( float s )
+{
+	return (int16_t)lrintf( clip( s ) * INT16_SCALE );
+}
+
+inline int32_t floatToInt24( float s )
+{
+	return (int32_t)lrintf( clip( s ) * INT24_SCALE );
+}
+
+inline int32_t floatToInt32( float s )
+{
+	return (int32_t)lrintf( std::min( clip( s ) * INT32_SCALE, INT32_MAX_FLOAT ) );
+}
+
+inline void writeInt24( uint8_t *dest, int32_t s )
+{
+	dest[0] = (uint8_t)( s & 0xFF );
+	dest[1] = (uint8_t)( ( s >> 8 ) & 0xFF );
+	dest[2] = (uint8_t)( ( s >> 16 ) & 0xFF );
+}
+
+// Reads a packed int24 into the upper three bytes of an int32, so that shifting it back down extends the sign
+inline int32_t readInt24Upper( const uint8_t *source )
+{
+	return (int32_t)( ( (uint32_t)source[0] << 8 ) | ( (uint32_t)source[1] << 16 ) | ( (uint32_t)source[2] << 24 ) );
+}
+
+inline float readInt24( const uint8_t *source )
+{
+	return (float)( readInt24Upper( source ) >> 8 ) * INT24_SCALE_INV;
+}
+
+#if defined( CI_PORTAUDIO_SSE2 )
+
+// Clips, scales and rounds (using the default round-to-nearest mode) four floats to int32
+inline __m128i convertToInt32x4( __m128 s, __m128 scale )
+{
+	s = _mm_max_ps( _mm_min_ps( s, _mm_set1_ps( 1.0f ) ), _mm_set1_ps( -1.0f ) );
+	return _mm_cvtps_epi32( _mm_mul_ps( s, scale ) );
+}
+
+inline __m128i convertToInt32x4Full( __m128 s )
+{
+	s = _mm_max_ps( _mm_min_ps( s, _mm_set1_ps( 1.0f ) ), _mm_set1_ps( -1.0f ) );
+	return _mm_cvtps_epi32( _mm_min_ps( _mm_mul_ps( s, _mm_set1_ps( INT32_SCALE ) ), _mm_set1_ps( INT32_MAX_FLOAT ) ) );
+}
+
+// Transposes four rows of four int32s, turning four frames of four channels into four channels of four frames and back
+inline void transposeInt32x4( __m128i rows[4] )
+{
+	__m128 r0 = _mm_castsi128_ps( rows[0] );
+	__m128 r1 = _mm_castsi128_ps( rows[1] );
+	__m128 r2 = _mm_castsi128_ps( rows[2] );
+	__m128 r3 = _mm_castsi128_ps( rows[3] );
+	_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+	rows[0] = _mm_castps_si128( r0 );
+	rows[1] = _mm_castps_si128( r1 );
+	rows[2] = _mm_castps_si128( r2 );
+	rows[3] = _mm_castps_si128( r3 );
+}
+
+#endif
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------------------------------
+// Float to integer
+// ----------------------------------------------------------------------------------------------------
+
+void interleaveToInt16( const float *nonInterleavedSourceArray, int16_t *interleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames )
+{
+	size_t i = 0;
+	size_t vectorChannels = numChannels; // channels converted up to frame i
+
+#if defined( CI_PORTAUDIO_SSE2 )
+	const __m128 scale = _mm_set1_ps( INT16_SCALE );
+	if( numChannels == 1 ) {
+		for( ; i + 8 <= numCopyFrames; i += 8 ) {
+			__m128i a = convertToInt32x4( _mm_loadu_ps( nonInterleavedSourceArray + i ), scale );
+			__m128i b = convertToInt32x4( _mm_loadu_ps( nonInterleavedSourceArray + i + 4 ), scale );
+			_mm_storeu_si128( (__m128i *)( interleavedDestArray + i ), _mm_packs_epi32( a, b ) );
+		}
+	}
+	else if( numChannels == 2 ) {
+		const float *left = nonInterleavedSourceArray;
+		const float *right = nonInterleavedSourceArray + framesPerChannel;
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			__m128i l = convertToInt32x4( _mm_loadu_ps( left + i ), scale );
+			__m128i r = convertToInt32x4( _mm_loadu_ps( right + i ), scale );
+			__m128i lr = _mm_packs_epi32( _mm_unpacklo_epi32( l, r ), _mm_unpackhi_epi32( l, r ) );
+			_mm_storeu_si128( (__m128i *)( interleavedDestArray + i * 2 ), lr );
+		}
+	}
+	else if( numChannels >= 4 ) {
+		// transpose groups of four channels, the remaining channels are converted below
+		vectorChannels = numChannels & ~size_t( 3 );
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			for( size_t ch = 0; ch < vectorChannels; ch += 4 ) {
+				__m128i rows[4];
+				for( size_t k = 0; k < 4; k++ )
+					rows[k] = convertToInt32x4( _mm_loadu_ps( nonInterleavedSourceArray + ( ch + k ) * framesPerChannel + i ), scale );
+				transposeInt32x4( rows );
+				for( size_t k = 0; k < 4; k++ )
+					_mm_storel_epi64( (__m128i *)( interleavedDestArray + ( i + k ) * numChannels + ch ), _mm_packs_epi32( rows[k], rows[k] ) );
+			}
+		}
+	}
+#endif
+
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		const float *source = nonInterleavedSourceArray + ch * framesPerChannel;
+		for( size_t f = ( ch < vectorChannels ? i : 0 ); f < numCopyFrames; f++ )
+			interleavedDestArray[f * numChannels + ch] = floatToInt16( source[f] );
+	}
+}
+
+void interleaveToInt24( const float *nonInterleavedSourceArray, uint8_t *interleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames )
+{
+	size_t i = 0;
+
+#if defined( CI_PORTAUDIO_SSE2 )
+	// vectorize the conversion, then scatter the packed bytes
+	const __m128 scale = _mm_set1_ps( INT24_SCALE );
+	alignas( 16 ) int32_t converted[4];
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		const float *source = nonInterleavedSourceArray + ch * framesPerChannel;
+		uint8_t *dest = interleavedDestArray + ch * 3;
+		for( size_t f = 0; f + 4 <= numCopyFrames; f += 4 ) {
+			_mm_store_si128( (__m128i *)converted, convertToInt32x4( _mm_loadu_ps( source + f ), scale ) );
+			for( size_t k = 0; k < 4; k++ )
+				writeInt24( dest + ( f + k ) * numChannels * 3, converted[k] );
+		}
+	}
+	i = numCopyFrames & ~size_t( 3 );
+#endif
+
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		const float *source = nonInterleavedSourceArray + ch * framesPerChannel;
+		for( size_t f = i; f < numCopyFrames; f++ )
+			writeInt24( interleavedDestArray + ( f * numChannels + ch ) * 3, floatToInt24( source[f] ) );
+	}
+}
+
+void interleaveToInt32( const float *nonInterleavedSourceArray, int32_t *interleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames )
+{
+	size_t i = 0;
+	size_t vectorChannels = numChannels; // channels converted up to frame i
+
+#if defined( CI_PORTAUDIO_SSE2 )
+	if( numChannels == 1 ) {
+		for( ; i + 4 <= numCopyFrames; i += 4 )
+			_mm_storeu_si128( (__m128i *)( interleavedDestArray + i ), convertToInt32x4Full( _mm_loadu_ps( nonInterleavedSourceArray + i ) ) );
+	}
+	else if( numChannels == 2 ) {
+		const float *left = nonInterleavedSourceArray;
+		const float *right = nonInterleavedSourceArray + framesPerChannel;
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			__m128i l = convertToInt32x4Full( _mm_loadu_ps( left + i ) );
+			__m128i r = convertToInt32x4Full( _mm_loadu_ps( right + i ) );
+			_mm_storeu_si128( (__m128i *)( interleavedDestArray + i * 2 ), _mm_unpacklo_epi32( l, r ) );
+			_mm_storeu_si128( (__m128i *)( interleavedDestArray + i * 2 + 4 ), _mm_unpackhi_epi32( l, r ) );
+		}
+	}
+	else if( numChannels >= 4 ) {
+		// transpose groups of four channels, the remaining channels are converted below
+		vectorChannels = numChannels & ~size_t( 3 );
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			for( size_t ch = 0; ch < vectorChannels; ch += 4 ) {
+				__m128i rows[4];
+				for( size_t k = 0; k < 4; k++ )
+					rows[k] = convertToInt32x4Full( _mm_loadu_ps( nonInterleavedSourceArray + ( ch + k ) * framesPerChannel + i ) );
+				transposeInt32x4( rows );
+				for( size_t k = 0; k < 4; k++ )
+					_mm_storeu_si128( (__m128i *)( interleavedDestArray + ( i + k ) * numChannels + ch ), rows[k] );
+			}
+		}
+	}
+#endif
+
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		const float *source = nonInterleavedSourceArray + ch * framesPerChannel;
+		for( size_t f = ( ch < vectorChannels ? i : 0 ); f < numCopyFrames; f++ )
+			interleavedDestArray[f * numChannels + ch] = floatToInt32( source[f] );
+	}
+}
+
+// ----------------------------------------------------------------------------------------------------
+// Integer to float
+// ----------------------------------------------------------------------------------------------------
+
+void deinterleaveFromInt16( const int16_t *interleavedSourceArray, float *nonInterleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames )
+{
+	size_t i = 0;
+	size_t vectorChannels = numChannels; // channels converted up to frame i
+
+#if defined( CI_PORTAUDIO_SSE2 )
+	const __m128 scale = _mm_set1_ps( INT16_SCALE_INV );
+	if( numChannels == 1 ) {
+		for( ; i + 8 <= numCopyFrames; i += 8 ) {
+			__m128i s = _mm_loadu_si128( (const __m128i *)( interleavedSourceArray + i ) );
+			// sign extend by unpacking into the upper half and shifting back down
+			__m128i lo = _mm_srai_epi32( _mm_unpacklo_epi16( s, s ), 16 );
+			__m128i hi = _mm_srai_epi32( _mm_unpackhi_epi16( s, s ), 16 );
+			_mm_storeu_ps( nonInterleavedDestArray + i, _mm_mul_ps( _mm_cvtepi32_ps( lo ), scale ) );
+			_mm_storeu_ps( nonInterleavedDestArray + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( hi ), scale ) );
+		}
+	}
+	else if( numChannels == 2 ) {
+		float *left = nonInterleavedDestArray;
+		float *right = nonInterleavedDestArray + framesPerChannel;
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			__m128i s = _mm_loadu_si128( (const __m128i *)( interleavedSourceArray + i * 2 ) ); // L0 R0 L1 R1 L2 R2 L3 R3
+			__m128i l = _mm_srai_epi32( _mm_slli_epi32( s, 16 ), 16 );
+			__m128i r = _mm_srai_epi32( s, 16 );
+			_mm_storeu_ps( left + i, _mm_mul_ps( _mm_cvtepi32_ps( l ), scale ) );
+			_mm_storeu_ps( right + i, _mm_mul_ps( _mm_cvtepi32_ps( r ), scale ) );
+		}
+	}
+	else if( numChannels >= 4 ) {
+		// transpose groups of four channels, the remaining channels are converted below
+		vectorChannels = numChannels & ~size_t( 3 );
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			for( size_t ch = 0; ch < vectorChannels; ch += 4 ) {
+				__m128i rows[4];
+				for( size_t k = 0; k < 4; k++ ) {
+					__m128i s = _mm_loadl_epi64( (const __m128i *)( interleavedSourceArray + ( i + k ) * numChannels + ch ) );
+					rows[k] = _mm_srai_epi32( _mm_unpacklo_epi16( s, s ), 16 );
+				}
+				transposeInt32x4( rows );
+				for( size_t k = 0; k < 4; k++ )
+					_mm_storeu_ps( nonInterleavedDestArray + ( ch + k ) * framesPerChannel + i, _mm_mul_ps( _mm_cvtepi32_ps( rows[k] ), scale ) );
+			}
+		}
+	}
+#endif
+
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		float *dest = nonInterleavedDestArray + ch * framesPerChannel;
+		for( size_t f = ( ch < vectorChannels ? i : 0 ); f < numCopyFrames; f++ )
+			dest[f] = (float)interleavedSourceArray[f * numChannels + ch] * INT16_SCALE_INV;
+	}
+}
+
+void deinterleaveFromInt24( const uint8_t *interleavedSourceArray, float *nonInterleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames )
+{
+	size_t i = 0;
+	const size_t stride = numChannels * 3;
+
+#if defined( CI_PORTAUDIO_SSE2 )
+	// gather the packed bytes, then vectorize the conversion
+	const __m128 scale = _mm_set1_ps( INT24_SCALE_INV );
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		float *dest = nonInterleavedDestArray + ch * framesPerChannel;
+		const uint8_t *source = interleavedSourceArray + ch * 3;
+		for( size_t f = 0; f + 4 <= numCopyFrames; f += 4 ) {
+			const uint8_t *frame = source + f * stride;
+			__m128i s = _mm_set_epi32( readInt24Upper( frame + 3 * stride ), readInt24Upper( frame + 2 * stride ), readInt24Upper( frame + stride ), readInt24Upper( frame ) );
+			s = _mm_srai_epi32( s, 8 );
+			_mm_storeu_ps( dest + f, _mm_mul_ps( _mm_cvtepi32_ps( s ), scale ) );
+		}
+	}
+	i = numCopyFrames & ~size_t( 3 );
+#endif
+
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		float *dest = nonInterleavedDestArray + ch * framesPerChannel;
+		const uint8_t *source = interleavedSourceArray + ch * 3;
+		for( size_t f = i; f < numCopyFrames; f++ )
+			dest[f] = readInt24( source + f * stride );
+	}
+}
+
+void deinterleaveFromInt32( const int32_t *interleavedSourceArray, float *nonInterleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames )
+{
+	size_t i = 0;
+	size_t vectorChannels = numChannels; // channels converted up to frame i
+
+#if defined( CI_PORTAUDIO_SSE2 )
+	const __m128 scale = _mm_set1_ps( INT32_SCALE_INV );
+	if( numChannels == 1 ) {
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			__m128i s = _mm_loadu_si128( (const __m128i *)( interleavedSourceArray + i ) );
+			_mm_storeu_ps( nonInterleavedDestArray + i, _mm_mul_ps( _mm_cvtepi32_ps( s ), scale ) );
+		}
+	}
+	else if( numChannels == 2 ) {
+		float *left = nonInterleavedDestArray;
+		float *right = nonInterleavedDestArray + framesPerChannel;
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			__m128 a = _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i *)( interleavedSourceArray + i * 2 ) ) );		// L0 R0 L1 R1
+			__m128 b = _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i *)( interleavedSourceArray + i * 2 + 4 ) ) );	// L2 R2 L3 R3
+			_mm_storeu_ps( left + i, _mm_mul_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) ), scale ) );
+			_mm_storeu_ps( right + i, _mm_mul_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) ), scale ) );
+		}
+	}
+	else if( numChannels >= 4 ) {
+		// transpose groups of four channels, the remaining channels are converted below
+		vectorChannels = numChannels & ~size_t( 3 );
+		for( ; i + 4 <= numCopyFrames; i += 4 ) {
+			for( size_t ch = 0; ch < vectorChannels; ch += 4 ) {
+				__m128i rows[4];
+				for( size_t k = 0; k < 4; k++ )
+					rows[k] = _mm_loadu_si128( (const __m128i *)( interleavedSourceArray + ( i + k ) * numChannels + ch ) );
+				transposeInt32x4( rows );
+				for( size_t k = 0; k < 4; k++ )
+					_mm_storeu_ps( nonInterleavedDestArray + ( ch + k ) * framesPerChannel + i, _mm_mul_ps( _mm_cvtepi32_ps( rows[k] ), scale ) );
+			}
+		}
+	}
+#endif
+
+	for( size_t ch = 0; ch < numChannels; ch++ ) {
+		float *dest = nonInterleavedDestArray + ch * framesPerChannel;
+		for( size_t f = ( ch < vectorChannels ? i : 0 ); f < numCopyFrames; f++ )
+			dest[f] = (float)interleavedSourceArray[f * numChannels + ch] * INT32_SCALE_INV;
+	}
+}
+
+} // namespace cinder::audio::dsp
+
+} } // namespace cinder::audio
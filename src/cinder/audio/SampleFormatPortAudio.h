@@ -0,0 +1,67 @@
+/*
+ Copyright (c) 2018, The Cinder Project
+
+ This code is intended to be used with the Cinder C++ library, http://libcinder.org
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include "cinder/Cinder.h"
+
+namespace cinder { namespace audio {
+
+//! Sample formats that PortAudio device streams can be opened with. Integer formats are converted to and from the audio graph's float samples in the same pass that interleaves or de-interleaves them.
+enum class SampleFormatPortAudio {
+	FLOAT_32,
+	INT_32,
+	INT_24,		//!< packed, three bytes per sample
+	INT_16
+};
+
+//! Returns the number of bytes used by one sample of \a format.
+size_t getBytesPerSample( SampleFormatPortAudio format );
+//! Returns the PaSampleFormat flag that corresponds to \a format.
+unsigned long toPaSampleFormat( SampleFormatPortAudio format );
+
+namespace dsp {
+
+// Fused conversion kernels, named and laid out like dsp::interleave() / dsp::deinterleave(). Float samples are clipped to [-1, 1] and rounded to the nearest integer.
+// Passing a numChannels of 1 converts a single contiguous channel, as used for non-interleaved streams.
+// With SSE2, four frames are converted at a time, transposing groups of four channels when there are more than two. Any channels left over are converted one sample at a time,
+// and packed int24 samples are always read and written a byte at a time, only their conversion is vectorized.
+
+//! Converts \a numCopyFrames from each of \a numChannels non-interleaved float channels (each \a framesPerChannel long) to an interleaved int16 array.
+void interleaveToInt16( const float *nonInterleavedSourceArray, int16_t *interleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames );
+//! Converts \a numCopyFrames from each of \a numChannels non-interleaved float channels (each \a framesPerChannel long) to an interleaved, packed int24 array.
+void interleaveToInt24( const float *nonInterleavedSourceArray, uint8_t *interleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames );
+//! Converts \a numCopyFrames from each of \a numChannels non-interleaved float channels (each \a framesPerChannel long) to an interleaved int32 array.
+void interleaveToInt32( const float *nonInterleavedSourceArray, int32_t *interleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames );
+
+//! Converts \a numCopyFrames from an interleaved int16 array with \a numChannels to non-interleaved float channels (each \a framesPerChannel long).
+void deinterleaveFromInt16( const int16_t *interleavedSourceArray, float *nonInterleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames );
+//! Converts \a numCopyFrames from an interleaved, packed int24 array with \a numChannels to non-interleaved float channels (each \a framesPerChannel long).
+void deinterleaveFromInt24( const uint8_t *interleavedSourceArray, float *nonInterleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames );
+//! Converts \a numCopyFrames from an interleaved int32 array with \a numChannels to non-interleaved float channels (each \a framesPerChannel long).
+void deinterleaveFromInt32( const int32_t *interleavedSourceArray, float *nonInterleavedDestArray, size_t framesPerChannel, size_t numChannels, size_t numCopyFrames );
+
+} // namespace cinder::audio::dsp
+
+} } // namespace cinder::audio
@@ -0,0 +1,502 @@
+// Headless benchmark of the Cinder-PortAudio render and capture paths.
+//
+// Runs on PortAudio's file-backed host API (PA_USE_FILE), so it doesn't need audio hardware and gives repeatable numbers on build machines.
+// Each path is measured for every combination of channel count and block size, and the results are written as JSON (default) or CSV:
+//
+//	- render paths time OutputDeviceNodePortAudio's stream callback (graph pull, clip check and writing the host buffer), on a device that runs as fast as possible.
+//	- capture paths time InputDeviceNodePortAudio::process() (Pa_ReadStream(), de-interleaving / sample format conversion, the optional
+//	  dsp::Converter, and the ring buffer write and read), with input and output devices sharing a simulated clock so that capture stays paced.
+//	  With callback capture the ring buffer is written from the input stream's callback, so its duration is added to that of process().
+//
+// Run with --help for options.
+
+#include "cinder/audio/audio.h"
+#include "cinder/audio/ContextPortAudio.h"
+#include "cinder/audio/DeviceManagerPortAudio.h"
+#include "cinder/audio/NodeProfilerPortAudio.h"
+#include "cinder/audio/RuntimePortAudio.h"
+
+#include "portaudio.h"
+#include "pa_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ci;
+using namespace std;
+
+namespace {
+
+const char *OUTPUT_DEVICE_NAME			= "Benchmark Output";			// unpaced, used by the render paths
+const char *PACED_OUTPUT_DEVICE_NAME	= "Benchmark Paced Output";		// shares the input device's clock, used by the capture paths
+const char *INPUT_DEVICE_NAME			= "Benchmark Input";
+const int	MAX_CHANNELS				= 64;
+const size_t RESAMPLE_DEVICE_SAMPLE_RATE = 44100;
+
+enum class Path {
+	RENDER,
+	RENDER_NON_INTERLEAVED,
+	CAPTURE,
+	CAPTURE_NON_INTERLEAVED,
+	CAPTURE_INT16,
+	CAPTURE_RESAMPLE,
+	CAPTURE_CALLBACK
+};
+
+struct PathInfo {
+	Path		mPath;
+	const char*	mName;
+	const char*	mDescription;
+};
+
+const PathInfo PATHS[] = {
+	{ Path::RENDER,						"render",					"renderAudio(), interleaved float32 stream" },
+	{ Path::RENDER_NON_INTERLEAVED,		"render-noninterleaved",	"renderAudio(), non-interleaved float32 stream" },
+	{ Path::CAPTURE,					"capture",					"process() with polled capture, interleaved float32 stream written to the ring buffer without de-interleaving" },
+	{ Path::CAPTURE_NON_INTERLEAVED,	"capture-noninterleaved",	"process() with polled capture, non-interleaved float32 stream" },
+	{ Path::CAPTURE_INT16,				"capture-int16",			"process() with polled capture, interleaved int16 stream converted while de-interleaving" },
+	{ Path::CAPTURE_RESAMPLE,			"capture-resample",			"process() with polled capture, interleaved float32 stream at 44100 Hz resampled by dsp::Converter" },
+	{ Path::CAPTURE_CALLBACK,			"capture-callback",			"process() plus the input stream callback with callback capture, interleaved float32 stream written to the ring buffer by the callback" },
+};
+
+bool isRenderPath( Path path )
+{
+	return path == Path::RENDER || path == Path::RENDER_NON_INTERLEAVED;
+}
+
+struct Options {
+	vector<size_t>		mChannels = { 1, 2, 4, 8, 16, 32, 64 };
+	vector<size_t>		mFrames = { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+	vector<PathInfo>	mPaths = vector<PathInfo>( begin( PATHS ), end( PATHS ) );
+	size_t				mSampleRate = 48000;
+	uint64_t			mWarmupBlocks = 16;
+	uint64_t			mBlocks = 128;
+	double				mClockRate = 4;		// speed of the simulated clock for the capture paths, relative to real time
+	bool				mCsv = false;
+	string				mOutputPath;		// stdout if empty
+};
+
+struct Result {
+	const PathInfo*	mPath = nullptr;
+	size_t			mChannels = 0;
+	size_t			mFrames = 0;
+	uint64_t		mBlocks = 0;
+	double			mAverage = 0;	// seconds per block
+	double			mP99 = 0;		// upper bound of the histogram bucket containing the 99th percentile
+	double			mMax = 0;
+	uint64_t		mXruns = 0;		// output underflows for render paths, input overruns and underruns for capture paths
+	bool			mTimedOut = false;
+};
+
+// ----------------------------------------------------------------------------------------------------
+// Options
+// ----------------------------------------------------------------------------------------------------
+
+void printUsage()
+{
+	cerr << "usage: PortAudioBenchmark [options]\n"
+		 << "  --json                 write results as JSON (default)\n"
+		 << "  --csv                  write results as CSV\n"
+		 << "  --output <path>        write results to a file instead of stdout\n"
+		 << "  --paths <list>         comma separated paths to run, default all:\n";
+	for( const auto &path : PATHS )
+		cerr << "                           " << path.mName << ": " << path.mDescription << "\n";
+	cerr << "  --channels <list>      comma separated channel counts, 1 to " << MAX_CHANNELS << ", default 1,2,4,8,16,32,64\n"
+		 << "  --frames <list>        comma separated frames per block, default 32,64,128,256,512,1024,2048,4096\n"
+		 << "  --blocks <n>           blocks measured per case, default 128\n"
+		 << "  --warmup <n>           blocks run before measuring, default 16\n"
+		 << "  --sample-rate <hz>     default 48000\n"
+		 << "  --clock-rate <x>       speed of the capture paths' clock relative to real time, default 4\n";
+}
+
+vector<string> splitList( const string &list )
+{
+	vector<string> result;
+	stringstream stream( list );
+	string item;
+	while( getline( stream, item, ',' ) ) {
+		if( ! item.empty() )
+			result.push_back( item );
+	}
+
+	return result;
+}
+
+vector<size_t> parseSizeList( const string &list )
+{
+	vector<size_t> result;
+	for( const auto &item : splitList( list ) )
+		result.push_back( (size_t)stoul( item ) );
+
+	return result;
+}
+
+// Returns false if the arguments are invalid or help was requested
+bool parseOptions( int argc, char *argv[], Options *options )
+{
+	try {
+		for( int i = 1; i < argc; i++ ) {
+			string arg = argv[i];
+			auto nextArg = [&]() -> string {
+				if( i + 1 >= argc )
+					throw invalid_argument( "missing value for " + arg );
+				return argv[++i];
+			};
+
+			if( arg == "--json" )
+				options->mCsv = false;
+			else if( arg == "--csv" )
+				options->mCsv = true;
+			else if( arg == "--output" )
+				options->mOutputPath = nextArg();
+			else if( arg == "--channels" )
+				options->mChannels = parseSizeList( nextArg() );
+			else if( arg == "--frames" )
+				options->mFrames = parseSizeList( nextArg() );
+			else if( arg == "--blocks" )
+				options->mBlocks = stoull( nextArg() );
+			else if( arg == "--warmup" )
+				options->mWarmupBlocks = stoull( nextArg() );
+			else if( arg == "--sample-rate" )
+				options->mSampleRate = (size_t)stoul( nextArg() );
+			else if( arg == "--clock-rate" )
+				options->mClockRate = stod( nextArg() );
+			else if( arg == "--paths" ) {
+				options->mPaths.clear();
+				for( const auto &name : splitList( nextArg() ) ) {
+					auto it = find_if( begin( PATHS ), end( PATHS ), [&name]( const PathInfo &path ) { return name == path.mName; } );
+					if( it == end( PATHS ) )
+						throw invalid_argument( "unknown path: " + name );
+					options->mPaths.push_back( *it );
+				}
+			}
+			else if( arg == "--help" || arg == "-h" )
+				return false;
+			else
+				throw invalid_argument( "unknown option: " + arg );
+		}
+	}
+	catch( exception &exc ) {
+		cerr << "error: " << exc.what() << endl;
+		return false;
+	}
+
+	for( size_t numChannels : options->mChannels ) {
+		if( numChannels == 0 || numChannels > MAX_CHANNELS ) {
+			cerr << "error: channel counts must be between 1 and " << MAX_CHANNELS << endl;
+			return false;
+		}
+	}
+	for( size_t numFrames : options->mFrames ) {
+		if( numFrames == 0 ) {
+			cerr << "error: frames per block must be greater than 0" << endl;
+			return false;
+		}
+	}
+	// the profiler is reset after the warmup and takes effect a block later, so measuring must outlast the warmup to tell the two apart
+	if( options->mBlocks <= options->mWarmupBlocks ) {
+		cerr << "error: --blocks must be greater than --warmup" << endl;
+		return false;
+	}
+	if( options->mSampleRate == 0 || options->mClockRate <= 0 ) {
+		cerr << "error: --sample-rate and --clock-rate must be greater than 0" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// Devices
+// ----------------------------------------------------------------------------------------------------
+
+// Must be called before PortAudio is initialized
+void setupFileDevices( const Options &options )
+{
+	PaFileDeviceConfig output, pacedOutput, input;
+	PaFile_InitializeDeviceConfig( &output );
+	output.name = OUTPUT_DEVICE_NAME;
+	output.maxInputChannels = 0;
+	output.maxOutputChannels = MAX_CHANNELS;
+	output.defaultSampleRate = (double)options.mSampleRate;
+	output.clockRate = 0;
+
+	pacedOutput = output;
+	pacedOutput.name = PACED_OUTPUT_DEVICE_NAME;
+	pacedOutput.clockRate = options.mClockRate;
+
+	// no input file, so capture delivers silence. The cost of the capture path doesn't depend on the samples.
+	PaFile_InitializeDeviceConfig( &input );
+	input.name = INPUT_DEVICE_NAME;
+	input.maxInputChannels = MAX_CHANNELS;
+	input.maxOutputChannels = 0;
+	input.defaultSampleRate = (double)options.mSampleRate;
+	input.clockRate = options.mClockRate;
+
+	const PaFileDeviceConfig configs[] = { output, pacedOutput, input };
+	PaError err = PaFile_SetDevices( configs, 3 );
+	if( err != paNoError )
+		throw audio::AudioExc( "PaFile_SetDevices() failed", err );
+
+	// only the file host API is needed, don't probe the machine's audio hardware
+	audio::RuntimePortAudio::setHostApis( { paFile } );
+}
+
+audio::DeviceRef findDevice( const char *name )
+{
+	auto device = audio::Device::findDeviceByName( name );
+	if( ! device )
+		throw audio::AudioExc( string( "could not find device named '" ) + name + "', is PortAudio built with PA_USE_FILE?" );
+
+	return device;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// Measurement
+// ----------------------------------------------------------------------------------------------------
+
+// Polls until predicate returns true, returning false if it doesn't within timeoutSeconds
+bool waitFor( const function<bool()> &predicate, double timeoutSeconds )
+{
+	auto deadline = chrono::steady_clock::now() + chrono::duration<double>( timeoutSeconds );
+	while( ! predicate() ) {
+		if( chrono::steady_clock::now() > deadline )
+			return false;
+
+		this_thread::sleep_for( chrono::milliseconds( 1 ) );
+	}
+
+	return true;
+}
+
+uint64_t getCaptureXruns( audio::ContextPortAudio *ctx )
+{
+	typedef audio::ContextPortAudio::DiagnosticEvent::Type EventType;
+
+	ctx->drainDiagnosticEvents();
+	auto counters = ctx->getDiagnosticCounters();
+	return counters.getCount( EventType::INPUT_OVERRUN ) + counters.getCount( EventType::INPUT_UNDERRUN );
+}
+
+double getTimeoutSeconds( const Options &options, size_t numFrames, double clockRate )
+{
+	// generous, since this only guards against a stalled stream
+	double audioSeconds = (double)( options.mWarmupBlocks + options.mBlocks ) * (double)numFrames / (double)options.mSampleRate;
+	return 10 + ( clockRate > 0 ? 4 * audioSeconds / clockRate : 0 );
+}
+
+// Times OutputDeviceNodePortAudio's stream callback with a sine generator mixed up to all output channels
+Result runRenderCase( const PathInfo &path, size_t numChannels, size_t numFrames, const Options &options )
+{
+	Result result;
+	result.mPath = &path;
+	result.mChannels = numChannels;
+	result.mFrames = numFrames;
+
+	auto device = findDevice( OUTPUT_DEVICE_NAME );
+	device->updateFormat( audio::Device::Format().sampleRate( options.mSampleRate ).framesPerBlock( numFrames ) );
+
+	// a new Context for each case, so that no nodes from the previous case are left observing the device's format changes
+	auto ctx = make_shared<audio::ContextPortAudio>();
+	ctx->enableDiagnosticLogging( false );
+
+	auto output = dynamic_pointer_cast<audio::OutputDeviceNodePortAudio>( ctx->createOutputDeviceNode( device, audio::Node::Format().channels( numChannels ) ) );
+	output->enableNonInterleavedStream( path.mPath == Path::RENDER_NON_INTERLEAVED );
+	ctx->setOutput( output );
+
+	auto gen = ctx->makeNode( new audio::GenSineNode( 440 ) );
+	gen >> output;
+	gen->enable();
+	ctx->enable();
+
+	const double timeout = getTimeoutSeconds( options, numFrames, 0 );
+	result.mTimedOut = ! waitFor( [&] { return output->getStreamTelemetry().mNumCallbacks >= options.mWarmupBlocks; }, timeout );
+	output->resetStreamTelemetry();
+	if( ! result.mTimedOut )
+		result.mTimedOut = ! waitFor( [&] { return output->getStreamTelemetry().mNumCallbacks >= options.mBlocks; }, timeout );
+
+	auto telemetry = output->getStreamTelemetry();
+	ctx->disable();
+
+	result.mBlocks = telemetry.mNumCallbacks;
+	result.mAverage = telemetry.mCallbackDurationAverage;
+	result.mP99 = telemetry.mCallbackDurationP99;
+	result.mMax = telemetry.mCallbackDurationMax;
+	result.mXruns = telemetry.mNumOutputUnderflows;
+	return result;
+}
+
+// Times InputDeviceNodePortAudio::process() with the profiler, while the input is pulled by a paced output device. With callback capture,
+// the input stream's callback durations are added. Blocks are the same size on both sides, so the sums are per block, and the p99 and max are upper bounds.
+Result runCaptureCase( const PathInfo &path, size_t numChannels, size_t numFrames, const Options &options )
+{
+	Result result;
+	result.mPath = &path;
+	result.mChannels = numChannels;
+	result.mFrames = numFrames;
+
+	const size_t inputSampleRate = path.mPath == Path::CAPTURE_RESAMPLE ? RESAMPLE_DEVICE_SAMPLE_RATE : options.mSampleRate;
+	auto outputDevice = findDevice( PACED_OUTPUT_DEVICE_NAME );
+	auto inputDevice = findDevice( INPUT_DEVICE_NAME );
+	outputDevice->updateFormat( audio::Device::Format().sampleRate( options.mSampleRate ).framesPerBlock( numFrames ) );
+	inputDevice->updateFormat( audio::Device::Format().sampleRate( inputSampleRate ).framesPerBlock( numFrames ) );
+
+	auto ctx = make_shared<audio::ContextPortAudio>();
+	ctx->enableDiagnosticLogging( false );
+	ctx->enableNodeProfiling();
+
+	// the output must be set before the input node is initialized, separate devices keep the input off the full duplex path
+	auto output = ctx->createOutputDeviceNode( outputDevice, audio::Node::Format().channels( numChannels ) );
+	ctx->setOutput( output );
+
+	auto input = dynamic_pointer_cast<audio::InputDeviceNodePortAudio>( ctx->createInputDeviceNode( inputDevice, audio::Node::Format().channels( numChannels ) ) );
+	input->enableNonInterleavedStream( path.mPath == Path::CAPTURE_NON_INTERLEAVED );
+	input->enableCallbackCapture( path.mPath == Path::CAPTURE_CALLBACK );
+	if( path.mPath == Path::CAPTURE_INT16 )
+		input->setSampleFormat( audio::SampleFormatPortAudio::INT_16 );
+
+	input >> output;
+	input->enable();
+	ctx->enable();
+
+	// the input node is processed once per profiled block. Its statistics are only gathered at the end, since that walks the graph
+	auto profiler = ctx->getNodeProfiler();
+	const double timeout = getTimeoutSeconds( options, numFrames, options.mClockRate );
+	result.mTimedOut = ! waitFor( [&] { return profiler->getNumBlocks() >= options.mWarmupBlocks; }, timeout );
+	profiler->reset();
+	input->resetStreamTelemetry();
+	uint64_t xrunsBefore = getCaptureXruns( ctx.get() );
+	if( ! result.mTimedOut )
+		result.mTimedOut = ! waitFor( [&] { return profiler->getNumBlocks() >= options.mBlocks; }, timeout );
+
+	auto telemetry = input->getStreamTelemetry();
+	ctx->disable();
+
+	audio::NodeProfilerPortAudio::NodeStats stats;
+	for( const auto &nodeStats : profiler->getTopNodes( audio::NodeProfilerPortAudio::MAX_NODES ) ) {
+		if( nodeStats.mNode == input.get() )
+			stats = nodeStats;
+	}
+
+	result.mBlocks = stats.mNumBlocks;
+	result.mAverage = stats.mAverage;
+	result.mP99 = stats.mP99;
+	result.mMax = stats.mMax;
+	if( input->isCallbackCaptureEnabled() ) {
+		result.mAverage += telemetry.mCallbackDurationAverage;
+		result.mP99 += telemetry.mCallbackDurationP99;
+		result.mMax += telemetry.mCallbackDurationMax;
+	}
+	result.mXruns = getCaptureXruns( ctx.get() ) - xrunsBefore;
+	return result;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// Output
+// ----------------------------------------------------------------------------------------------------
+
+double toNanos( double seconds )
+{
+	return seconds * 1e9;
+}
+
+void writeCsv( ostream &stream, const vector<Result> &results, const Options &options )
+{
+	stream << "path,channels,frames,sample_rate,blocks,ns_per_block_avg,ns_per_block_p99,ns_per_block_max,ns_per_frame_avg,xruns,timed_out\n";
+	for( const auto &result : results ) {
+		stream << result.mPath->mName << "," << result.mChannels << "," << result.mFrames << "," << options.mSampleRate << "," << result.mBlocks << ","
+			<< toNanos( result.mAverage ) << "," << toNanos( result.mP99 ) << "," << toNanos( result.mMax ) << "," << toNanos( result.mAverage ) / (double)result.mFrames << ","
+			<< result.mXruns << "," << ( result.mTimedOut ? "true" : "false" ) << "\n";
+	}
+}
+
+void writeJson( ostream &stream, const vector<Result> &results, const Options &options )
+{
+	stream << "{\n"
+		<< "  \"benchmark\": \"Cinder-PortAudio\",\n"
+		<< "  \"portaudio\": \"" << Pa_GetVersionText() << "\",\n"
+		<< "  \"sample_rate\": " << options.mSampleRate << ",\n"
+		<< "  \"clock_rate\": " << options.mClockRate << ",\n"
+		<< "  \"warmup_blocks\": " << options.mWarmupBlocks << ",\n"
+		<< "  \"paths\": {";
+	for( size_t i = 0; i < options.mPaths.size(); i++ )
+		stream << ( i ? "," : "" ) << "\n    \"" << options.mPaths[i].mName << "\": \"" << options.mPaths[i].mDescription << "\"";
+	stream << "\n  },\n  \"results\": [";
+
+	for( size_t i = 0; i < results.size(); i++ ) {
+		const auto &result = results[i];
+		stream << ( i ? "," : "" ) << "\n    { "
+			<< "\"path\": \"" << result.mPath->mName << "\", "
+			<< "\"channels\": " << result.mChannels << ", "
+			<< "\"frames\": " << result.mFrames << ", "
+			<< "\"blocks\": " << result.mBlocks << ", "
+			<< "\"ns_per_block_avg\": " << toNanos( result.mAverage ) << ", "
+			<< "\"ns_per_block_p99\": " << toNanos( result.mP99 ) << ", "
+			<< "\"ns_per_block_max\": " << toNanos( result.mMax ) << ", "
+			<< "\"ns_per_frame_avg\": " << toNanos( result.mAverage ) / (double)result.mFrames << ", "
+			<< "\"xruns\": " << result.mXruns << ", "
+			<< "\"timed_out\": " << ( result.mTimedOut ? "true" : "false" )
+			<< " }";
+	}
+
+	stream << "\n  ]\n}\n";
+}
+
+} // anonymous namespace
+
+int main( int argc, char *argv[] )
+{
+	Options options;
+	if( ! parseOptions( argc, argv, &options ) ) {
+		printUsage();
+		return 1;
+	}
+
+	vector<Result> results;
+	try {
+		setupFileDevices( options );
+		audio::ContextPortAudio::setAsMaster();
+
+		for( const auto &path : options.mPaths ) {
+			for( size_t numChannels : options.mChannels ) {
+				for( size_t numFrames : options.mFrames ) {
+					cerr << path.mName << ": " << numChannels << " channels, " << numFrames << " frames" << endl;
+
+					Result result = isRenderPath( path.mPath ) ? runRenderCase( path, numChannels, numFrames, options ) : runCaptureCase( path, numChannels, numFrames, options );
+					if( result.mTimedOut )
+						cerr << "\t- timed out after " << result.mBlocks << " blocks" << endl;
+
+					results.push_back( result );
+				}
+			}
+		}
+	}
+	catch( exception &exc ) {
+		cerr << "error: " << exc.what() << endl;
+		return 1;
+	}
+
+	if( options.mOutputPath.empty() ) {
+		options.mCsv ? writeCsv( cout, results, options ) : writeJson( cout, results, options );
+	}
+	else {
+		ofstream stream( options.mOutputPath );
+		if( ! stream ) {
+			cerr << "error: could not open " << options.mOutputPath << endl;
+			return 1;
+		}
+
+		options.mCsv ? writeCsv( stream, results, options ) : writeJson( stream, results, options );
+	}
+
+	auto timedOut = count_if( results.begin(), results.end(), []( const Result &result ) { return result.mTimedOut; } );
+	return timedOut ? 2 : 0;
+}